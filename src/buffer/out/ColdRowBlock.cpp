@@ -0,0 +1,141 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "ColdRowBlock.hpp"
+
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26446) // Prefer to use gsl::at() instead of unchecked subscript operator (bounds.4).
+
+// Appends a copy of the given row to this block.
+// Trailing whitespace is not stored, since ROW::_init() creates it for free when restoring the row.
+void ColdRowBlock::Append(const ROW& row)
+{
+    const auto offsets = row._charOffsets.data();
+
+    // Find the first column from which on all columns are narrow spaces
+    // that are exactly 1 wchar_t long, just like ROW::_init() creates them.
+    auto columns = row._columnCount;
+    for (; columns > 0; --columns)
+    {
+        const auto beg = offsets[columns - 1];
+        const auto end = offsets[columns];
+        if (((beg | end) & ROW::CharOffsetsTrailer) || end - beg != 1 || row._chars[beg] != L' ')
+        {
+            break;
+        }
+    }
+
+    const auto textLength = gsl::narrow_cast<uint16_t>(offsets[columns] & ROW::CharOffsetsMask);
+    // If every column maps to exactly 1 wchar_t, the char-offsets are simply 0,1,2,3,...
+    // and there's no need to store them. This is by far the most common case.
+    const auto hasCharOffsets = textLength != columns ||
+                                std::any_of(offsets, offsets + columns, [](uint16_t o) { return (o & ROW::CharOffsetsTrailer) != 0; });
+
+    const auto& runs = row._attr.runs();
+
+    auto& entry = _entries.emplace_back(Entry{
+        .runsBegin = gsl::narrow<uint32_t>(_runs.size()),
+        .textBegin = gsl::narrow<uint32_t>(_text.size()),
+        .charOffsetsBegin = gsl::narrow<uint32_t>(_charOffsets.size()),
+        .columns = columns,
+        .textLength = textLength,
+        .runCount = gsl::narrow<uint16_t>(runs.size()),
+        .lineRendition = row._lineRendition,
+        .wrapForced = row._wrapForced,
+        .doubleBytePadded = row._doubleBytePadded,
+        .hasCharOffsets = hasCharOffsets,
+    });
+
+    for (const auto& run : runs)
+    {
+        _runs.emplace_back(AttributeRun{ _attributes.Intern(run.value), run.length });
+    }
+
+    _text.insert(_text.end(), row._chars.data(), row._chars.data() + textLength);
+
+    if (entry.hasCharOffsets)
+    {
+        _charOffsets.insert(_charOffsets.end(), offsets, offsets + columns + 1);
+    }
+}
+
+// Restores the row at the given index into `row`. `row` must be just as wide as the row that was
+// given to Append() and it's expected to be freshly constructed (but it doesn't need to be).
+void ColdRowBlock::Restore(size_t index, ROW& row) const
+{
+    const auto& entry = til::at(_entries, index);
+    assert(entry.columns <= row._columnCount);
+
+    const size_t trailingColumns = row._columnCount - entry.columns;
+    const auto length = entry.textLength + trailingColumns;
+
+    if (length > row._chars.size())
+    {
+        row._charsHeap = std::make_unique_for_overwrite<wchar_t[]>(length);
+        row._chars = { row._charsHeap.get(), length };
+    }
+
+    const auto chars = row._chars.data();
+    const auto offsets = row._charOffsets.data();
+
+    memcpy(chars, _text.data() + entry.textBegin, entry.textLength * sizeof(wchar_t));
+    std::fill_n(chars + entry.textLength, trailingColumns, L' ');
+
+    if (entry.hasCharOffsets)
+    {
+        std::copy_n(_charOffsets.data() + entry.charOffsetsBegin, entry.columns + 1, offsets);
+    }
+    else
+    {
+        std::iota(offsets, offsets + entry.columns + 1, uint16_t{ 0 });
+    }
+    std::iota(offsets + entry.columns + 1, offsets + row._columnCount + 1, gsl::narrow_cast<uint16_t>(entry.textLength + 1));
+
+    decltype(row._attr)::container runs;
+    runs.reserve(entry.runCount);
+    for (const auto& run : _runsOf(entry))
+    {
+        runs.emplace_back(_attributes.Get(run.attr), run.length);
+    }
+
+    row._attr = decltype(row._attr){ std::move(runs) };
+    row._lineRendition = entry.lineRendition;
+    row._wrapForced = entry.wrapForced;
+    row._doubleBytePadded = entry.doubleBytePadded;
+}
+
+// Call this once you're done calling Append(), to release the excess capacity of the block.
+void ColdRowBlock::Shrink()
+{
+    _entries.shrink_to_fit();
+    _runs.shrink_to_fit();
+    _attributes.Shrink();
+    _text.shrink_to_fit();
+    _charOffsets.shrink_to_fit();
+}
+
+size_t ColdRowBlock::size() const noexcept
+{
+    return _entries.size();
+}
+
+// Same as ROW::GetHyperlinks(), but without having to restore the row first.
+std::vector<uint16_t> ColdRowBlock::GetHyperlinks(size_t index) const
+{
+    std::vector<uint16_t> ids;
+    for (const auto& run : _runsOf(til::at(_entries, index)))
+    {
+        const auto& attr = _attributes.Get(run.attr);
+        if (attr.IsHyperlink())
+        {
+            ids.emplace_back(attr.GetHyperlinkId());
+        }
+    }
+    return ids;
+}
+
+std::span<const ColdRowBlock::AttributeRun> ColdRowBlock::_runsOf(const Entry& entry) const noexcept
+{
+    return { _runs.data() + entry.runsBegin, entry.runCount };
+}
@@ -0,0 +1,72 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ColdRowBlock.hpp
+
+Abstract:
+- A compact, append-only store for a contiguous group of ROWs.
+- TextBuffer uses it to hold scrollback that is far away from the cursor,
+  so that the memory backing those ROWs can be decommitted.
+
+--*/
+
+#pragma once
+
+#include "Row.hpp"
+#include "TextAttributeTable.hpp"
+
+class ColdRowBlock final
+{
+public:
+    void Append(const ROW& row);
+    void Restore(size_t index, ROW& row) const;
+    void Shrink();
+
+    size_t size() const noexcept;
+    std::vector<uint16_t> GetHyperlinks(size_t index) const;
+
+private:
+    // Same as til::rle_pair<TextAttribute, uint16_t>, but 8 instead of 18 bytes large.
+    struct AttributeRun
+    {
+        TextAttributeTable::Handle attr = 0;
+        uint16_t length = 0;
+    };
+
+    struct Entry
+    {
+        // Offset into _runs at which this row's attribute runs begin.
+        uint32_t runsBegin = 0;
+        // Offset into _text at which this row's text begins.
+        uint32_t textBegin = 0;
+        // Offset into _charOffsets at which this row's char-offsets begin,
+        // if the row contains any text that doesn't map 1:1 to columns.
+        uint32_t charOffsetsBegin = 0;
+        // The amount of columns that were stored, excluding trailing whitespace.
+        uint16_t columns = 0;
+        // The amount of wchar_t that were stored for these columns.
+        uint16_t textLength = 0;
+        // The number of attribute runs of this row.
+        uint16_t runCount = 0;
+        LineRendition lineRendition = LineRendition::SingleWidth;
+        bool wrapForced = false;
+        bool doubleBytePadded = false;
+        bool hasCharOffsets = false;
+    };
+
+    std::span<const AttributeRun> _runsOf(const Entry& entry) const noexcept;
+
+    std::vector<Entry> _entries;
+    // The attribute runs of all rows in this block, back to back.
+    std::vector<AttributeRun> _runs;
+    // The unique attributes of all rows in this block. Rows in the scrollback
+    // usually share just a handful of them, even if they have many runs.
+    TextAttributeTable _attributes;
+    // The text of all rows in this block, back to back, without trailing whitespace.
+    std::vector<wchar_t> _text;
+    // The ROW::_charOffsets of rows that contain wide glyphs or surrogate pairs.
+    // Rows that contain only 1 wchar_t per column don't store anything here.
+    std::vector<uint16_t> _charOffsets;
+};
@@ -0,0 +1,102 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "HyperlinkRefCounts.hpp"
+
+// Forgets all counts. The next Update() recounts all rows.
+void HyperlinkRefCounts::Reset() noexcept
+{
+    _rows = {};
+    _dirty = {};
+    _dirtyRows = {};
+    _counts = {};
+}
+
+// Marks the given row as modified. This is a no-op until the first Update(), since all rows are implicitly dirty until then.
+void HyperlinkRefCounts::Invalidate(size_t row) noexcept
+{
+    if (row < _dirty.size() && !til::at(_dirty, row))
+    {
+        til::at(_dirty, row) = 1;
+        // This never allocates, because Update() reserves room for all rows.
+        _dirtyRows.push_back(row);
+    }
+}
+
+// Recounts the hyperlinks in all dirty rows. getRowHyperlinks returns the IDs in the given row.
+void HyperlinkRefCounts::Update(size_t rowCount, const std::function<std::vector<uint16_t>(size_t)>& getRowHyperlinks)
+{
+    if (_rows.size() != rowCount)
+    {
+        Reset();
+        _rows.resize(rowCount);
+        _dirty.resize(rowCount);
+        _dirtyRows.reserve(rowCount);
+
+        for (size_t row = 0; row < rowCount; ++row)
+        {
+            _addRow(row, getRowHyperlinks(row));
+        }
+        return;
+    }
+
+    for (const auto row : _dirtyRows)
+    {
+        til::at(_dirty, row) = 0;
+        _removeRow(row, nullptr);
+        _addRow(row, getRowHyperlinks(row));
+    }
+    _dirtyRows.clear();
+}
+
+// Removes the references of the given row, which must not be dirty, as if it had been cleared.
+// Returns the IDs that aren't referenced by any row anymore.
+std::vector<uint16_t> HyperlinkRefCounts::Release(size_t row)
+{
+    std::vector<uint16_t> unreferenced;
+    if (row < _rows.size())
+    {
+        _removeRow(row, &unreferenced);
+    }
+    return unreferenced;
+}
+
+void HyperlinkRefCounts::_addRow(size_t row, std::vector<uint16_t> ids)
+{
+    if (ids.empty())
+    {
+        return;
+    }
+
+    // A row contains the same ID multiple times if the hyperlink is interrupted by other attributes.
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    for (const auto id : ids)
+    {
+        _counts[id]++;
+    }
+    til::at(_rows, row) = std::move(ids);
+}
+
+// Removes the row's references. If unreferenced is non-null, the IDs that aren't referenced anymore are appended to it.
+void HyperlinkRefCounts::_removeRow(size_t row, std::vector<uint16_t>* unreferenced)
+{
+    auto& ids = til::at(_rows, row);
+
+    for (const auto id : ids)
+    {
+        const auto it = _counts.find(id);
+        if (it != _counts.end() && --it->second == 0)
+        {
+            _counts.erase(it);
+            if (unreferenced)
+            {
+                unreferenced->emplace_back(id);
+            }
+        }
+    }
+
+    ids.clear();
+}
@@ -0,0 +1,38 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- HyperlinkRefCounts.hpp
+
+Abstract:
+- Counts, for each hyperlink ID, the number of rows in a TextBuffer that refer to it.
+- TextBuffer uses it to decide in O(1) whether the hyperlinks in the row it's about
+  to recycle are still in use anywhere else, instead of scanning the entire buffer.
+- Rows are identified by their offset in the TextBuffer, just like in TrigramIndex.
+  Writing to a row only marks it as dirty. Update() recounts the dirty rows in bulk,
+  which keeps the cost per written row at O(1) amortized.
+
+--*/
+
+#pragma once
+
+class HyperlinkRefCounts final
+{
+public:
+    void Reset() noexcept;
+    void Invalidate(size_t row) noexcept;
+    void Update(size_t rowCount, const std::function<std::vector<uint16_t>(size_t)>& getRowHyperlinks);
+    std::vector<uint16_t> Release(size_t row);
+
+private:
+    void _addRow(size_t row, std::vector<uint16_t> ids);
+    void _removeRow(size_t row, std::vector<uint16_t>* unreferenced);
+
+    // The deduplicated IDs that each row contributed to _counts.
+    std::vector<std::vector<uint16_t>> _rows;
+    // _dirty[row] is 1 if the row is listed in _dirtyRows.
+    std::vector<uint8_t> _dirty;
+    std::vector<size_t> _dirtyRows;
+    std::unordered_map<uint16_t, size_t> _counts;
+};
@@ -5,6 +5,7 @@
 #include "Row.hpp"
 
 #include <isa_availability.h>
+#include <til/hash.h>
 #include <til/unicode.h>
 
 #include "textBuffer.hpp"
@@ -360,6 +361,86 @@ void ROW::_init() noexcept
 #pragma warning(push)
 }
 
+// Returns the number of leading characters in `chars` that are ASCII.
+// This is the fast-path for ReplaceText() and TextBuffer::FitTextIntoColumns(),
+// because ASCII is always 1 char per column and 1 column per char.
+size_t ROW::CountAscii(const std::wstring_view& chars) noexcept
+{
+#pragma warning(push)
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+
+    const auto beg = chars.data();
+    const auto end = beg + chars.size();
+    auto it = beg;
+
+#if defined(TIL_SSE_INTRINSICS)
+    // A character is ASCII if none of the bits in 0xff80 are set. Just like in _init(), the widest
+    // available loop handles the bulk of the text and the SSE2 and plain loops handle the rest.
+    if (__isa_available >= __ISA_AVAILABLE_AVX512)
+    {
+        const auto nonAscii = _mm512_set1_epi16(static_cast<short>(0xff80));
+
+        for (const auto end512 = beg + (chars.size() & ~size_t{ 31 }); it < end512; it += 32)
+        {
+            const auto wch = _mm512_loadu_si512(it);
+            const auto mask = static_cast<unsigned long>(_mm512_test_epi16_mask(wch, nonAscii));
+
+            if (mask)
+            {
+                unsigned long offset;
+                _BitScanForward(&offset, mask);
+                return it + offset - beg;
+            }
+        }
+    }
+    else if (__isa_available >= __ISA_AVAILABLE_AVX2)
+    {
+        const auto nonAscii = _mm256_set1_epi16(static_cast<short>(0xff80));
+
+        for (const auto end256 = beg + (chars.size() & ~size_t{ 15 }); it < end256; it += 16)
+        {
+            const auto wch = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            const auto ascii = _mm256_cmpeq_epi16(_mm256_and_si256(wch, nonAscii), _mm256_setzero_si256());
+            const auto mask = ~static_cast<unsigned long>(_mm256_movemask_epi8(ascii));
+
+            if (mask)
+            {
+                unsigned long offset;
+                _BitScanForward(&offset, mask);
+                return it + offset / 2 - beg;
+            }
+        }
+    }
+
+    {
+        const auto nonAscii = _mm_set1_epi16(static_cast<short>(0xff80));
+
+        for (const auto end128 = beg + (chars.size() & ~size_t{ 7 }); it < end128; it += 8)
+        {
+            const auto wch = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+            const auto ascii = _mm_cmpeq_epi16(_mm_and_si128(wch, nonAscii), _mm_setzero_si128());
+            const auto mask = static_cast<unsigned long>(_mm_movemask_epi8(ascii)) ^ 0xffff;
+
+            if (mask)
+            {
+                unsigned long offset;
+                _BitScanForward(&offset, mask);
+                return it + offset / 2 - beg;
+            }
+        }
+    }
+#endif
+
+#pragma loop(no_vector)
+    for (; it < end && *it < 0x80; ++it)
+    {
+    }
+
+    return it - beg;
+
+#pragma warning(pop)
+}
+
 void ROW::TransferAttributes(const til::small_rle<TextAttribute, uint16_t, 1>& attr, til::CoordType newWidth)
 {
     _attr = attr;
@@ -428,6 +509,24 @@ void ROW::ClearCell(const til::CoordType column)
     ReplaceCharacters(column, 1, space);
 }
 
+// Replaces the text in the columns [columnBegin, columnEnd) with whitespace. The attributes are left as is.
+void ROW::ClearCells(const til::CoordType columnBegin, const til::CoordType columnEnd)
+{
+    static constexpr std::wstring_view spaces{ L"                                " };
+    const auto end = std::min<til::CoordType>(columnEnd, _columnCount);
+    RowWriteState state{
+        .columnLimit = end,
+        .columnEnd = columnBegin,
+    };
+
+    while (state.columnEnd < end)
+    {
+        state.columnBegin = state.columnEnd;
+        state.text = spaces;
+        ReplaceText(state);
+    }
+}
+
 // Routine Description:
 // - writes cell data to the row
 // Arguments:
@@ -551,6 +650,164 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const til::CoordType c
     return it;
 }
 
+// Returns the number of leading CHAR_INFOs that are printable ASCII (0x20-0x7E) without a leading or
+// trailing byte flag, and copies their characters into `text`, which must have room for `count` characters.
+// Writing these with a single ReplaceText() call has the same result as writing them one by one.
+static size_t copySimpleCharInfos(const CHAR_INFO* charInfos, size_t count, wchar_t* text) noexcept
+{
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+
+    size_t i = 0;
+
+#if defined(TIL_SSE_INTRINSICS)
+    // A CHAR_INFO is 4 bytes: the character in the low and the attributes in the high 16 bits.
+    // Subtracting 0x20 from the character makes everything below 0x20 wrap around to >= 0xffe0 and a saturating
+    // subtraction of 0x5e then leaves a 0 only for 0x20-0x7e. The attributes are masked with the DBCS flags instead.
+    // A cell is simple if both of its halves end up as 0.
+    const auto bias = _mm_set1_epi32(0x20);
+    const auto range = _mm_set1_epi32(0x5e);
+    const auto flags = _mm_set1_epi32(static_cast<int>((COMMON_LVB_SBCSDBCS << 16) | 0xffff));
+    const auto lowHalf = _mm_set1_epi32(0xffff);
+    const auto zero = _mm_setzero_si128();
+
+    for (const auto end = count & ~size_t{ 7 }; i < end; i += 8)
+    {
+        const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(charInfos + i));
+        const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(charInfos + i + 4));
+
+        // It doesn't matter if this copies a few non-simple characters, because they'll be ignored.
+        // _mm_packs_epi32 saturates, but only affects characters >= 0x8000 which aren't simple anyway.
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(text + i), _mm_packs_epi32(_mm_and_si128(a, lowHalf), _mm_and_si128(b, lowHalf)));
+
+        const auto ca = _mm_and_si128(_mm_subs_epu16(_mm_sub_epi16(a, bias), range), flags);
+        const auto cb = _mm_and_si128(_mm_subs_epu16(_mm_sub_epi16(b, bias), range), flags);
+        const auto ma = static_cast<unsigned long>(_mm_movemask_epi8(_mm_cmpeq_epi16(ca, zero)));
+        const auto mb = static_cast<unsigned long>(_mm_movemask_epi8(_mm_cmpeq_epi16(cb, zero)));
+        const auto mask = ~(mb << 16 | ma);
+
+        if (mask)
+        {
+            unsigned long offset;
+            _BitScanForward(&offset, mask);
+            return i + offset / 4;
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        const auto& charInfo = charInfos[i];
+        if (static_cast<wchar_t>(charInfo.Char.UnicodeChar - 0x20) > 0x5e || WI_IsAnyFlagSet(charInfo.Attributes, COMMON_LVB_SBCSDBCS))
+        {
+            break;
+        }
+        text[i] = charInfo.Char.UnicodeChar;
+    }
+
+    return i;
+
+#pragma warning(pop)
+}
+
+// Routine Description:
+// - Writes CHAR_INFOs (as given to WriteConsoleOutputW) to the row. The result is identical to calling
+//   WriteCells() with an OutputCellIterator over the same CHAR_INFOs, but it doesn't convert every cell into
+//   an OutputCellView and TextAttribute. Runs of printable ASCII are written with a single ReplaceText() call
+//   and the attributes are applied once per run of identical attributes.
+// Arguments:
+// - charInfos - the cells to write. Each one occupies 1 column.
+// - columnBegin - column in row to start writing at
+// - wrap - change the wrap flag if we hit the end of the row while writing.
+// Return Value:
+// - The number of CHAR_INFOs that were written. Just like WriteCells(), this may be less than the number of
+//   columns that were filled, if the last one received the leading half of a wide glyph that didn't fit.
+size_t ROW::WriteCharInfos(const std::span<const CHAR_INFO> charInfos, const til::CoordType columnBegin, const std::optional<bool> wrap)
+{
+    THROW_HR_IF(E_INVALIDARG, columnBegin < 0 || columnBegin >= size());
+
+    const auto count = std::min<size_t>(charInfos.size(), gsl::narrow_cast<size_t>(_columnCount - columnBegin));
+    std::array<wchar_t, 128> text;
+    size_t consumed = 0;
+    size_t filled = 0;
+
+    while (filled < count)
+    {
+        const auto simple = copySimpleCharInfos(&til::at(charInfos, filled), std::min(count - filled, text.size()), text.data());
+        if (simple)
+        {
+            const auto column = gsl::narrow_cast<til::CoordType>(columnBegin + filled);
+            RowWriteState state{
+                .text = { text.data(), simple },
+                .columnBegin = column,
+                .columnLimit = gsl::narrow_cast<til::CoordType>(column + simple),
+            };
+            ReplaceText(state);
+            filled += simple;
+            consumed = filled;
+            continue;
+        }
+
+        const auto& charInfo = til::at(charInfos, filled);
+        const auto column = gsl::narrow_cast<til::CoordType>(columnBegin + filled);
+        const std::wstring_view glyph{ &charInfo.Char.UnicodeChar, 1 };
+
+        if (WI_IsFlagSet(charInfo.Attributes, COMMON_LVB_LEADING_BYTE))
+        {
+            if (column == _columnCount - 1)
+            {
+                // The wide char doesn't fit. Pad with whitespace and don't consume it,
+                // so that the caller can write it at the start of the next row.
+                ClearCell(column);
+                SetDoubleBytePadded(true);
+                filled++;
+                break;
+            }
+            ReplaceCharacters(column, 2, glyph);
+        }
+        else if (WI_IsFlagSet(charInfo.Attributes, COMMON_LVB_TRAILING_BYTE))
+        {
+            if (column == 0)
+            {
+                ClearCell(column);
+            }
+            else if (filled == 0)
+            {
+                // See WriteCells(): Only a trailing half at the very start of the write is used to restore its glyph.
+                ReplaceCharacters(column - 1, 2, glyph);
+            }
+        }
+        else
+        {
+            ReplaceCharacters(column, 1, glyph);
+        }
+
+        filled++;
+        consumed = filled;
+    }
+
+    // Every filled column gets the attributes of its CHAR_INFO. The lead/trail flags aren't part of TextAttribute.
+    for (size_t beg = 0; beg < filled;)
+    {
+        const auto attributes = static_cast<WORD>(til::at(charInfos, beg).Attributes & ~COMMON_LVB_SBCSDBCS);
+        auto end = beg + 1;
+        while (end < filled && static_cast<WORD>(til::at(charInfos, end).Attributes & ~COMMON_LVB_SBCSDBCS) == attributes)
+        {
+            ++end;
+        }
+        _attr.replace(gsl::narrow_cast<uint16_t>(columnBegin + beg), gsl::narrow_cast<uint16_t>(columnBegin + end), TextAttribute{ attributes });
+        beg = end;
+    }
+
+    if (wrap.has_value() && columnBegin + filled == _columnCount)
+    {
+        SetWrapForced(*wrap);
+    }
+
+    return consumed;
+}
+
 void ROW::SetAttrToEnd(const til::CoordType columnBegin, const TextAttribute attr)
 {
     _attr.replace(_clampedColumnInclusive(columnBegin), _attr.size(), attr);
@@ -658,22 +915,25 @@ catch (...)
     //
     // We can infer the "end" from the amount of columns we're given (colLimit - colBeg),
     // because ASCII is always 1 column wide per character.
-    auto it = chars.begin();
-    const auto end = it + std::min<size_t>(chars.size(), colLimit - colBeg);
+    const auto len = std::min<size_t>(chars.size(), colLimit - colBeg);
+    auto ascii = CountAscii({ chars.data(), len });
     size_t ch = chBeg;
 
-    while (it != end)
+    // A non-ASCII character may join the preceding ASCII character into a single grapheme cluster
+    // (for instance an "e" followed by a combining accent), so we leave that one to the slow-path.
+    if (ascii != 0 && ascii < chars.size() && til::at(chars, ascii) >= 0x80) [[unlikely]]
     {
-        if (*it >= 0x80) [[unlikely]]
-        {
-            _replaceTextUnicode(ch, it);
-            return;
-        }
+        --ascii;
+    }
+
+    iota_n(row._charOffsets.begin() + colEnd, ascii, gsl::narrow_cast<uint16_t>(ch));
+    colEnd = gsl::narrow_cast<uint16_t>(colEnd + ascii);
+    ch += ascii;
 
-        til::at(row._charOffsets, colEnd) = gsl::narrow_cast<uint16_t>(ch);
-        ++colEnd;
-        ++ch;
-        ++it;
+    if (ascii != len) [[unlikely]]
+    {
+        _replaceTextUnicode(ch, chars.begin() + ascii);
+        return;
     }
 
     colEndDirty = colEnd;
@@ -682,37 +942,25 @@ catch (...)
 
 [[msvc::forceinline]] void ROW::WriteHelper::_replaceTextUnicode(size_t ch, std::wstring_view::const_iterator it) noexcept
 {
+    const auto beg = chars.begin();
     const auto end = chars.end();
 
     while (it != end)
     {
-        unsigned int width = 1;
-        auto ptr = &*it;
-        const auto wch = *ptr;
+        size_t width = 1;
         size_t advance = 1;
 
-        ++it;
-
-        // Even in our slow-path we can avoid calling IsGlyphFullWidth if the current character is ASCII.
-        // It also allows us to skip the surrogate pair decoding at the same time.
-        if (wch >= 0x80)
+        // Even in our slow-path we can skip the grapheme cluster segmentation if the current and the next
+        // character are ASCII, because ASCII characters only join with non-ASCII ones. The exception is CR LF,
+        // which just like in the ASCII fast-path takes up 2 cells.
+        if (*it >= 0x80 || (it + 1 != end && it[1] >= 0x80))
         {
-            if (til::is_surrogate(wch))
-            {
-                if (it != end && til::is_leading_surrogate(wch) && til::is_trailing_surrogate(*it))
-                {
-                    advance = 2;
-                    ++it;
-                }
-                else
-                {
-                    ptr = &UNICODE_REPLACEMENT;
-                }
-            }
-
-            width = IsGlyphFullWidth({ ptr, advance }) + 1u;
+            const auto pos = gsl::narrow_cast<size_t>(it - beg);
+            advance = GraphemeClusterNext(chars, pos, width) - pos;
         }
 
+        it += advance;
+
         const auto colEndNew = gsl::narrow_cast<uint16_t>(colEnd + width);
         if (colEndNew > colLimit)
         {
@@ -1072,6 +1320,24 @@ std::wstring_view ROW::GetText() const noexcept
     return { _chars.data(), width };
 }
 
+// Returns a hash of everything that determines how this row is drawn: the text, how it's split into glyphs,
+// the attributes and the line rendition. The Renderer uses it to tell whether a row changed since the last frame.
+size_t ROW::ContentHash() const noexcept
+{
+    til::hasher h;
+    h.write(_chars.data(), size_t{ til::at(_charOffsets, _columnCount) } & CharOffsetsMask);
+    h.write(_charOffsets.data(), size_t{ _columnCount } + 1);
+    for (const auto& run : _attr.runs())
+    {
+        h.write(static_cast<const void*>(&run.value), sizeof(run.value));
+        h.write(run.length);
+    }
+    h.write(_lineRendition);
+    h.write(_wrapForced);
+    h.write(_doubleBytePadded);
+    return h.finalize();
+}
+
 std::wstring_view ROW::GetText(til::CoordType columnBegin, til::CoordType columnEnd) const noexcept
 {
     const til::CoordType columns = _columnCount;
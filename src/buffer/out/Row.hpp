@@ -113,6 +113,8 @@ public:
         return (columns * sizeof(uint16_t) + 16) & ~15;
     }
 
+    static size_t CountAscii(const std::wstring_view& chars) noexcept;
+
     ROW() = default;
     ROW(wchar_t* charsBuffer, uint16_t* charOffsetsBuffer, uint16_t rowWidth, const TextAttribute& fillAttribute);
 
@@ -140,7 +142,9 @@ public:
     til::CoordType AdjustToGlyphEnd(til::CoordType column) const noexcept;
 
     void ClearCell(til::CoordType column);
+    void ClearCells(til::CoordType columnBegin, til::CoordType columnEnd);
     OutputCellIterator WriteCells(OutputCellIterator it, til::CoordType columnBegin, std::optional<bool> wrap = std::nullopt, std::optional<til::CoordType> limitRight = std::nullopt);
+    size_t WriteCharInfos(std::span<const CHAR_INFO> charInfos, til::CoordType columnBegin, std::optional<bool> wrap = std::nullopt);
     void SetAttrToEnd(til::CoordType columnBegin, TextAttribute attr);
     void ReplaceAttributes(til::CoordType beginIndex, til::CoordType endIndex, const TextAttribute& newAttr);
     void ReplaceCharacters(til::CoordType columnBegin, til::CoordType width, const std::wstring_view& chars);
@@ -160,6 +164,7 @@ public:
     DbcsAttribute DbcsAttrAt(til::CoordType column) const noexcept;
     std::wstring_view GetText() const noexcept;
     std::wstring_view GetText(til::CoordType columnBegin, til::CoordType columnEnd) const noexcept;
+    size_t ContentHash() const noexcept;
     til::CoordType GetLeadingColumnAtCharOffset(ptrdiff_t offset) const noexcept;
     til::CoordType GetTrailingColumnAtCharOffset(ptrdiff_t offset) const noexcept;
     DelimiterClass DelimiterClassAt(til::CoordType column, const std::wstring_view& wordDelimiters) const noexcept;
@@ -167,10 +172,72 @@ public:
     auto AttrBegin() const noexcept { return _attr.begin(); }
     auto AttrEnd() const noexcept { return _attr.end(); }
 
+    // Calls func(columnBegin, columnEnd, attr) for each run of attributes that intersects the columns [columnBegin, columnEnd).
+    template<typename F>
+    void ForEachAttributeRun(til::CoordType columnBegin, til::CoordType columnEnd, F&& func) const
+    {
+        const auto end = std::min<til::CoordType>(columnEnd, _columnCount);
+        if (columnBegin >= end)
+        {
+            return;
+        }
+
+        til::CoordType runBeg = 0;
+
+        for (const auto& run : _attr.runs())
+        {
+            const til::CoordType runEnd = runBeg + run.length;
+            if (runEnd > columnBegin)
+            {
+                func(std::max(runBeg, columnBegin), std::min(runEnd, end), run.value);
+            }
+            if (runEnd >= end)
+            {
+                break;
+            }
+            runBeg = runEnd;
+        }
+    }
+
+    // Replaces each attribute in the columns [columnBegin, columnEnd) with func(attr).
+    // func is called once per run of attributes instead of once per column.
+    template<typename F>
+    void TransformAttributes(til::CoordType columnBegin, til::CoordType columnEnd, F&& func)
+    {
+        const auto beg = gsl::narrow_cast<uint16_t>(std::clamp<til::CoordType>(columnBegin, 0, _columnCount));
+        const auto end = gsl::narrow_cast<uint16_t>(std::clamp<til::CoordType>(columnEnd, 0, _columnCount));
+        if (beg >= end)
+        {
+            return;
+        }
+
+        auto slice = _attr.slice(beg, end);
+        auto& runs = slice.runs();
+        size_t count = 0;
+
+        // Runs that end up with the same attributes are joined, just like replace() does at the edges of the slice.
+        for (auto& run : runs)
+        {
+            run.value = func(run.value);
+            if (count != 0 && til::at(runs, count - 1).value == run.value)
+            {
+                til::at(runs, count - 1).length += run.length;
+            }
+            else
+            {
+                til::at(runs, count++) = run;
+            }
+        }
+
+        runs.resize(count);
+        _attr.replace(beg, end, slice);
+    }
+
 #ifdef UNIT_TESTING
     friend constexpr bool operator==(const ROW& a, const ROW& b) noexcept;
     friend class RowTests;
 #endif
+    friend class ColdRowBlock;
 
 private:
     // WriteHelper exists because other forms of abstracting this functionality away (like templates with lambdas)
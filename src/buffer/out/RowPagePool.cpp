@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "RowPagePool.hpp"
+
+namespace
+{
+    struct IdlePages
+    {
+        wil::srwlock lock;
+        // Pairs of page size and pointer. This stays tiny (a handful of distinct sizes
+        // and at most IdleByteLimit bytes), so a linear search is faster than anything else.
+        std::vector<std::pair<size_t, std::byte*>> pages;
+        size_t bytes = 0;
+    };
+
+    // This is intentionally leaked, because TextBuffers may outlive static destruction (for instance the ones owned by
+    // conhost's globals). Any pages still idle at that point are reclaimed by the OS together with the process anyway.
+    IdlePages& idlePages()
+    {
+        static const auto instance = new IdlePages();
+        return *instance;
+    }
+}
+
+// Returns a committed, writable block of memory of the given size. Its contents are unspecified.
+std::byte* RowPagePool::Acquire(size_t size)
+{
+    auto& idle = idlePages();
+
+    {
+        const auto guard = idle.lock.lock_exclusive();
+        // Search from the back to hand out the most recently released (and thus likely still cached) page.
+        for (auto it = idle.pages.rbegin(); it != idle.pages.rend(); ++it)
+        {
+            if (it->first == size)
+            {
+                const auto page = it->second;
+                idle.pages.erase(std::next(it).base());
+                idle.bytes -= size;
+                return page;
+            }
+        }
+    }
+
+    return static_cast<std::byte*>(THROW_LAST_ERROR_IF_NULL(VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE)));
+}
+
+// Returns a page previously handed out by Acquire(). The size must match the one it was acquired with.
+void RowPagePool::Release(std::byte* page, size_t size) noexcept
+{
+    if (!page)
+    {
+        return;
+    }
+
+    auto& idle = idlePages();
+
+    if (size <= IdleByteLimit)
+    {
+        const auto guard = idle.lock.lock_exclusive();
+        if (idle.bytes + size <= IdleByteLimit)
+        {
+            try
+            {
+                idle.pages.emplace_back(size, page);
+                idle.bytes += size;
+                return;
+            }
+            CATCH_LOG();
+        }
+    }
+
+    VirtualFree(page, 0, MEM_RELEASE);
+}
+
@@ -0,0 +1,27 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- RowPagePool.hpp
+
+Abstract:
+- A process-wide pool of committed memory pages for TextBuffer's ROWs.
+- TextBuffer stores its rows in fixed-size pages. Clearing, shrinking or resizing a buffer
+  releases them back into this pool and the next buffer that needs a page of the same size
+  (for instance the alternate screen buffer, or the temporary buffer of a resize) reuses them.
+- Up to IdleByteLimit bytes of idle pages are kept around. Anything beyond that is freed immediately.
+
+--*/
+
+#pragma once
+
+class RowPagePool final
+{
+public:
+    static std::byte* Acquire(size_t size);
+    static void Release(std::byte* page, size_t size) noexcept;
+
+private:
+    static constexpr size_t IdleByteLimit = 16 * 1024 * 1024;
+};
@@ -0,0 +1,264 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "ScrollMarkStore.hpp"
+
+bool ScrollMarkStore::Empty() const noexcept
+{
+    return _marks.empty();
+}
+
+size_t ScrollMarkStore::Size() const noexcept
+{
+    return _marks.size();
+}
+
+std::vector<ScrollMark> ScrollMarkStore::GetAll() const
+{
+    return GetInRange(til::CoordTypeMin, til::CoordTypeMax);
+}
+
+// Returns the marks that start within the rows [rowBeg, rowEnd), sorted by their start position.
+std::vector<ScrollMark> ScrollMarkStore::GetInRange(til::CoordType rowBeg, til::CoordType rowEnd) const
+{
+    std::vector<ScrollMark> marks;
+    const auto beg = _lowerBound(rowBeg);
+    const auto end = _lowerBound(rowEnd);
+
+    if (beg < end)
+    {
+        marks.reserve(gsl::narrow_cast<size_t>(end - beg));
+        for (auto it = beg; it != end; ++it)
+        {
+            marks.emplace_back(_toRelative(*it));
+        }
+    }
+
+    return marks;
+}
+
+// Returns the last mark that starts above the given row.
+std::optional<ScrollMark> ScrollMarkStore::GetPrevious(til::CoordType row) const
+{
+    const auto it = _lowerBound(row);
+    if (it == _marks.begin())
+    {
+        return std::nullopt;
+    }
+    return _toRelative(*(it - 1));
+}
+
+// Returns the first mark that starts below the given row.
+std::optional<ScrollMark> ScrollMarkStore::GetNext(til::CoordType row) const
+{
+    const auto it = _upperBound(row);
+    if (it == _marks.end())
+    {
+        return std::nullopt;
+    }
+    return _toRelative(*it);
+}
+
+// Returns the mark of the active prompt, as started by the last Add(mark, true).
+std::optional<ScrollMark> ScrollMarkStore::GetCurrent() const
+{
+    if (_current == npos)
+    {
+        return std::nullopt;
+    }
+    return _toRelative(til::at(_marks, _current));
+}
+
+// Inserts the mark at its sorted position. This is O(1) for marks that are added below all others, like prompts usually are.
+// If makeCurrent is true, the mark becomes the active prompt, whose end positions the SetCurrent*() functions update.
+void ScrollMarkStore::Add(const ScrollMark& mark, bool makeCurrent)
+{
+    const auto absolute = _toAbsolute(mark);
+    const auto it = std::upper_bound(_marks.begin(), _marks.end(), absolute.start, [](const til::point& start, const ScrollMark& m) {
+        return start < m.start;
+    });
+    const auto index = gsl::narrow_cast<size_t>(it - _marks.begin());
+
+    _marks.insert(it, absolute);
+    _updateMaxHeight(absolute);
+
+    if (_current != npos && _current >= index)
+    {
+        ++_current;
+    }
+    if (makeCurrent)
+    {
+        _current = index;
+    }
+}
+
+void ScrollMarkStore::Clear() noexcept
+{
+    _marks.clear();
+    _origin = 0;
+    _current = npos;
+    _maxHeight = 0;
+}
+
+// Removes all marks that start or end between `start` & `end`, inclusive.
+void ScrollMarkStore::ClearRange(til::point start, til::point end)
+{
+    // Only marks that start at most _maxHeight rows above the range can end inside of it.
+    const auto lo = gsl::narrow_cast<size_t>(_lowerBound(start.y - _maxHeight) - _marks.begin());
+    const auto hi = gsl::narrow_cast<size_t>(_upperBound(end.y) - _marks.begin());
+    auto out = lo;
+
+    for (auto i = lo; i < hi; ++i)
+    {
+        const auto& m = til::at(_marks, i);
+        const til::point markStart{ m.start.x, m.start.y - _origin };
+        const til::point markEnd{ m.end.x, m.end.y - _origin };
+
+        if ((markStart >= start && markStart <= end) || (markEnd >= start && markEnd <= end))
+        {
+            if (_current == i)
+            {
+                _current = npos;
+            }
+            continue;
+        }
+
+        if (_current == i)
+        {
+            _current = out;
+        }
+        if (out != i)
+        {
+            til::at(_marks, out) = std::move(til::at(_marks, i));
+        }
+        ++out;
+    }
+
+    _erase(out, hi);
+}
+
+// Moves all marks down by `delta` rows (up, if negative). This only adjusts the origin.
+void ScrollMarkStore::Scroll(til::CoordType delta)
+{
+    _origin -= delta;
+
+    // The origin grows by 1 for each row that scrolls out of the buffer. Before it could overflow,
+    // we move it back to 0. This is O(n), but happens only every billion rows or so.
+    if (_origin > _rebaseThreshold || _origin < -_rebaseThreshold)
+    {
+        for (auto& mark : _marks)
+        {
+            _offset(mark, -_origin);
+        }
+        _origin = 0;
+    }
+}
+
+// Removes the marks that don't start within the rows [0, height).
+void ScrollMarkStore::Trim(til::CoordType height)
+{
+    const auto beg = gsl::narrow_cast<size_t>(_lowerBound(0) - _marks.begin());
+    const auto end = gsl::narrow_cast<size_t>(_lowerBound(height) - _marks.begin());
+    _erase(end, _marks.size());
+    _erase(0, beg);
+}
+
+void ScrollMarkStore::SetCurrentPromptEnd(til::point pos) noexcept
+{
+    if (_current != npos)
+    {
+        auto& mark = til::at(_marks, _current);
+        mark.end = { pos.x, pos.y + _origin };
+        _updateMaxHeight(mark);
+    }
+}
+
+void ScrollMarkStore::SetCurrentCommandEnd(til::point pos) noexcept
+{
+    if (_current != npos)
+    {
+        til::at(_marks, _current).commandEnd = til::point{ pos.x, pos.y + _origin };
+    }
+}
+
+void ScrollMarkStore::SetCurrentOutputEnd(til::point pos, MarkCategory category) noexcept
+{
+    if (_current != npos)
+    {
+        auto& mark = til::at(_marks, _current);
+        mark.outputEnd = til::point{ pos.x, pos.y + _origin };
+        mark.category = category;
+    }
+}
+
+ScrollMark ScrollMarkStore::_toRelative(ScrollMark mark) const noexcept
+{
+    _offset(mark, -_origin);
+    return mark;
+}
+
+ScrollMark ScrollMarkStore::_toAbsolute(ScrollMark mark) const noexcept
+{
+    _offset(mark, _origin);
+    return mark;
+}
+
+void ScrollMarkStore::_offset(ScrollMark& mark, til::CoordType dy) noexcept
+{
+    mark.start.y += dy;
+    mark.end.y += dy;
+    if (mark.commandEnd)
+    {
+        mark.commandEnd->y += dy;
+    }
+    if (mark.outputEnd)
+    {
+        mark.outputEnd->y += dy;
+    }
+}
+
+void ScrollMarkStore::_updateMaxHeight(const ScrollMark& mark) noexcept
+{
+    _maxHeight = std::max(_maxHeight, mark.end.y - mark.start.y);
+}
+
+// Returns the first mark that starts at or below the given (relative) row.
+std::deque<ScrollMark>::const_iterator ScrollMarkStore::_lowerBound(til::CoordType row) const noexcept
+{
+    return std::lower_bound(_marks.begin(), _marks.end(), row, [this](const ScrollMark& m, til::CoordType y) {
+        return m.start.y - _origin < y;
+    });
+}
+
+// Returns the first mark that starts below the given (relative) row.
+std::deque<ScrollMark>::const_iterator ScrollMarkStore::_upperBound(til::CoordType row) const noexcept
+{
+    return std::upper_bound(_marks.begin(), _marks.end(), row, [this](til::CoordType y, const ScrollMark& m) {
+        return y < m.start.y - _origin;
+    });
+}
+
+// Erases the marks [beg, end) and keeps _current pointing at the same mark.
+void ScrollMarkStore::_erase(size_t beg, size_t end) noexcept
+{
+    if (beg >= end)
+    {
+        return;
+    }
+
+    const auto it = _marks.begin();
+    _marks.erase(it + beg, it + end);
+
+    if (_current != npos)
+    {
+        if (_current >= end)
+        {
+            _current -= end - beg;
+        }
+        else if (_current >= beg)
+        {
+            _current = npos;
+        }
+    }
+}
@@ -0,0 +1,98 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ScrollMarkStore.hpp
+
+Abstract:
+- The shell integration marks of a TextBuffer, sorted by their start position.
+- Marks are stored relative to an absolute row counter instead of the buffer's top row.
+  When the buffer rotates only that counter changes, instead of the y of every mark.
+  This makes scrolling O(1) and lookups by row O(log n), even with thousands of marks.
+- All parameters and return values use the TextBuffer's (relative) coordinates.
+
+--*/
+
+#pragma once
+
+enum class MarkCategory
+{
+    Prompt = 0,
+    Error = 1,
+    Warning = 2,
+    Success = 3,
+    Info = 4
+};
+struct ScrollMark
+{
+    std::optional<til::color> color;
+    til::point start;
+    til::point end; // exclusive
+    std::optional<til::point> commandEnd;
+    std::optional<til::point> outputEnd;
+
+    MarkCategory category{ MarkCategory::Info };
+    // Other things we may want to think about in the future are listed in
+    // GH#11000
+
+    bool HasCommand() const noexcept
+    {
+        return commandEnd.has_value() && *commandEnd != end;
+    }
+    bool HasOutput() const noexcept
+    {
+        return outputEnd.has_value() && *outputEnd != *commandEnd;
+    }
+    std::pair<til::point, til::point> GetExtent() const
+    {
+        til::point realEnd{ til::coalesce_value(outputEnd, commandEnd, end) };
+        return std::make_pair(til::point{ start }, realEnd);
+    }
+};
+
+class ScrollMarkStore final
+{
+public:
+    bool Empty() const noexcept;
+    size_t Size() const noexcept;
+
+    std::vector<ScrollMark> GetAll() const;
+    std::vector<ScrollMark> GetInRange(til::CoordType rowBeg, til::CoordType rowEnd) const;
+    std::optional<ScrollMark> GetPrevious(til::CoordType row) const;
+    std::optional<ScrollMark> GetNext(til::CoordType row) const;
+    std::optional<ScrollMark> GetCurrent() const;
+
+    void Add(const ScrollMark& mark, bool makeCurrent);
+    void Clear() noexcept;
+    void ClearRange(til::point start, til::point end);
+    void Scroll(til::CoordType delta);
+    void Trim(til::CoordType height);
+
+    void SetCurrentPromptEnd(til::point pos) noexcept;
+    void SetCurrentCommandEnd(til::point pos) noexcept;
+    void SetCurrentOutputEnd(til::point pos, MarkCategory category) noexcept;
+
+private:
+    static constexpr size_t npos = SIZE_MAX;
+    // Once the row counter gets this large, all marks are rebased to prevent an overflow.
+    static constexpr til::CoordType _rebaseThreshold = 1 << 30;
+
+    ScrollMark _toRelative(ScrollMark mark) const noexcept;
+    ScrollMark _toAbsolute(ScrollMark mark) const noexcept;
+    static void _offset(ScrollMark& mark, til::CoordType dy) noexcept;
+    void _updateMaxHeight(const ScrollMark& mark) noexcept;
+    std::deque<ScrollMark>::const_iterator _lowerBound(til::CoordType row) const noexcept;
+    std::deque<ScrollMark>::const_iterator _upperBound(til::CoordType row) const noexcept;
+    void _erase(size_t beg, size_t end) noexcept;
+
+    // Sorted by their absolute start position. Marks with the same start are in the order they were added.
+    std::deque<ScrollMark> _marks;
+    // The absolute row of the TextBuffer's row 0.
+    til::CoordType _origin = 0;
+    // The index of the mark that the shell integration sequences update, or npos.
+    size_t _current = npos;
+    // The largest distance between start.y and end.y of any mark.
+    // ClearRange() uses it to find the marks that start before the range, but end in it.
+    til::CoordType _maxHeight = 0;
+};
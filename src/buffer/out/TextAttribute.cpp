@@ -5,6 +5,8 @@
 #include "TextAttribute.hpp"
 #include "../../inc/conattrs.hpp"
 
+#include <til/hash.h>
+
 // Keeping TextColor compact helps us keeping TextAttribute compact,
 // which in turn ensures that our buffer memory usage is low.
 static_assert(sizeof(TextAttribute) == 16);
@@ -435,3 +437,8 @@ void TextAttribute::SetStandardErase() noexcept
     _attrs = CharacterAttributes::Normal;
     _hyperlinkId = 0;
 }
+
+size_t std::hash<TextAttribute>::operator()(const TextAttribute& attr) const noexcept
+{
+    return til::hasher{}.write(static_cast<const void*>(&attr), sizeof(attr)).finalize();
+}
@@ -211,6 +211,13 @@ private:
 #endif
 };
 
+// Hashes the same raw bytes that operator== compares.
+template<>
+struct std::hash<TextAttribute>
+{
+    size_t operator()(const TextAttribute& attr) const noexcept;
+};
+
 enum class TextAttributeBehavior
 {
     Stored, // use contained text attribute
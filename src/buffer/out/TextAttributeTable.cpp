@@ -0,0 +1,44 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "TextAttributeTable.hpp"
+
+// Returns the handle of the given attribute, adding it to the table if it isn't part of it yet.
+TextAttributeTable::Handle TextAttributeTable::Intern(const TextAttribute& attr)
+{
+    // Rebuild the lookup table if Shrink() released it.
+    if (_handles.size() != _attributes.size())
+    {
+        _handles.reserve(_attributes.size());
+        for (size_t i = 0; i < _attributes.size(); ++i)
+        {
+            _handles.emplace(til::at(_attributes, i), gsl::narrow_cast<Handle>(i));
+        }
+    }
+
+    const auto [it, inserted] = _handles.emplace(attr, gsl::narrow<Handle>(_attributes.size()));
+    if (inserted)
+    {
+        _attributes.emplace_back(attr);
+    }
+    return it->second;
+}
+
+const TextAttribute& TextAttributeTable::Get(Handle handle) const
+{
+    return til::at(_attributes, handle);
+}
+
+size_t TextAttributeTable::Size() const noexcept
+{
+    return _attributes.size();
+}
+
+// Call this once you're done calling Intern(), to release the lookup table and the excess capacity.
+// The next call to Intern() (if any) has to rebuild the lookup table.
+void TextAttributeTable::Shrink()
+{
+    _attributes.shrink_to_fit();
+    _handles = {};
+}
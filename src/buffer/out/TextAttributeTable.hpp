@@ -0,0 +1,35 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TextAttributeTable.hpp
+
+Abstract:
+- Interns TextAttributes: each unique attribute is stored once and referred to by a dense 32-bit handle.
+- Storing handles instead of the 16 byte TextAttributes makes runs of attributes a lot smaller,
+  which matters for scrollback written with lots of SGR sequences (colored logs, 24-bit color output, etc.).
+  Two handles of the same table are equal if and only if their attributes are.
+
+--*/
+
+#pragma once
+
+#include "TextAttribute.hpp"
+
+class TextAttributeTable final
+{
+public:
+    using Handle = uint32_t;
+
+    Handle Intern(const TextAttribute& attr);
+    const TextAttribute& Get(Handle handle) const;
+    size_t Size() const noexcept;
+    void Shrink();
+
+private:
+    // Indexed by handle.
+    std::vector<TextAttribute> _attributes;
+    // The inverse of _attributes. Only needed while attributes are being interned.
+    std::unordered_map<TextAttribute, Handle> _handles;
+};
@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "TrigramIndex.hpp"
+
+#include <icu.h>
+
+// Returns the trigrams of the given needle. Returns an empty query if the needle is too
+// short to have any trigrams, in which case the index can't be used to narrow down the search.
+TrigramIndex::Query TrigramIndex::CreateQuery(std::wstring_view needle)
+{
+    Query query;
+    std::vector<char16_t> folded;
+
+    if (!Fold(needle, folded) || folded.size() < 3)
+    {
+        return query;
+    }
+
+    const auto count = std::min<size_t>(folded.size() - 2, 64);
+    query.bits.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        query.bits.emplace_back(_hash(til::at(folded, i), til::at(folded, i + 1), til::at(folded, i + 2)));
+    }
+
+    query.length = folded.size();
+    query.mask = count == 64 ? ~uint64_t{ 0 } : (uint64_t{ 1 } << count) - 1;
+    return query;
+}
+
+// Frees all memory. The index is considered empty until the next Resize().
+void TrigramIndex::Reset() noexcept
+{
+    _entries = {};
+    _folded = {};
+}
+
+// Ensures that the index has rowCount entries. Any existing entries are invalidated if the size changes.
+void TrigramIndex::Resize(size_t rowCount)
+{
+    if (_entries.size() != rowCount)
+    {
+        _entries.clear();
+        _entries.resize(rowCount);
+    }
+}
+
+// Marks the given row as modified. Since the trigrams at the end of a row extend
+// into the next one, this invalidates the preceding row in the circular buffer as well.
+void TrigramIndex::Invalidate(size_t row) noexcept
+{
+    const auto size = _entries.size();
+    if (row < size)
+    {
+        til::at(_entries, row).dirty = true;
+        til::at(_entries, (row + size - 1) % size).dirty = true;
+    }
+}
+
+bool TrigramIndex::IsDirty(size_t row) const noexcept
+{
+    return til::at(_entries, row).dirty;
+}
+
+// Indexes the trigrams in `text`, including the ones that start in `text`
+// and end in `nextText`, which is the text of the succeeding row (if any).
+void TrigramIndex::Update(size_t row, std::wstring_view text, std::wstring_view nextText)
+{
+    auto& entry = til::at(_entries, row);
+    entry.signature = {};
+    entry.dirty = false;
+
+    // Case folding never shrinks text, so only the first 2 code units of the next row (or 3, so that
+    // we don't split a surrogate pair) can contribute to trigrams that start in this row.
+    auto lookahead = nextText.substr(0, 2);
+    if (lookahead.size() == 2 && til::is_leading_surrogate(til::at(lookahead, 1)))
+    {
+        lookahead = nextText.substr(0, 3);
+    }
+
+    const auto ok = Fold(text, _folded);
+    const auto textLength = _folded.size();
+
+    if (!ok || !Fold(lookahead, _folded))
+    {
+        // If we fail to case fold the text we simply treat every trigram as present.
+        entry.signature.fill(~uint64_t{ 0 });
+        entry.length = gsl::narrow_cast<uint32_t>(text.size());
+        _folded.clear();
+        return;
+    }
+
+    entry.length = gsl::narrow_cast<uint32_t>(textLength);
+
+    // Only trigrams that start in this row are indexed. The others belong to the next row.
+    const auto end = std::min(_folded.size(), textLength + 2);
+    for (size_t i = 2; i < end; ++i)
+    {
+        const auto bit = _hash(til::at(_folded, i - 2), til::at(_folded, i - 1), til::at(_folded, i));
+        til::at(entry.signature, bit / 64) |= uint64_t{ 1 } << (bit % 64);
+    }
+
+    _folded.clear();
+}
+
+// Returns a bitmask of the query's trigrams that may be present in the given row.
+uint64_t TrigramIndex::Match(size_t row, const Query& query) const noexcept
+{
+    const auto& signature = til::at(_entries, row).signature;
+    uint64_t found = 0;
+    uint64_t bit = 1;
+
+    for (const auto b : query.bits)
+    {
+        if (til::at(signature, b / 64) & (uint64_t{ 1 } << (b % 64)))
+        {
+            found |= bit;
+        }
+        bit <<= 1;
+    }
+
+    return found;
+}
+
+// Returns the length of the row's case folded text.
+size_t TrigramIndex::FoldedLength(size_t row) const noexcept
+{
+    return til::at(_entries, row).length;
+}
+
+uint16_t TrigramIndex::_hash(char16_t a, char16_t b, char16_t c) noexcept
+{
+    const auto h = (a * 0x9E3779B1u) ^ (b * 0x85EBCA77u) ^ (c * 0xC2B2AE3Du);
+    return gsl::narrow_cast<uint16_t>(h >> SignatureShift);
+}
+
+// Appends the full case folding of `text` to `folded`. This matches what
+// ICU's case insensitive search compares. Returns false if ICU failed.
+bool TrigramIndex::Fold(std::wstring_view text, std::vector<char16_t>& folded)
+{
+    if (text.empty())
+    {
+        return true;
+    }
+
+    const auto beg = folded.size();
+    const auto capacity = text.size() * 3;
+    folded.resize(beg + capacity);
+
+    UErrorCode status = U_ZERO_ERROR;
+#pragma warning(suppress : 26490) // Don't use reinterpret_cast (type.1).
+    const auto length = u_strFoldCase(folded.data() + beg, gsl::narrow<int32_t>(capacity), reinterpret_cast<const char16_t*>(text.data()), gsl::narrow<int32_t>(text.size()), U_FOLD_CASE_DEFAULT, &status);
+
+    if (U_FAILURE(status))
+    {
+        folded.resize(beg);
+        return false;
+    }
+
+    folded.resize(beg + gsl::narrow_cast<size_t>(length));
+    return true;
+}
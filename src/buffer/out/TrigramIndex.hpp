@@ -0,0 +1,61 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TrigramIndex.hpp
+
+Abstract:
+- A per-row index of the case folded trigrams in a TextBuffer.
+- TextBuffer::SearchText() uses it to skip rows that can't possibly contain a match.
+- Rows are identified by their offset in the TextBuffer's memory arena, not by their
+  y coordinate, so that IncrementCircularBuffer() only needs to invalidate a single row.
+
+--*/
+
+#pragma once
+
+class TrigramIndex final
+{
+public:
+    // The trigrams of a search needle, as passed to Match().
+    struct Query
+    {
+        // The signature bit of each trigram, up to 64 of them.
+        std::vector<uint16_t> bits;
+        // A match can't span more rows than it takes to fit this many (case folded) characters.
+        size_t length = 0;
+        // A bit for each entry in `bits`. Match() returns this if all trigrams were found.
+        uint64_t mask = 0;
+    };
+
+    static Query CreateQuery(std::wstring_view needle);
+    static bool Fold(std::wstring_view text, std::vector<char16_t>& folded);
+
+    void Reset() noexcept;
+    void Resize(size_t rowCount);
+    void Invalidate(size_t row) noexcept;
+    bool IsDirty(size_t row) const noexcept;
+    void Update(size_t row, std::wstring_view text, std::wstring_view nextText);
+
+    uint64_t Match(size_t row, const Query& query) const noexcept;
+    size_t FoldedLength(size_t row) const noexcept;
+
+private:
+    // 512 bits per row keep the false positive rate of a single
+    // trigram well below 25% even for rows 120 columns wide.
+    static constexpr size_t SignatureWords = 8;
+    static constexpr uint32_t SignatureShift = 32 - 9;
+
+    struct Entry
+    {
+        std::array<uint64_t, SignatureWords> signature{};
+        uint32_t length = 0;
+        bool dirty = true;
+    };
+
+    static uint16_t _hash(char16_t a, char16_t b, char16_t c) noexcept;
+
+    std::vector<Entry> _entries;
+    std::vector<char16_t> _folded;
+};
@@ -27,6 +27,17 @@ constexpr til::CoordType& accessCurrentRow(UText* ut) noexcept
     return ut->b;
 }
 
+// Returns the given row through the TextBufferRowReader if the UText has one, and from the TextBuffer otherwise.
+static const ROW& accessRow(UText* ut, til::CoordType y)
+{
+    if (ut->q)
+    {
+#pragma warning(suppress : 26492) // Don't use const_cast to cast away const or volatile (type.3).
+        return static_cast<TextBufferRowReader*>(const_cast<void*>(ut->q))->GetRow(y);
+    }
+    return static_cast<const TextBuffer*>(ut->context)->GetRowByOffset(y);
+}
+
 // An excerpt from the ICU documentation:
 //
 // Clone a UText. Much like opening a UText where the source text is itself another UText.
@@ -77,12 +88,11 @@ try
 
     if (!length)
     {
-        const auto& textBuffer = *static_cast<const TextBuffer*>(ut->context);
         const auto range = accessRowRange(ut);
 
         for (til::CoordType y = range.begin; y < range.end; ++y)
         {
-            length += textBuffer.GetRowByOffset(y).GetText().size();
+            length += accessRow(ut, y).GetText().size();
         }
 
         accessLength(ut) = length;
@@ -122,7 +132,6 @@ try
         neededIndex--;
     }
 
-    const auto& textBuffer = *static_cast<const TextBuffer*>(ut->context);
     const auto range = accessRowRange(ut);
     auto start = ut->chunkNativeStart;
     auto limit = ut->chunkNativeLimit;
@@ -141,7 +150,7 @@ try
                     return false;
                 }
 
-                text = textBuffer.GetRowByOffset(y).GetText();
+                text = accessRow(ut, y).GetText();
                 limit = start;
                 start -= text.size();
             } while (neededIndex < start);
@@ -156,7 +165,7 @@ try
                     return false;
                 }
 
-                text = textBuffer.GetRowByOffset(y).GetText();
+                text = accessRow(ut, y).GetText();
                 start = limit;
                 limit += text.size();
             } while (neededIndex >= limit);
@@ -232,10 +241,9 @@ try
         return gsl::narrow_cast<int32_t>(nativeLimit - nativeStart);
     }
 
-    const auto& textBuffer = *static_cast<const TextBuffer*>(ut->context);
     const auto y = accessCurrentRow(ut);
     const auto offset = ut->chunkNativeStart - nativeStart;
-    const auto text = textBuffer.GetRowByOffset(y).GetText().substr(gsl::narrow_cast<size_t>(std::max<int64_t>(0, offset)));
+    const auto text = accessRow(ut, y).GetText().substr(gsl::narrow_cast<size_t>(std::max<int64_t>(0, offset)));
     const auto destCapacitySizeT = gsl::narrow_cast<size_t>(destCapacity);
     const auto length = std::min(destCapacitySizeT, text.size());
 
@@ -263,14 +271,19 @@ static constexpr UTextFuncs utextFuncs{
     .access = utextAccess,
 };
 
-// Creates a UText from the given TextBuffer that spans rows [rowBeg,RowEnd).
-UText Microsoft::Console::ICU::UTextFromTextBuffer(const TextBuffer& textBuffer, til::CoordType rowBeg, til::CoordType rowEnd) noexcept
+static UText createUText(const TextBuffer& textBuffer, TextBufferRowReader* reader, til::CoordType rowBeg, til::CoordType rowEnd) noexcept
 {
 #pragma warning(suppress : 26477) // Use 'nullptr' rather than 0 or NULL (es.47).
     UText ut = UTEXT_INITIALIZER;
-    ut.providerProperties = (1 << UTEXT_PROVIDER_LENGTH_IS_EXPENSIVE) | (1 << UTEXT_PROVIDER_STABLE_CHUNKS);
+    ut.providerProperties = 1 << UTEXT_PROVIDER_LENGTH_IS_EXPENSIVE;
+    // Rows read through a TextBufferRowReader may be restored into a scratch row that gets reused later.
+    if (!reader)
+    {
+        ut.providerProperties |= 1 << UTEXT_PROVIDER_STABLE_CHUNKS;
+    }
     ut.pFuncs = &utextFuncs;
     ut.context = &textBuffer;
+    ut.q = reader;
     accessCurrentRow(&ut) = rowBeg - 1; // the utextAccess() below will advance this by 1.
     accessRowRange(&ut) = { rowBeg, rowEnd };
 
@@ -278,6 +291,18 @@ UText Microsoft::Console::ICU::UTextFromTextBuffer(const TextBuffer& textBuffer,
     return ut;
 }
 
+// Creates a UText from the given TextBuffer that spans rows [rowBeg,RowEnd).
+UText Microsoft::Console::ICU::UTextFromTextBuffer(const TextBuffer& textBuffer, til::CoordType rowBeg, til::CoordType rowEnd) noexcept
+{
+    return createUText(textBuffer, nullptr, rowBeg, rowEnd);
+}
+
+// Same as above, but the rows are read through the given reader, which doesn't modify the TextBuffer.
+UText Microsoft::Console::ICU::UTextFromTextBuffer(TextBufferRowReader& reader, til::CoordType rowBeg, til::CoordType rowEnd) noexcept
+{
+    return createUText(reader.GetBuffer(), &reader, rowBeg, rowEnd);
+}
+
 Microsoft::Console::ICU::unique_uregex Microsoft::Console::ICU::CreateRegex(const std::wstring_view& pattern, uint32_t flags, UErrorCode* status) noexcept
 {
 #pragma warning(suppress : 26490) // Don't use reinterpret_cast (type.1).
@@ -300,13 +325,12 @@ til::point_span Microsoft::Console::ICU::BufferRangeFromMatch(UText* ut, URegula
     // The parameters are given as a half-open [beg,end) range, but the point_span we return in closed [beg,end].
     nativeIndexEnd--;
 
-    const auto& textBuffer = *static_cast<const TextBuffer*>(ut->context);
     til::point_span ret;
 
     if (utextAccess(ut, nativeIndexBeg, true))
     {
         const auto y = accessCurrentRow(ut);
-        ret.start.x = textBuffer.GetRowByOffset(y).GetLeadingColumnAtCharOffset(ut->chunkOffset);
+        ret.start.x = accessRow(ut, y).GetLeadingColumnAtCharOffset(ut->chunkOffset);
         ret.start.y = y;
     }
     else
@@ -317,7 +341,7 @@ til::point_span Microsoft::Console::ICU::BufferRangeFromMatch(UText* ut, URegula
     if (utextAccess(ut, nativeIndexEnd, true))
     {
         const auto y = accessCurrentRow(ut);
-        ret.end.x = textBuffer.GetRowByOffset(y).GetTrailingColumnAtCharOffset(ut->chunkOffset);
+        ret.end.x = accessRow(ut, y).GetTrailingColumnAtCharOffset(ut->chunkOffset);
         ret.end.y = y;
     }
     else
@@ -8,6 +8,7 @@
 #include <til/hash.h>
 #include <til/unicode.h>
 
+#include "RowPagePool.hpp"
 #include "UTextAdapter.h"
 #include "../../types/inc/GlyphWidth.hpp"
 #include "../renderer/base/renderer.hpp"
@@ -33,6 +34,11 @@ constexpr bool allWhitespace(const std::wstring_view& text) noexcept
 
 static std::atomic<uint64_t> s_lastMutationIdInitialValue;
 
+// SearchText() splits row ranges at least twice this size into chunks of this size and searches them in parallel.
+static constexpr til::CoordType s_parallelSearchChunkRows = 4096;
+// GenHTML() and GenRTF() format selections of at least twice this many rows in chunks of this size in parallel.
+static constexpr size_t s_parallelFormatChunkRows = 1024;
+
 // Routine Description:
 // - Creates a new instance of TextBuffer
 // Arguments:
@@ -65,9 +71,11 @@ TextBuffer::TextBuffer(til::size screenBufferSize,
 
 TextBuffer::~TextBuffer()
 {
-    if (_buffer)
+    _destroy();
+    if (_scratchpad)
     {
-        _destroy();
+        std::destroy_at(&_getScratchpadRow());
+        RowPagePool::Release(_scratchpad, _bufferRowStride);
     }
 }
 
@@ -79,8 +87,8 @@ TextBuffer::~TextBuffer()
 #pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
 #pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
 
-// MEM_RESERVEs memory sufficient to store height-many ROW structs,
-// as well as their ROW::_chars and ROW::_charOffsets buffers.
+// Sets up the page directory for height-many ROW structs, as well as their ROW::_chars
+// and ROW::_charOffsets buffers. The pages themselves are only allocated once they're accessed.
 //
 // We use explicit virtual memory allocations to not taint the general purpose allocator
 // with our huge allocation, as well as to be able to reduce the private working set of
@@ -97,95 +105,152 @@ void TextBuffer::_reserve(til::size screenBufferSize, const TextAttribute& defau
     const auto rowStride = rowSize + charsBufferSize + charOffsetsBufferSize;
     assert(rowStride % alignof(ROW) == 0);
 
-    // 65535*65535 cells would result in a allocSize of 8GiB.
-    // --> Use uint64_t so that we can safely do our calculations even on x86.
-    // We allocate 1 additional row, which will be used for GetScratchpadRow().
-    const auto rowCount = ::base::strict_cast<uint64_t>(h) + 1;
-    const auto allocSize = gsl::narrow<size_t>(rowCount * rowStride);
-
-    // NOTE: Modifications to this block of code might have to be mirrored over to ResizeTraditional().
-    // It constructs a temporary TextBuffer and then extracts the members below, overwriting itself.
-    _buffer = wil::unique_virtualalloc_ptr<std::byte>{
-        static_cast<std::byte*>(THROW_LAST_ERROR_IF_NULL(VirtualAlloc(nullptr, allocSize, MEM_RESERVE, PAGE_READWRITE)))
-    };
-    _bufferEnd = _buffer.get() + allocSize;
-    _commitWatermark = _buffer.get();
+    // NOTE: Modifications to this block of code might have to be mirrored over to _swapStorage().
+    // ResizeTraditional() constructs a temporary TextBuffer and then swaps the members below with its own.
+    _pages.assign((size_t{ h } + _pageRowCount - 1) / _pageRowCount, nullptr);
+    _committedPages = 0;
+    _pageSize = std::min<size_t>(h, _pageRowCount) * rowStride;
     _initialAttributes = defaultAttributes;
     _bufferRowStride = rowStride;
     _bufferOffsetChars = rowSize;
     _bufferOffsetCharOffsets = rowSize + charsBufferSize;
     _width = w;
     _height = h;
+
+    // This is the last step, because the destructor doesn't run if the constructor throws.
+    _scratchpad = RowPagePool::Acquire(rowStride);
+    _construct(_scratchpad, 1, _initialAttributes);
 }
 
-// MEM_COMMITs the memory and constructs all ROWs up to and including the given row pointer.
+// Acquires and constructs all pages up to and including the given one, or restores the page if it's frozen.
 // It's expected that the caller verifies the parameter. It goes hand in hand with _getRowByOffsetDirect().
 //
 // Declaring this function as noinline allows _getRowByOffsetDirect() to be inlined,
 // which improves overall TextBuffer performance by ~6%. And all it cost is this annotation.
 // The compiler doesn't understand the likelihood of our branches. (PGO does, but that's imperfect.)
-__declspec(noinline) void TextBuffer::_commit(const std::byte* row)
+__declspec(noinline) std::byte* TextBuffer::_commit(size_t page)
 {
-    assert(row >= _commitWatermark);
-
-    const auto rowEnd = row + _bufferRowStride;
-    const auto remaining = gsl::narrow_cast<uintptr_t>(_bufferEnd - _commitWatermark);
-    const auto minimum = gsl::narrow_cast<uintptr_t>(rowEnd - _commitWatermark);
-    const auto ideal = minimum + _bufferRowStride * _commitReadAheadRowCount;
-    const auto size = std::min(remaining, ideal);
-
-    THROW_LAST_ERROR_IF_NULL(VirtualAlloc(_commitWatermark, size, MEM_COMMIT, PAGE_READWRITE));
+    if (page < _committedPages)
+    {
+        _thawChunk(page);
+    }
+    else
+    {
+        for (; _committedPages <= page; ++_committedPages)
+        {
+            const auto mem = RowPagePool::Acquire(_pageSize);
+            _construct(mem, _getPageRowCount(_committedPages), _initialAttributes);
+            til::at(_pages, _committedPages) = mem;
+        }
+    }
 
-    _construct(_commitWatermark + size);
+    return til::at(_pages, page);
 }
 
-// Destructs and MEM_DECOMMITs all previously constructed ROWs.
+// Destructs all previously constructed ROWs and returns their pages to the pool.
 // You can use this (or rather the Reset() method) to fully clear the TextBuffer.
 void TextBuffer::_decommit() noexcept
 {
     _destroy();
-    VirtualFree(_buffer.get(), 0, MEM_DECOMMIT);
-    _commitWatermark = _buffer.get();
+    _resetColdScrollback();
+    _pendingReflow.reset();
+    _searchIndex.Reset();
+    _hyperlinkRefCounts.Reset();
 }
 
-// Constructs ROWs between [_commitWatermark,until).
-void TextBuffer::_construct(const std::byte* until) noexcept
+// Constructs the first rowCount ROWs in the given page.
+void TextBuffer::_construct(std::byte* page, size_t rowCount, const TextAttribute& attributes) const noexcept
 {
-    for (; _commitWatermark < until; _commitWatermark += _bufferRowStride)
+    for (auto it = page, end = page + rowCount * _bufferRowStride; it < end; it += _bufferRowStride)
     {
-        const auto row = reinterpret_cast<ROW*>(_commitWatermark);
-        const auto chars = reinterpret_cast<wchar_t*>(_commitWatermark + _bufferOffsetChars);
-        const auto indices = reinterpret_cast<uint16_t*>(_commitWatermark + _bufferOffsetCharOffsets);
-        std::construct_at(row, chars, indices, _width, _initialAttributes);
+        const auto row = reinterpret_cast<ROW*>(it);
+        const auto chars = reinterpret_cast<wchar_t*>(it + _bufferOffsetChars);
+        const auto indices = reinterpret_cast<uint16_t*>(it + _bufferOffsetCharOffsets);
+        std::construct_at(row, chars, indices, _width, attributes);
     }
 }
 
-// Destructs ROWs between [_buffer,_commitWatermark).
-void TextBuffer::_destroy() const noexcept
+// Destructs the ROWs in all committed pages starting at firstPage and returns them to the pool.
+// Frozen pages have been returned already, but their ColdRowBlock is discarded.
+void TextBuffer::_destroy(size_t firstPage) noexcept
 {
-    for (auto it = _buffer.get(); it < _commitWatermark; it += _bufferRowStride)
+    for (auto page = firstPage; page < _committedPages; ++page)
     {
-        std::destroy_at(reinterpret_cast<ROW*>(it));
+        auto& mem = til::at(_pages, page);
+        if (!mem)
+        {
+            if (_frozenChunkCount != 0 && til::at(_coldChunks, page))
+            {
+                til::at(_coldChunks, page).reset();
+                _frozenChunkCount--;
+            }
+            continue;
+        }
+
+        const auto end = mem + _getPageRowCount(page) * _bufferRowStride;
+        for (auto it = mem; it < end; it += _bufferRowStride)
+        {
+            std::destroy_at(reinterpret_cast<ROW*>(it));
+        }
+
+        RowPagePool::Release(std::exchange(mem, nullptr), _pageSize);
     }
+
+    _committedPages = std::min(_committedPages, firstPage);
+}
+
+// Swaps the storage of the two buffers, including the geometry it was allocated with,
+// so that either buffer can properly destroy the storage it ends up with.
+// NOTE: Keep this in sync with _reserve().
+void TextBuffer::_swapStorage(TextBuffer& other) noexcept
+{
+    std::swap(_pages, other._pages);
+    std::swap(_committedPages, other._committedPages);
+    std::swap(_pageSize, other._pageSize);
+    std::swap(_scratchpad, other._scratchpad);
+    std::swap(_initialAttributes, other._initialAttributes);
+    std::swap(_bufferRowStride, other._bufferRowStride);
+    std::swap(_bufferOffsetChars, other._bufferOffsetChars);
+    std::swap(_bufferOffsetCharOffsets, other._bufferOffsetCharOffsets);
+    std::swap(_width, other._width);
+    std::swap(_height, other._height);
+}
+
+// Returns the number of ROWs stored in the given page.
+size_t TextBuffer::_getPageRowCount(size_t page) const noexcept
+{
+    return std::min(_pageRowCount, size_t{ _height } - page * _pageRowCount);
 }
 
 // This function is "direct" because it trusts the caller to properly
 // wrap the "offset" parameter modulo the _height of the buffer.
 ROW& TextBuffer::_getRowByOffsetDirect(size_t offset)
 {
-    const auto row = _buffer.get() + _bufferRowStride * offset;
-    THROW_HR_IF(E_UNEXPECTED, row < _buffer.get() || row >= _bufferEnd);
+    // Offset 0 is the scratchpad row, which is not part of the page directory. This check
+    // rejects it, because the unsigned subtraction turns it into a huge number.
+    const auto index = offset - 1;
+    THROW_HR_IF(E_UNEXPECTED, index >= _height);
+
+    const auto page = index / _pageRowCount;
+    auto mem = til::at(_pages, page);
 
-    if (row >= _commitWatermark)
+    if (!mem) [[unlikely]]
     {
-        _commit(row);
+        mem = _commit(page);
     }
 
-    return *reinterpret_cast<ROW*>(row);
+    return *reinterpret_cast<ROW*>(mem + (index % _pageRowCount) * _bufferRowStride);
 }
 
 // See GetRowByOffset().
 ROW& TextBuffer::_getRow(til::CoordType y) const
+{
+#pragma warning(suppress : 26492) // Don't use const_cast to cast away const or volatile (type.3).
+    return const_cast<TextBuffer*>(this)->_getRowByOffsetDirect(_getRowOffset(y));
+}
+
+// Returns the offset of the given row in the memory arena, as accepted by _getRowByOffsetDirect().
+size_t TextBuffer::_getRowOffset(til::CoordType y) const noexcept
 {
     // Rows are stored circularly, so the index you ask for is offset by the start position and mod the total of rows.
     auto offset = (_firstRow + y) % _height;
@@ -199,8 +264,7 @@ ROW& TextBuffer::_getRow(til::CoordType y) const
 
     // We add 1 to the row offset, because row "0" is the one returned by GetScratchpadRow().
     // See GetScratchpadRow() for more explanation.
-#pragma warning(suppress : 26492) // Don't use const_cast to cast away const or volatile (type.3).
-    return const_cast<TextBuffer*>(this)->_getRowByOffsetDirect(gsl::narrow_cast<size_t>(offset) + 1);
+    return gsl::narrow_cast<size_t>(offset) + 1;
 }
 
 // Returns the "user-visible" index of the last committed row, which can be used
@@ -208,18 +272,18 @@ ROW& TextBuffer::_getRow(til::CoordType y) const
 // Returns 0 if no rows are committed in.
 til::CoordType TextBuffer::_estimateOffsetOfLastCommittedRow() const noexcept
 {
-    const auto lastRowOffset = (_commitWatermark - _buffer.get()) / _bufferRowStride;
-    // This subtracts 2 from the offset to account for the:
-    // * scratchpad row at offset 0, whereas regular rows start at offset 1.
-    // * fact that _commitWatermark points _past_ the last committed row,
-    //   but we want to return an index pointing at the last row.
-    return std::max(0, gsl::narrow_cast<til::CoordType>(lastRowOffset - 2));
+    const auto committedRows = std::min(_committedPages * _pageRowCount, size_t{ _height });
+    return std::max(0, gsl::narrow_cast<til::CoordType>(committedRows) - 1);
 }
 
 // Retrieves a row from the buffer by its offset from the first row of the text buffer
 // (what corresponds to the top row of the screen buffer).
 const ROW& TextBuffer::GetRowByOffset(const til::CoordType index) const
 {
+    if (_pendingReflow) [[unlikely]]
+    {
+        return _getPendingReflowRow(index);
+    }
     return _getRow(index);
 }
 
@@ -227,8 +291,134 @@ const ROW& TextBuffer::GetRowByOffset(const til::CoordType index) const
 // (what corresponds to the top row of the screen buffer).
 ROW& TextBuffer::GetMutableRowByOffset(const til::CoordType index)
 {
+    // Any changes to rows that haven't been rewrapped yet would be overwritten by ContinueReflow().
+    if (_pendingReflow && index < _pendingReflow->newTop) [[unlikely]]
+    {
+        FinishReflow();
+    }
     _lastMutationId++;
-    return _getRow(index);
+    const auto offset = _getRowOffset(index);
+    _searchIndex.Invalidate(offset - 1);
+    _hyperlinkRefCounts.Invalidate(offset - 1);
+    return _getRowByOffsetDirect(offset);
+}
+
+// Same as _getRow(), but for rows above _pendingReflow->newTop it returns a copy of
+// the old row that's going to be rewrapped into that position. See PendingReflow.
+ROW& TextBuffer::_getPendingReflowRow(til::CoordType y) const
+{
+    auto& row = _getRow(y);
+    auto& pending = *_pendingReflow;
+
+    if (y >= 0 && y < pending.newTop)
+    {
+        const auto source = pending.oldEnd - pending.newTop + y;
+        auto& materialized = til::at(pending.materialized, _getRowOffset(y) - 1);
+
+        if (materialized != source)
+        {
+            row.Reset(_initialAttributes);
+            // If there are more new rows than old ones left, the top of the buffer stays empty.
+            if (source >= 0)
+            {
+                row.CopyFrom(pending.oldBuffer->GetRowByOffset(source));
+            }
+            materialized = source;
+            _searchIndex.Invalidate(_getRowOffset(y) - 1);
+            _hyperlinkRefCounts.Invalidate(_getRowOffset(y) - 1);
+        }
+    }
+
+    return row;
+}
+
+// Materializes the rows in [rowBeg,rowEnd) that are still waiting to be rewrapped, so that
+// they can be read with _getLiveRow() afterwards. See _getPendingReflowRow().
+void TextBuffer::_settlePendingReflow(til::CoordType rowBeg, til::CoordType rowEnd) const
+{
+    if (!_pendingReflow)
+    {
+        return;
+    }
+
+    const auto end = std::min(rowEnd, _pendingReflow->newTop);
+    for (auto y = std::max(0, rowBeg); y < end; ++y)
+    {
+        _getPendingReflowRow(y);
+    }
+}
+
+// Returns the given row if it's committed and not frozen, and nullptr otherwise.
+// Unlike _getRow() this never modifies the buffer. See TextBufferRowReader.
+const ROW* TextBuffer::_getLiveRow(til::CoordType y) const noexcept
+{
+    const auto index = _getRowOffset(y) - 1;
+    const auto mem = til::at(_pages, index / _pageRowCount);
+    return mem ? reinterpret_cast<const ROW*>(mem + (index % _pageRowCount) * _bufferRowStride) : nullptr;
+}
+
+// Copies a row that _getLiveRow() didn't return into the given one, without modifying the buffer.
+// Frozen rows are restored from their ColdRowBlock, while uncommitted rows are blank.
+void TextBuffer::_restoreRow(til::CoordType y, ROW& row) const
+{
+    const auto index = _getRowOffset(y) - 1;
+    const auto chunk = index / _coldChunkRowCount;
+
+    if (chunk < _committedPages && chunk < _coldChunks.size() && til::at(_coldChunks, chunk))
+    {
+        til::at(_coldChunks, chunk)->Restore(index % _coldChunkRowCount, row);
+    }
+    else
+    {
+        row.Reset(_initialAttributes);
+    }
+}
+
+TextBufferRowReader::TextBufferRowReader(const TextBuffer& buffer) :
+    _buffer{ buffer }
+{
+    const auto width = gsl::narrow_cast<uint16_t>(buffer._width);
+    for (auto& slot : _slots)
+    {
+        slot.chars = std::make_unique_for_overwrite<wchar_t[]>(width);
+        slot.charOffsets = std::make_unique_for_overwrite<uint16_t[]>(width + 1);
+        slot.row.emplace(slot.chars.get(), slot.charOffsets.get(), width, buffer._initialAttributes);
+    }
+}
+
+const TextBuffer& TextBufferRowReader::GetBuffer() const noexcept
+{
+    return _buffer;
+}
+
+// Returns the given row, which stays valid until at least 3 other frozen rows have been read.
+const ROW& TextBufferRowReader::GetRow(til::CoordType y)
+{
+    if (const auto row = _buffer._getLiveRow(y))
+    {
+        return *row;
+    }
+
+    _clock++;
+
+    auto lru = _slots.data();
+    for (auto& slot : _slots)
+    {
+        if (slot.y == y)
+        {
+            slot.lastUse = _clock;
+            return *slot.row;
+        }
+        if (slot.lastUse < lru->lastUse)
+        {
+            lru = &slot;
+        }
+    }
+
+    _buffer._restoreRow(y, *lru->row);
+    lru->y = y;
+    lru->lastUse = _clock;
+    return *lru->row;
 }
 
 // Returns a row filled with whitespace and the current attributes, for you to freely use.
@@ -240,14 +430,174 @@ ROW& TextBuffer::GetScratchpadRow()
 // Returns a row filled with whitespace and the given attributes, for you to freely use.
 ROW& TextBuffer::GetScratchpadRow(const TextAttribute& attributes)
 {
-    // The scratchpad row is mapped to the underlying index 0, whereas all regular rows are mapped to
-    // index 1 and up. We do it this way instead of the other way around (scratchpad row at index _height),
-    // because that would force us to MEM_COMMIT the entire buffer whenever this function is called.
-    auto& r = _getRowByOffsetDirect(0);
+    auto& r = _getScratchpadRow();
     r.Reset(attributes);
     return r;
 }
 
+// The scratchpad row is conceptually mapped to the offset 0, whereas all regular rows are mapped to offset 1 and up.
+// It's stored outside of the page directory, so that using it never forces us to commit any of the regular pages.
+ROW& TextBuffer::_getScratchpadRow() const noexcept
+{
+    return *reinterpret_cast<ROW*>(_scratchpad);
+}
+
+// Returns true if the given chunk is committed and if all of its rows are at least _coldRowDistance rows
+// above the bottom of the buffer. It also returns false for the chunk that's going to be recycled next, since
+// freezing it would be a waste of time.
+bool TextBuffer::_isChunkCold(size_t chunk) const noexcept
+{
+    if (chunk >= _committedPages)
+    {
+        return false;
+    }
+
+    const size_t height = _height;
+    const auto first = gsl::narrow_cast<size_t>(_firstRow);
+    const auto beg = chunk * _coldChunkRowCount;
+    const auto end = std::min(beg + _coldChunkRowCount, height);
+
+    // If _firstRow points into the middle of the chunk, it contains both, the oldest and the newest rows.
+    if (first > beg && first < end)
+    {
+        return false;
+    }
+
+    // Map the first and last row in the chunk back to their logical position (the inverse of _getRowOffset()).
+    const auto firstY = (beg + height - first) % height;
+    const auto lastY = (end - 1 + height - first) % height;
+    return firstY >= _coldChunkRowCount && lastY < height - _coldRowDistance;
+}
+
+// Compacts the ROWs in the given chunk into a ColdRowBlock and returns its page to the pool.
+// The caller must ensure that the chunk isn't frozen already and that it's committed.
+void TextBuffer::_freezeChunk(size_t chunk)
+{
+    auto& mem = til::at(_pages, chunk);
+    const auto end = mem + _getPageRowCount(chunk) * _bufferRowStride;
+
+    auto block = std::make_unique<ColdRowBlock>();
+    for (auto it = mem; it < end; it += _bufferRowStride)
+    {
+        block->Append(*reinterpret_cast<const ROW*>(it));
+    }
+    block->Shrink();
+
+    for (auto it = mem; it < end; it += _bufferRowStride)
+    {
+        std::destroy_at(reinterpret_cast<ROW*>(it));
+    }
+
+    RowPagePool::Release(std::exchange(mem, nullptr), _pageSize);
+
+    til::at(_coldChunks, chunk) = std::move(block);
+    _frozenChunkCount++;
+}
+
+// The inverse of _freezeChunk(): Acquires a new page for the chunk and restores its ROWs from the ColdRowBlock.
+void TextBuffer::_thawChunk(size_t chunk)
+{
+    const auto rowCount = _getPageRowCount(chunk);
+    const auto mem = RowPagePool::Acquire(_pageSize);
+
+    // Construct all ROWs first, so that the TextBuffer is in a consistent state, even if restoring them fails.
+    _construct(mem, rowCount, _initialAttributes);
+    til::at(_pages, chunk) = mem;
+
+    const auto block = std::move(til::at(_coldChunks, chunk));
+    _frozenChunkCount--;
+    _coldCandidates.emplace_back(chunk, _rotationCount + _coldRowDistance);
+
+    for (size_t index = 0; index < rowCount; ++index)
+    {
+        block->Restore(index, *reinterpret_cast<ROW*>(mem + index * _bufferRowStride));
+    }
+}
+
+// Called by IncrementCircularBuffer() to freeze chunks as they scroll away from the bottom of the buffer.
+// It freezes at most 2 chunks per call, which keeps the cost per rotation to ~2 ROWs when amortized.
+void TextBuffer::_compactColdScrollback()
+{
+    _rotationCount++;
+
+    const size_t height = _height;
+    if (height < _coldRowDistance + 2 * _coldChunkRowCount)
+    {
+        return;
+    }
+
+    if (_coldChunks.empty())
+    {
+        _coldChunks.resize((height + _coldChunkRowCount - 1) / _coldChunkRowCount);
+    }
+
+    // The row that just moved past the _coldRowDistance threshold. If it's the last
+    // row in its chunk then the entire chunk has just turned cold and we can freeze it.
+    const auto offset = _getRowOffset(gsl::narrow_cast<til::CoordType>(height - _coldRowDistance - 1)) - 1;
+    if ((offset + 1) % _coldChunkRowCount == 0 || offset + 1 == height)
+    {
+        const auto chunk = offset / _coldChunkRowCount;
+        if (!til::at(_coldChunks, chunk) && _isChunkCold(chunk))
+        {
+            _freezeChunk(chunk);
+        }
+    }
+
+    if (!_coldCandidates.empty())
+    {
+        const auto [chunk, notBefore] = _coldCandidates.front();
+        if (_rotationCount >= notBefore)
+        {
+            _coldCandidates.pop_front();
+            if (!til::at(_coldChunks, chunk) && _isChunkCold(chunk))
+            {
+                _freezeChunk(chunk);
+            }
+        }
+    }
+}
+
+// After a resize the entire scrollback is hot. This queues all chunks up to be frozen by _compactColdScrollback().
+void TextBuffer::_queueColdScrollback()
+{
+    const size_t height = _height;
+    if (height < _coldRowDistance + 2 * _coldChunkRowCount)
+    {
+        return;
+    }
+
+    const auto chunks = (height + _coldChunkRowCount - 1) / _coldChunkRowCount;
+    for (size_t chunk = 0; chunk < chunks; ++chunk)
+    {
+        _coldCandidates.emplace_back(chunk, 0);
+    }
+}
+
+void TextBuffer::_resetColdScrollback() noexcept
+{
+    _coldChunks.clear();
+    _coldCandidates.clear();
+    _frozenChunkCount = 0;
+}
+
+// Same as GetRowByOffset(y).GetHyperlinks(), but for a row offset and without committing or restoring the row.
+std::vector<uint16_t> TextBuffer::_getRowHyperlinks(size_t offset) const
+{
+    const auto index = offset - 1;
+    const auto page = index / _pageRowCount;
+
+    // Rows that haven't been committed yet are blank and we don't want to commit them just for this.
+    if (page >= _committedPages)
+    {
+        return {};
+    }
+    if (const auto mem = til::at(_pages, page))
+    {
+        return reinterpret_cast<const ROW*>(mem + (index % _pageRowCount) * _bufferRowStride)->GetHyperlinks();
+    }
+    return til::at(_coldChunks, page)->GetHyperlinks(index % _coldChunkRowCount);
+}
+
 #pragma warning(pop)
 #pragma endregion
 
@@ -407,18 +757,19 @@ void TextBuffer::_PrepareForDoubleByteSequence(const DbcsAttribute dbcsAttribute
 
 // Given the character offset `position` in the `chars` string, this function returns the starting position of the next grapheme.
 // For instance, given a `chars` of L"x\uD83D\uDE42y" and a `position` of 1 it'll return 3.
+// Graphemes are extended grapheme clusters as defined by UAX #29, so for instance an "e" followed by
+// a combining acute accent, or an emoji ZWJ sequence, are a single grapheme. See CodepointWidthDetector.
 // GraphemePrev would do the exact inverse of this operation.
-// In the future, these functions are expected to also deliver information about how many columns a grapheme occupies.
-// (I know that mere UTF-16 code point iteration doesn't handle graphemes, but that's what we're working towards.)
 size_t TextBuffer::GraphemeNext(const std::wstring_view& chars, size_t position) noexcept
 {
-    return til::utf16_iterate_next(chars, position);
+    size_t width = 0;
+    return GraphemeClusterNext(chars, position, width);
 }
 
 // It's the counterpart to GraphemeNext. See GraphemeNext.
 size_t TextBuffer::GraphemePrev(const std::wstring_view& chars, size_t position) noexcept
 {
-    return til::utf16_iterate_prev(chars, position);
+    return GraphemeClusterPrev(chars, position);
 }
 
 // Ever wondered how much space a piece of text needs before inserting it? This function will tell you!
@@ -435,72 +786,36 @@ size_t TextBuffer::FitTextIntoColumns(const std::wstring_view& chars, til::Coord
 {
     columnLimit = std::max(0, columnLimit);
 
-    const auto beg = chars.begin();
-    const auto end = chars.end();
-    auto it = beg;
-    const auto asciiEnd = beg + std::min(chars.size(), gsl::narrow_cast<size_t>(columnLimit));
+    const auto limit = gsl::narrow_cast<size_t>(columnLimit);
+    const auto asciiLen = std::min(chars.size(), limit);
 
     // ASCII fast-path: 1 char always corresponds to 1 column.
-    for (; it != asciiEnd && *it < 0x80; ++it)
+    auto dist = ROW::CountAscii({ chars.data(), asciiLen });
+
+    // Just like in ROW::ReplaceText(), the last ASCII character may be part of a grapheme cluster with the following one.
+    if (dist != 0 && dist < chars.size() && til::at(chars, dist) >= 0x80) [[unlikely]]
     {
+        --dist;
     }
 
-    const auto dist = gsl::narrow_cast<size_t>(it - beg);
-    auto col = gsl::narrow_cast<til::CoordType>(dist);
-
-    if (it == asciiEnd) [[likely]]
+    if (dist == asciiLen) [[likely]]
     {
-        columns = col;
+        columns = gsl::narrow_cast<til::CoordType>(dist);
         return dist;
     }
 
     // Unicode slow-path where we need to count text and columns separately.
-    for (;;)
-    {
-        auto ptr = &*it;
-        const auto wch = *ptr;
-        size_t len = 1;
-
-        col++;
-
-        // Even in our slow-path we can avoid calling IsGlyphFullWidth if the current character is ASCII.
-        // It also allows us to skip the surrogate pair decoding at the same time.
-        if (wch >= 0x80)
-        {
-            if (til::is_surrogate(wch))
-            {
-                const auto it2 = it + 1;
-                if (til::is_leading_surrogate(wch) && it2 != end && til::is_trailing_surrogate(*it2))
-                {
-                    len = 2;
-                }
-                else
-                {
-                    ptr = &UNICODE_REPLACEMENT;
-                }
-            }
-
-            col += IsGlyphFullWidth({ ptr, len });
-        }
-
-        // If we ran out of columns, we need to always return `columnLimit` and not `cols`,
-        // because if we tried inserting a wide glyph into just 1 remaining column it will
-        // fail to fit, but that remaining column still has been used up. When the caller sees
-        // `columns == columnLimit` they will line-wrap and continue inserting into the next row.
-        if (col > columnLimit)
-        {
-            columns = columnLimit;
-            return gsl::narrow_cast<size_t>(it - beg);
-        }
-
-        // But if we simply ran out of text we just need to return the actual number of columns.
-        it += len;
-        if (it == end)
-        {
-            columns = col;
-            return chars.size();
-        }
-    }
+    // The remainder is measured in one go, which avoids a width lookup call per glyph.
+    size_t col = 0;
+    const auto len = dist + FitGlyphsIntoColumns(chars.substr(dist), limit - dist, col);
+
+    // If we ran out of columns, we need to always return `columnLimit` and not `col`,
+    // because if we tried inserting a wide glyph into just 1 remaining column it will
+    // fail to fit, but that remaining column still has been used up. When the caller sees
+    // `columns == columnLimit` they will line-wrap and continue inserting into the next row.
+    // But if we simply ran out of text we just need to return the actual number of columns.
+    columns = len < chars.size() ? columnLimit : gsl::narrow_cast<til::CoordType>(dist + col);
+    return len;
 }
 
 // Pretend as if `position` is a regular cursor in the TextBuffer.
@@ -710,6 +1025,39 @@ OutputCellIterator TextBuffer::WriteLine(const OutputCellIterator givenIt,
     return newIt;
 }
 
+// Routine Description:
+// - Writes CHAR_INFOs to the output buffer. This is the bulk equivalent of calling
+//   Write() with an OutputCellIterator over the same CHAR_INFOs. See ROW::WriteCharInfos().
+// Arguments:
+// - charInfos - the cells to write
+// - target - the row/column to start writing the cells to
+// - wrap - change the wrap flag if we hit the end of the row while writing and there's still more data
+// Return Value:
+// - The number of CHAR_INFOs that were written
+size_t TextBuffer::WriteCharInfos(std::span<const CHAR_INFO> charInfos, til::point target, const std::optional<bool> wrap)
+{
+    const auto size = GetSize();
+    size_t written = 0;
+
+    while (!charInfos.empty() && size.IsInBounds(target))
+    {
+        auto& row = GetMutableRowByOffset(target.y);
+        const auto consumed = row.WriteCharInfos(charInfos, target.x, wrap);
+
+        // If not all cells fit, the rest of the row was filled (the last column possibly with padding).
+        const auto columns = consumed < charInfos.size() ? size.Width() - target.x : gsl::narrow_cast<til::CoordType>(consumed);
+        TriggerRedraw(Viewport::FromDimensions(target, { columns, 1 }));
+
+        charInfos = charInfos.subspan(consumed);
+        written += consumed;
+
+        target.x = 0;
+        ++target.y;
+    }
+
+    return written;
+}
+
 //Routine Description:
 // - Inserts one codepoint into the buffer at the current cursor position and advances the cursor as appropriate.
 //Arguments:
@@ -867,7 +1215,12 @@ void TextBuffer::IncrementCircularBuffer(const TextAttribute& fillAttributes)
     _PruneHyperlinks();
 
     // Second, clean out the old "first row" as it will become the "last row" of the buffer after the circle is performed.
-    GetMutableRowByOffset(0).Reset(fillAttributes);
+    // This intentionally doesn't use GetMutableRowByOffset(), because that would finish any pending reflow:
+    // If the first row hasn't been rewrapped yet, there's simply one less row left to rewrap now.
+    _lastMutationId++;
+    _searchIndex.Invalidate(_getRowOffset(0) - 1);
+    _hyperlinkRefCounts.Invalidate(_getRowOffset(0) - 1);
+    _getRow(0).Reset(fillAttributes);
     {
         // Now proceed to increment.
         // Incrementing it will cause the next line down to become the new "top" of the window (the new "0" in logical coordinates)
@@ -879,6 +1232,22 @@ void TextBuffer::IncrementCircularBuffer(const TextAttribute& fillAttributes)
             _firstRow = 0;
         }
     }
+
+    if (_pendingReflow)
+    {
+        _pendingReflow->newTop--;
+        if (_pendingReflow->newTop <= 0)
+        {
+            _pendingReflow.reset();
+        }
+    }
+
+    // Compacting the scrollback is purely an optimization. If it fails we simply keep the rows as they are.
+    try
+    {
+        _compactColdScrollback();
+    }
+    CATCH_LOG();
 }
 
 //Routine Description:
@@ -1041,6 +1410,89 @@ void TextBuffer::ScrollRows(const til::CoordType firstRow, til::CoordType size,
     }
 }
 
+// Copies the text and attributes of the `width` columns starting at `sourceX` to `targetX`.
+// The two rows must not be the same, because ROW::CopyTextFrom() doesn't support that.
+static void copyRowSegment(const ROW& source, til::CoordType sourceX, ROW& target, til::CoordType targetX, til::CoordType width)
+{
+    width = std::min({ width, source.size() - sourceX, target.size() - targetX });
+    if (width <= 0)
+    {
+        return;
+    }
+
+    auto srcX = sourceX;
+    auto dstX = targetX;
+    auto remaining = width;
+
+    // CopyTextFrom() refuses to start in the middle of a wide glyph. Its leading half isn't
+    // part of the copied range, so we replace it with whitespace, just like it does with
+    // a wide glyph that gets cut off at the end of the range.
+    if (source.DbcsAttrAt(srcX) == DbcsAttribute::Trailing)
+    {
+        target.ReplaceCharacters(dstX, 1, L" ");
+        ++srcX;
+        ++dstX;
+        --remaining;
+    }
+
+    if (remaining > 0)
+    {
+        RowCopyTextFromState state{
+            .source = source,
+            .columnBegin = dstX,
+            .columnLimit = dstX + remaining,
+            .sourceColumnBegin = srcX,
+            .sourceColumnLimit = srcX + remaining,
+        };
+        target.CopyTextFrom(state);
+    }
+
+    const auto srcBeg = gsl::narrow_cast<uint16_t>(sourceX);
+    const auto dstBeg = gsl::narrow_cast<uint16_t>(targetX);
+    const auto count = gsl::narrow_cast<uint16_t>(width);
+    target.Attributes().replace(dstBeg, dstBeg + count, source.Attributes().slice(srcBeg, srcBeg + count));
+}
+
+// Routine Description:
+// - Copies the contents of the source rectangle to the given target position, one row
+//   segment at a time. The two areas may overlap, just like with memmove().
+// - This is what scrolling within horizontal margins and DECCRA boil down to.
+// Arguments:
+// - source - The area to copy. It must be within the buffer.
+// - target - The top left corner of the destination. The copy is clipped to the buffer width.
+void TextBuffer::CopyRect(const til::rect& source, const til::point target)
+{
+    const auto width = source.width();
+    const auto height = source.height();
+    if (width <= 0 || height <= 0 || source.origin() == target)
+    {
+        return;
+    }
+
+    // If the target is below the source we must walk the rows bottom-up,
+    // so that we don't overwrite source rows before we've copied them.
+    const auto bottomUp = target.y > source.top;
+
+    for (til::CoordType i = 0; i < height; ++i)
+    {
+        const auto dy = bottomUp ? height - 1 - i : i;
+        auto& dstRow = GetMutableRowByOffset(target.y + dy);
+        const auto* srcRow = &GetRowByOffset(source.top + dy);
+
+        // Moving a segment within the same row requires a temporary copy.
+        if (srcRow == &dstRow)
+        {
+            auto& scratch = GetScratchpadRow();
+            scratch.CopyFrom(dstRow);
+            srcRow = &scratch;
+        }
+
+        copyRowSegment(*srcRow, source.left, dstRow, target.x, width);
+    }
+
+    TriggerRedraw(Viewport::FromDimensions(target, { width, height }));
+}
+
 Cursor& TextBuffer::GetCursor() noexcept
 {
     return _cursor;
@@ -1163,8 +1615,21 @@ void TextBuffer::ClearScrollback(const til::CoordType start, const til::CoordTyp
         return;
     }
 
-    // Our goal is to move the viewport to the absolute start of the underlying memory buffer so that we can
-    // MEM_DECOMMIT the remaining memory. _firstRow is used to make the TextBuffer behave like a circular buffer.
+    if (_pendingReflow)
+    {
+        // There's no point in rewrapping rows that we're about to clear anyways.
+        if (start >= _pendingReflow->newTop)
+        {
+            _pendingReflow.reset();
+        }
+        else
+        {
+            FinishReflow();
+        }
+    }
+
+    // Our goal is to move the viewport to the absolute start of the underlying memory buffer so that we can
+    // MEM_DECOMMIT the remaining memory. _firstRow is used to make the TextBuffer behave like a circular buffer.
     // The start parameter is relative to the _firstRow. The trick to get the content to the absolute start
     // is to simply add _firstRow ourselves and then reset it to 0. This causes ScrollRows() to write into
     // the absolute start while reading from relative coordinates. This works because GetRowByOffset()
@@ -1173,12 +1638,23 @@ void TextBuffer::ClearScrollback(const til::CoordType start, const til::CoordTyp
     _firstRow = 0;
     ScrollRows(startAbsolute, height, -startAbsolute);
 
-    const auto end = _estimateOffsetOfLastCommittedRow();
+    // Since _firstRow is 0 now, the pages past the one containing the last kept row only contain
+    // rows that we're about to clear. Instead of resetting them, we can return them to the pool.
+    const auto keptPages = (gsl::narrow_cast<size_t>(height) + _pageRowCount - 1) / _pageRowCount;
+    const auto end = std::min(_estimateOffsetOfLastCommittedRow(), gsl::narrow_cast<til::CoordType>(keptPages * _pageRowCount) - 1);
     for (auto y = height; y <= end; ++y)
     {
         GetMutableRowByOffset(y).Reset(_initialAttributes);
     }
 
+    if (keptPages < _committedPages)
+    {
+        _destroy(keptPages);
+        _lastMutationId++;
+        _searchIndex.Reset();
+        _hyperlinkRefCounts.Reset();
+    }
+
     ScrollMarks(-start);
     ClearMarksInRange(til::point{ 0, height }, til::point{ _width, _height });
 }
@@ -1195,34 +1671,113 @@ void TextBuffer::ResizeTraditional(til::size newSize)
     newSize.width = std::max(newSize.width, 1);
     newSize.height = std::max(newSize.height, 1);
 
-    TextBuffer newBuffer{ newSize, _currentAttributes, 0, false, _renderer };
+    FinishReflow();
+
     const auto cursorRow = GetCursor().GetPosition().y;
     const auto copyableRows = std::min<til::CoordType>(_height, newSize.height);
     til::CoordType srcRow = 0;
-    til::CoordType dstRow = 0;
 
     if (cursorRow >= newSize.height)
     {
         srcRow = cursorRow - newSize.height + 1;
     }
 
-    for (; dstRow < copyableRows; ++dstRow, ++srcRow)
+    if (!_tryResizeInPlace(newSize, srcRow, copyableRows))
     {
-        newBuffer.GetMutableRowByOffset(dstRow).CopyFrom(GetRowByOffset(srcRow));
-    }
+        TextBuffer newBuffer{ newSize, _currentAttributes, 0, false, _renderer };
+
+        for (til::CoordType dstRow = 0; dstRow < copyableRows; ++dstRow, ++srcRow)
+        {
+            newBuffer.GetMutableRowByOffset(dstRow).CopyFrom(GetRowByOffset(srcRow));
+        }
 
-    // NOTE: Keep this in sync with _reserve().
-    _buffer = std::move(newBuffer._buffer);
-    _bufferEnd = newBuffer._bufferEnd;
-    _commitWatermark = newBuffer._commitWatermark;
-    _initialAttributes = newBuffer._initialAttributes;
-    _bufferRowStride = newBuffer._bufferRowStride;
-    _bufferOffsetChars = newBuffer._bufferOffsetChars;
-    _bufferOffsetCharOffsets = newBuffer._bufferOffsetCharOffsets;
-    _width = newBuffer._width;
-    _height = newBuffer._height;
+        // Our old storage ends up in newBuffer, which destroys it when it goes out of scope.
+        _swapStorage(newBuffer);
+    }
 
     _SetFirstRowIndex(0);
+
+    _resetColdScrollback();
+    _queueColdScrollback();
+    _searchIndex.Reset();
+    _hyperlinkRefCounts.Reset();
+}
+
+// The fast path of ResizeTraditional() for when the width stays the same. If the rows that are kept start
+// at a page boundary, their pages can simply be moved into a new page directory, instead of copying every
+// row into a new buffer. This is the usual case when a buffer grows or when it hasn't wrapped around yet.
+// Returns false if the pages can't be reused, in which case the buffer hasn't been modified.
+bool TextBuffer::_tryResizeInPlace(const til::size newSize, const til::CoordType srcRow, const til::CoordType copyableRows)
+{
+    const size_t oldHeight = _height;
+    const auto newHeight = gsl::narrow<uint16_t>(newSize.height);
+    const auto start = gsl::narrow_cast<size_t>((_firstRow + srcRow) % _height);
+    const auto rows = gsl::narrow_cast<size_t>(copyableRows);
+
+    // The pages must be interchangeable, and the kept rows must map onto whole pages in order. If the rows wrap
+    // around the end of the buffer, that's only the case if the last page is full (= the height is a multiple).
+    if (newSize.width != _width ||
+        std::min<size_t>(newHeight, _pageRowCount) * _bufferRowStride != _pageSize ||
+        start % _pageRowCount != 0 ||
+        (start + rows > oldHeight && oldHeight % _pageRowCount != 0))
+    {
+        return false;
+    }
+
+    const auto oldPageCount = _pages.size();
+    const auto firstPage = start / _pageRowCount;
+    const auto keptPages = (rows + _pageRowCount - 1) / _pageRowCount;
+    std::vector<std::byte*> pages((size_t{ newHeight } + _pageRowCount - 1) / _pageRowCount, nullptr);
+
+    // Pages we keep need to be committed and thawed, so that they actually contain their rows.
+    for (size_t i = 0; i < keptPages; ++i)
+    {
+        const auto page = (firstPage + i) % oldPageCount;
+        if (!til::at(_pages, page))
+        {
+            _commit(page);
+        }
+    }
+
+    // Nothing below this point throws.
+    for (size_t i = 0; i < keptPages; ++i)
+    {
+        til::at(pages, i) = std::exchange(til::at(_pages, (firstPage + i) % oldPageCount), nullptr);
+    }
+
+    // Only the last kept page may contain rows that aren't kept. Those need to be blanked,
+    // and the page may also need to store a different number of rows than before.
+    const auto lastPage = (firstPage + keptPages - 1) % oldPageCount;
+    const auto lastMem = til::at(pages, keptPages - 1);
+    const auto keptRows = rows - (keptPages - 1) * _pageRowCount;
+    const auto oldRows = _getPageRowCount(lastPage);
+    const auto newRows = std::min(_pageRowCount, size_t{ newHeight } - (keptPages - 1) * _pageRowCount);
+
+    for (auto i = keptRows; i < std::max(oldRows, newRows); ++i)
+    {
+        const auto it = lastMem + i * _bufferRowStride;
+        if (i >= newRows)
+        {
+            std::destroy_at(reinterpret_cast<ROW*>(it));
+        }
+        else if (i >= oldRows)
+        {
+            _construct(it, 1, _currentAttributes);
+        }
+        else
+        {
+            reinterpret_cast<ROW*>(it)->Reset(_currentAttributes);
+        }
+    }
+
+    // Return the pages we didn't keep to the pool.
+    _destroy();
+
+    _pages = std::move(pages);
+    _committedPages = keptPages;
+    _initialAttributes = _currentAttributes;
+    _height = newHeight;
+    return true;
 }
 
 void TextBuffer::SetAsActiveBuffer(const bool isActiveBuffer) noexcept
@@ -1555,47 +2110,29 @@ til::point TextBuffer::_GetWordEndForSelection(const til::point target, const st
 
 void TextBuffer::_PruneHyperlinks()
 {
-    // Check the old first row for hyperlink references
-    // If there are any, search the entire buffer for the same reference
-    // If the buffer does not contain the same reference, we can remove that hyperlink from our map
-    // This way, obsolete hyperlink references are cleared from our hyperlink map instead of hanging around
-    // Get all the hyperlink references in the row we're erasing
-    const auto hyperlinks = GetRowByOffset(0).GetHyperlinks();
-
-    if (!hyperlinks.empty())
-    {
-        // Move to unordered set so we can use hashed lookup of IDs instead of linear search.
-        // Only make it an unordered set now because set always heap allocates but vector
-        // doesn't when the set is empty (saving an allocation in the common case of no links.)
-        std::unordered_set<uint16_t> firstRowRefs{ hyperlinks.cbegin(), hyperlinks.cend() };
-
-        const auto total = TotalRowCount();
-        // Loop through all the rows in the buffer except the first row -
-        // we have found all hyperlink references in the first row and put them in refs,
-        // now we need to search the rest of the buffer (i.e. all the rows except the first)
-        // to see if those references are anywhere else
-        for (til::CoordType i = 1; i < total; ++i)
-        {
-            const auto nextRowRefs = GetRowByOffset(i).GetHyperlinks();
-            for (auto id : nextRowRefs)
-            {
-                if (firstRowRefs.find(id) != firstRowRefs.end())
-                {
-                    firstRowRefs.erase(id);
-                }
-            }
-            if (firstRowRefs.empty())
-            {
-                // No more hyperlink references left to search for, terminate early
-                break;
-            }
-        }
+    // The rows that are yet to be reflowed may still refer to any of our hyperlinks,
+    // but we can't see them, unless we finish the reflow. So don't prune anything until then.
+    if (_pendingReflow)
+    {
+        return;
+    }
 
-        // Now delete obsolete references from our map
-        for (auto hyperlinkReference : firstRowRefs)
-        {
-            RemoveHyperlinkFromMap(hyperlinkReference);
-        }
+    // There's nothing to prune if there are no hyperlinks. This also
+    // avoids counting references in buffers that never contained any.
+    if (_hyperlinkMap.empty())
+    {
+        return;
+    }
+
+    // Remove the references of the row we're about to recycle from the reference counts.
+    // The hyperlinks that aren't referenced by any other row anymore are obsolete
+    // and can be removed from our map instead of hanging around.
+    _hyperlinkRefCounts.Update(_height, [this](size_t row) {
+        return _getRowHyperlinks(row + 1);
+    });
+    for (const auto id : _hyperlinkRefCounts.Release(_getRowOffset(0) - 1))
+    {
+        RemoveHyperlinkFromMap(id);
     }
 }
 
@@ -2133,122 +2670,81 @@ std::string TextBuffer::GenHTML(const CopyRequest& req,
             htmlBuilder += "\">";
         }
 
-        for (auto iRow = req.beg.y; iRow <= req.end.y; ++iRow)
-        {
-            const auto& row = GetRowByOffset(iRow);
-            const auto [rowBeg, rowEnd, addLineBreak] = _RowCopyHelper(req, iRow, row);
-            const auto rowBegU16 = gsl::narrow_cast<uint16_t>(rowBeg);
-            const auto rowEndU16 = gsl::narrow_cast<uint16_t>(rowEnd);
-            const auto runs = row.Attributes().slice(rowBegU16, rowEndU16).runs();
-
-            auto x = rowBegU16;
-            for (const auto& [attr, length] : runs)
-            {
-                const auto nextX = gsl::narrow_cast<uint16_t>(x + length);
-                const auto [fg, bg, ul] = GetAttributeColors(attr);
-                const auto fgHex = Utils::ColorToHexString(fg);
-                const auto bgHex = Utils::ColorToHexString(bg);
-                const auto ulHex = Utils::ColorToHexString(ul);
-                const auto ulStyle = attr.GetUnderlineStyle();
-                const auto isUnderlined = ulStyle != UnderlineStyle::NoUnderline;
-                const auto isCrossedOut = attr.IsCrossedOut();
-                const auto isOverlined = attr.IsOverlined();
-
-                htmlBuilder += "<SPAN STYLE=\"";
-                fmt::format_to(std::back_inserter(htmlBuilder), FMT_COMPILE("color:{};"), fgHex);
-                fmt::format_to(std::back_inserter(htmlBuilder), FMT_COMPILE("background-color:{};"), bgHex);
-
-                if (isIntenseBold && attr.IsIntense())
-                {
-                    htmlBuilder += "font-weight:bold;";
-                }
+        const auto getRunMarkup = [&](const TextAttribute& attr) {
+            const auto [fg, bg, ul] = GetAttributeColors(attr);
+            const auto fgHex = Utils::ColorToHexString(fg);
+            const auto bgHex = Utils::ColorToHexString(bg);
+            const auto ulHex = Utils::ColorToHexString(ul);
+            const auto ulStyle = attr.GetUnderlineStyle();
+            const auto isUnderlined = ulStyle != UnderlineStyle::NoUnderline;
+            const auto isCrossedOut = attr.IsCrossedOut();
+            const auto isOverlined = attr.IsOverlined();
 
-                if (attr.IsItalic())
-                {
-                    htmlBuilder += "font-style:italic;";
-                }
+            RunMarkup markup;
+            auto& prefix = markup.prefix;
 
-                if (isCrossedOut || isOverlined)
-                {
-                    fmt::format_to(std::back_inserter(htmlBuilder),
-                                   FMT_COMPILE("text-decoration:{} {} {};"),
-                                   isCrossedOut ? "line-through" : "",
-                                   isOverlined ? "overline" : "",
-                                   fgHex);
-                }
+            prefix += "<SPAN STYLE=\"";
+            fmt::format_to(std::back_inserter(prefix), FMT_COMPILE("color:{};"), fgHex);
+            fmt::format_to(std::back_inserter(prefix), FMT_COMPILE("background-color:{};"), bgHex);
 
-                if (isUnderlined)
-                {
-                    // Since underline, overline and strikethrough use the same css property,
-                    // we cannot apply different colors to them at the same time. However, we
-                    // can achieve the desired result by creating a nested <span> and applying
-                    // underline style and color to it.
-                    htmlBuilder += "\"><SPAN STYLE=\"";
+            if (isIntenseBold && attr.IsIntense())
+            {
+                prefix += "font-weight:bold;";
+            }
 
-                    switch (ulStyle)
-                    {
-                    case UnderlineStyle::NoUnderline:
-                        break;
-                    case UnderlineStyle::DoublyUnderlined:
-                        fmt::format_to(std::back_inserter(htmlBuilder), FMT_COMPILE("text-decoration:underline double {};"), ulHex);
-                        break;
-                    case UnderlineStyle::CurlyUnderlined:
-                        fmt::format_to(std::back_inserter(htmlBuilder), FMT_COMPILE("text-decoration:underline wavy {};"), ulHex);
-                        break;
-                    case UnderlineStyle::DottedUnderlined:
-                        fmt::format_to(std::back_inserter(htmlBuilder), FMT_COMPILE("text-decoration:underline dotted {};"), ulHex);
-                        break;
-                    case UnderlineStyle::DashedUnderlined:
-                        fmt::format_to(std::back_inserter(htmlBuilder), FMT_COMPILE("text-decoration:underline dashed {};"), ulHex);
-                        break;
-                    case UnderlineStyle::SinglyUnderlined:
-                    default:
-                        fmt::format_to(std::back_inserter(htmlBuilder), FMT_COMPILE("text-decoration:underline {};"), ulHex);
-                        break;
-                    }
-                }
+            if (attr.IsItalic())
+            {
+                prefix += "font-style:italic;";
+            }
 
-                htmlBuilder += "\">";
+            if (isCrossedOut || isOverlined)
+            {
+                fmt::format_to(std::back_inserter(prefix),
+                               FMT_COMPILE("text-decoration:{} {} {};"),
+                               isCrossedOut ? "line-through" : "",
+                               isOverlined ? "overline" : "",
+                               fgHex);
+            }
 
-                // text
-                std::string unescapedText;
-                THROW_IF_FAILED(til::u16u8(row.GetText(x, nextX), unescapedText));
-                for (const auto c : unescapedText)
-                {
-                    switch (c)
-                    {
-                    case '<':
-                        htmlBuilder += "&lt;";
-                        break;
-                    case '>':
-                        htmlBuilder += "&gt;";
-                        break;
-                    case '&':
-                        htmlBuilder += "&amp;";
-                        break;
-                    default:
-                        htmlBuilder += c;
-                    }
-                }
+            if (isUnderlined)
+            {
+                // Since underline, overline and strikethrough use the same css property,
+                // we cannot apply different colors to them at the same time. However, we
+                // can achieve the desired result by creating a nested <span> and applying
+                // underline style and color to it.
+                prefix += "\"><SPAN STYLE=\"";
 
-                if (isUnderlined)
+                switch (ulStyle)
                 {
-                    // close the nested span we created for underline
-                    htmlBuilder += "</SPAN>";
+                case UnderlineStyle::NoUnderline:
+                    break;
+                case UnderlineStyle::DoublyUnderlined:
+                    fmt::format_to(std::back_inserter(prefix), FMT_COMPILE("text-decoration:underline double {};"), ulHex);
+                    break;
+                case UnderlineStyle::CurlyUnderlined:
+                    fmt::format_to(std::back_inserter(prefix), FMT_COMPILE("text-decoration:underline wavy {};"), ulHex);
+                    break;
+                case UnderlineStyle::DottedUnderlined:
+                    fmt::format_to(std::back_inserter(prefix), FMT_COMPILE("text-decoration:underline dotted {};"), ulHex);
+                    break;
+                case UnderlineStyle::DashedUnderlined:
+                    fmt::format_to(std::back_inserter(prefix), FMT_COMPILE("text-decoration:underline dashed {};"), ulHex);
+                    break;
+                case UnderlineStyle::SinglyUnderlined:
+                default:
+                    fmt::format_to(std::back_inserter(prefix), FMT_COMPILE("text-decoration:underline {};"), ulHex);
+                    break;
                 }
+            }
 
-                htmlBuilder += "</SPAN>";
+            prefix += "\">";
 
-                // advance to next run of text
-                x = nextX;
-            }
+            // close the nested span we created for underline
+            markup.suffix = isUnderlined ? "</SPAN></SPAN>" : "</SPAN>";
+            return markup;
+        };
 
-            // never add line break to the last row.
-            if (addLineBreak && iRow < req.end.y)
-            {
-                htmlBuilder += "<BR>";
-            }
-        }
+        _FormatRuns(req, htmlBuilder, getRunMarkup, _AppendHTMLText, "<BR>");
 
         htmlBuilder += "</DIV>";
 
@@ -2383,88 +2879,70 @@ std::string TextBuffer::GenRTF(const CopyRequest& req,
         // color. See: Spec 1.9.1, Pg. 23.
         fmt::format_to(std::back_inserter(contentBuilder), FMT_COMPILE("\\chshdng0\\chcbpat{}"), getColorTableIndex(backgroundColor));
 
-        for (auto iRow = req.beg.y; iRow <= req.end.y; ++iRow)
-        {
-            const auto& row = GetRowByOffset(iRow);
-            const auto [rowBeg, rowEnd, addLineBreak] = _RowCopyHelper(req, iRow, row);
-            const auto rowBegU16 = gsl::narrow_cast<uint16_t>(rowBeg);
-            const auto rowEndU16 = gsl::narrow_cast<uint16_t>(rowEnd);
-            const auto runs = row.Attributes().slice(rowBegU16, rowEndU16).runs();
-
-            auto x = rowBegU16;
-            for (auto& [attr, length] : runs)
-            {
-                const auto nextX = gsl::narrow_cast<uint16_t>(x + length);
-                const auto [fg, bg, ul] = GetAttributeColors(attr);
-                const auto fgIdx = getColorTableIndex(fg);
-                const auto bgIdx = getColorTableIndex(bg);
-                const auto ulIdx = getColorTableIndex(ul);
-                const auto ulStyle = attr.GetUnderlineStyle();
-
-                // start an RTF group that can be closed later to restore the
-                // default attribute.
-                contentBuilder += "{";
-
-                fmt::format_to(std::back_inserter(contentBuilder), FMT_COMPILE("\\cf{}"), fgIdx);
-                fmt::format_to(std::back_inserter(contentBuilder), FMT_COMPILE("\\chshdng0\\chcbpat{}"), bgIdx);
-
-                if (isIntenseBold && attr.IsIntense())
-                {
-                    contentBuilder += "\\b";
-                }
-
-                if (attr.IsItalic())
-                {
-                    contentBuilder += "\\i";
-                }
+        const auto getRunMarkup = [&](const TextAttribute& attr) {
+            const auto [fg, bg, ul] = GetAttributeColors(attr);
+            const auto fgIdx = getColorTableIndex(fg);
+            const auto bgIdx = getColorTableIndex(bg);
+            const auto ulIdx = getColorTableIndex(ul);
+            const auto ulStyle = attr.GetUnderlineStyle();
 
-                if (attr.IsCrossedOut())
-                {
-                    contentBuilder += "\\strike";
-                }
+            RunMarkup markup;
+            auto& prefix = markup.prefix;
 
-                switch (ulStyle)
-                {
-                case UnderlineStyle::NoUnderline:
-                    break;
-                case UnderlineStyle::DoublyUnderlined:
-                    fmt::format_to(std::back_inserter(contentBuilder), FMT_COMPILE("\\uldb\\ulc{}"), ulIdx);
-                    break;
-                case UnderlineStyle::CurlyUnderlined:
-                    fmt::format_to(std::back_inserter(contentBuilder), FMT_COMPILE("\\ulwave\\ulc{}"), ulIdx);
-                    break;
-                case UnderlineStyle::DottedUnderlined:
-                    fmt::format_to(std::back_inserter(contentBuilder), FMT_COMPILE("\\uld\\ulc{}"), ulIdx);
-                    break;
-                case UnderlineStyle::DashedUnderlined:
-                    fmt::format_to(std::back_inserter(contentBuilder), FMT_COMPILE("\\uldash\\ulc{}"), ulIdx);
-                    break;
-                case UnderlineStyle::SinglyUnderlined:
-                default:
-                    fmt::format_to(std::back_inserter(contentBuilder), FMT_COMPILE("\\ul\\ulc{}"), ulIdx);
-                    break;
-                }
+            // start an RTF group that can be closed later to restore the
+            // default attribute.
+            prefix += "{";
 
-                // RTF commands and the text data must be separated by a space.
-                // Otherwise, if the text begins with a space then that space will
-                // be interpreted as part of the last command, and will be lost.
-                contentBuilder += " ";
+            fmt::format_to(std::back_inserter(prefix), FMT_COMPILE("\\cf{}"), fgIdx);
+            fmt::format_to(std::back_inserter(prefix), FMT_COMPILE("\\chshdng0\\chcbpat{}"), bgIdx);
 
-                const auto unescapedText = row.GetText(x, nextX); // including character at nextX
-                _AppendRTFText(contentBuilder, unescapedText);
+            if (isIntenseBold && attr.IsIntense())
+            {
+                prefix += "\\b";
+            }
 
-                contentBuilder += "}"; // close RTF group
+            if (attr.IsItalic())
+            {
+                prefix += "\\i";
+            }
 
-                // advance to next run of text
-                x = nextX;
+            if (attr.IsCrossedOut())
+            {
+                prefix += "\\strike";
             }
 
-            // never add line break to the last row.
-            if (addLineBreak && iRow < req.end.y)
+            switch (ulStyle)
             {
-                contentBuilder += "\\line";
+            case UnderlineStyle::NoUnderline:
+                break;
+            case UnderlineStyle::DoublyUnderlined:
+                fmt::format_to(std::back_inserter(prefix), FMT_COMPILE("\\uldb\\ulc{}"), ulIdx);
+                break;
+            case UnderlineStyle::CurlyUnderlined:
+                fmt::format_to(std::back_inserter(prefix), FMT_COMPILE("\\ulwave\\ulc{}"), ulIdx);
+                break;
+            case UnderlineStyle::DottedUnderlined:
+                fmt::format_to(std::back_inserter(prefix), FMT_COMPILE("\\uld\\ulc{}"), ulIdx);
+                break;
+            case UnderlineStyle::DashedUnderlined:
+                fmt::format_to(std::back_inserter(prefix), FMT_COMPILE("\\uldash\\ulc{}"), ulIdx);
+                break;
+            case UnderlineStyle::SinglyUnderlined:
+            default:
+                fmt::format_to(std::back_inserter(prefix), FMT_COMPILE("\\ul\\ulc{}"), ulIdx);
+                break;
             }
-        }
+
+            // RTF commands and the text data must be separated by a space.
+            // Otherwise, if the text begins with a space then that space will
+            // be interpreted as part of the last command, and will be lost.
+            prefix += " ";
+
+            markup.suffix = "}"; // close RTF group
+            return markup;
+        };
+
+        _FormatRuns(req, contentBuilder, getRunMarkup, _AppendRTFText, "\\line");
 
         // add color table to the final RTF
         rtfBuilder += colorTableBuilder + "}";
@@ -2481,6 +2959,183 @@ std::string TextBuffer::GenRTF(const CopyRequest& req,
     }
 }
 
+// Calls format(beg, end, output) for chunks of the items [0,count) on the thread pool and the calling thread.
+// Each chunk writes into its own string and the strings are appended to `output` in order.
+static void formatChunksParallel(size_t count, size_t chunkSize, const std::function<void(size_t, size_t, std::string&)>& format, std::string& output)
+{
+    struct Chunk
+    {
+        size_t beg = 0;
+        size_t end = 0;
+        std::string output;
+        std::exception_ptr exception;
+    };
+
+    struct Context
+    {
+        const std::function<void(size_t, size_t, std::string&)>& format;
+        std::vector<Chunk> chunks;
+        std::atomic<size_t> next{ 0 };
+
+        // Run by each worker (and the calling thread) until all chunks are claimed.
+        void run() noexcept
+        {
+            for (auto i = next.fetch_add(1, std::memory_order_relaxed); i < chunks.size(); i = next.fetch_add(1, std::memory_order_relaxed))
+            {
+                auto& chunk = til::at(chunks, i);
+                try
+                {
+                    format(chunk.beg, chunk.end, chunk.output);
+                }
+                catch (...)
+                {
+                    chunk.exception = std::current_exception();
+                }
+            }
+        }
+    };
+
+    Context context{ format };
+    for (size_t beg = 0; beg < count; beg += chunkSize)
+    {
+        context.chunks.emplace_back(Chunk{ .beg = beg, .end = std::min(beg + chunkSize, count) });
+    }
+
+    const wil::unique_threadpool_work_nocancel work{ CreateThreadpoolWork(
+        [](PTP_CALLBACK_INSTANCE, PVOID ctx, PTP_WORK) noexcept {
+            static_cast<Context*>(ctx)->run();
+        },
+        &context,
+        nullptr) };
+    THROW_LAST_ERROR_IF(!work);
+
+    const auto workers = std::min<size_t>(context.chunks.size(), std::thread::hardware_concurrency());
+    for (size_t i = 1; i < workers; ++i)
+    {
+        SubmitThreadpoolWork(work.get());
+    }
+
+    context.run();
+    WaitForThreadpoolWorkCallbacks(work.get(), FALSE);
+
+    auto size = output.size();
+    for (const auto& chunk : context.chunks)
+    {
+        if (chunk.exception)
+        {
+            std::rethrow_exception(chunk.exception);
+        }
+        size += chunk.output.size();
+    }
+
+    output.reserve(size);
+    for (const auto& chunk : context.chunks)
+    {
+        output += chunk.output;
+    }
+}
+
+// Routine Description:
+// - Appends the selected text of the copy request to `output`. This is the part that GenHTML() and GenRTF() share.
+// - getRunMarkup() is called only once per unique attribute, in the order in which they first appear.
+//   It resolves the colors through a callback that isn't necessarily thread-safe, which is why this happens
+//   in a serial pass over the attribute runs first. Those are cheap to iterate compared to formatting the text.
+// - The rows are then formatted in parallel if there are enough of them. Each run is written
+//   as its cached markup prefix, the text as escaped by appendText(), and the markup suffix.
+// Arguments:
+// - req - the copy request
+// - output - the string to append to
+// - getRunMarkup - returns the markup that surrounds runs of the given attribute
+// - appendText - appends the given text to the string, escaped for the output format
+// - lineBreak - appended at the end of every row that gets a line break
+void TextBuffer::_FormatRuns(const CopyRequest& req,
+                             std::string& output,
+                             const std::function<RunMarkup(const TextAttribute&)>& getRunMarkup,
+                             void (*appendText)(std::string&, const std::wstring_view&),
+                             const std::string_view lineBreak) const
+{
+    struct RowBounds
+    {
+        til::CoordType beg = 0;
+        til::CoordType end = 0;
+        bool addLineBreak = false;
+    };
+
+    std::vector<RowBounds> rows;
+    rows.reserve(gsl::narrow_cast<size_t>(req.end.y - req.beg.y + 1));
+    std::unordered_map<TextAttribute, RunMarkup> markups;
+
+    for (auto iRow = req.beg.y; iRow <= req.end.y; ++iRow)
+    {
+        // Reading rows may need to thaw them from the cold scrollback or to rewrap them if a reflow
+        // is still pending. Neither is thread-safe, so we do it here, before the workers read them.
+        const auto& row = GetRowByOffset(iRow);
+        const auto [rowBeg, rowEnd, addLineBreak] = _RowCopyHelper(req, iRow, row);
+
+        row.ForEachAttributeRun(rowBeg, rowEnd, [&](til::CoordType, til::CoordType, const TextAttribute& attr) {
+            if (!markups.contains(attr))
+            {
+                markups.emplace(attr, getRunMarkup(attr));
+            }
+        });
+
+        // never add line break to the last row.
+        rows.emplace_back(RowBounds{ rowBeg, rowEnd, addLineBreak && iRow < req.end.y });
+    }
+
+    const auto formatRows = [&](size_t beg, size_t end, std::string& out) {
+        for (auto i = beg; i < end; ++i)
+        {
+            const auto& bounds = til::at(rows, i);
+            const auto& row = GetRowByOffset(req.beg.y + gsl::narrow_cast<til::CoordType>(i));
+
+            row.ForEachAttributeRun(bounds.beg, bounds.end, [&](til::CoordType x, til::CoordType nextX, const TextAttribute& attr) {
+                const auto& markup = markups.find(attr)->second;
+                out += markup.prefix;
+                appendText(out, row.GetText(x, nextX));
+                out += markup.suffix;
+            });
+
+            if (bounds.addLineBreak)
+            {
+                out += lineBreak;
+            }
+        }
+    };
+
+    if (std::thread::hardware_concurrency() > 1 && rows.size() >= 2 * s_parallelFormatChunkRows)
+    {
+        formatChunksParallel(rows.size(), s_parallelFormatChunkRows, formatRows, output);
+    }
+    else
+    {
+        formatRows(0, rows.size(), output);
+    }
+}
+
+void TextBuffer::_AppendHTMLText(std::string& contentBuilder, const std::wstring_view& text)
+{
+    std::string unescapedText;
+    THROW_IF_FAILED(til::u16u8(text, unescapedText));
+    for (const auto c : unescapedText)
+    {
+        switch (c)
+        {
+        case '<':
+            contentBuilder += "&lt;";
+            break;
+        case '>':
+            contentBuilder += "&gt;";
+            break;
+        case '&':
+            contentBuilder += "&amp;";
+            break;
+        default:
+            contentBuilder += c;
+        }
+    }
+}
+
 void TextBuffer::_AppendRTFText(std::string& contentBuilder, const std::wstring_view& text)
 {
     for (const auto codeUnit : text)
@@ -2526,27 +3181,268 @@ void TextBuffer::_AppendRTFText(std::string& contentBuilder, const std::wstring_
 // - S_OK if we successfully copied the contents to the new buffer, otherwise an appropriate HRESULT.
 void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const Viewport* lastCharacterViewport, PositionInformation* positionInfo)
 {
-    const auto& oldCursor = oldBuffer.GetCursor();
-    auto& newCursor = newBuffer.GetCursor();
+    oldBuffer.FinishReflow();
+    _reflow(oldBuffer, newBuffer, 0, lastCharacterViewport, positionInfo);
+}
 
-    til::point oldCursorPos = oldCursor.GetPosition();
-    til::point newCursorPos;
+// Function Description:
+// - Same as Reflow(), but only the rows around the viewports and the cursor are reflowed right away.
+//   The remaining scrollback is rewrapped by calling ContinueReflow() until it returns false.
+//   Until then, GetRowByOffset() returns the old rows that haven't been rewrapped yet 1:1.
+// - Unlike Reflow(), this always anchors the contents to the bottom of the new buffer, because the
+//   rewrapped scrollback is filled in from the bottom up. This only differs from Reflow() if the
+//   contents don't fill the new buffer, in which case the top of the scrollback is left empty.
+// Arguments:
+// - oldBuffer - the text buffer to copy the contents FROM. If any rows are left to be reflowed,
+//   newBuffer takes ownership of it and oldBuffer will be null afterwards.
+// - newBuffer - the text buffer to copy the contents TO
+// - lastCharacterViewport - See Reflow().
+// - positionInfo - See Reflow().
+void TextBuffer::ReflowIncremental(std::unique_ptr<TextBuffer>& oldBuffer, TextBuffer& newBuffer, const Viewport* lastCharacterViewport, PositionInformation& positionInfo)
+{
+    // If oldBuffer has a pending reflow itself (for instance while the window is being resized),
+    // we don't finish it here. Instead, _continueReflowUntil() advances it as far as we need it.
+    const auto oldBegin = _findReflowTail(*oldBuffer, positionInfo);
+    const auto newY = _reflow(*oldBuffer, newBuffer, oldBegin, lastCharacterViewport, &positionInfo);
+    const auto newTop = newBuffer.GetSize().Height() - newY;
 
-    // BODGY: We use oldCursorPos in two critical places below:
-    // * To compute an oldHeight that includes at a minimum the cursor row
-    // * For REFLOW_JANK_CURSOR_WRAP (see comment below)
-    // Both of these would break the reflow algorithm, but the latter of the two in particular
-    // would cause the main copy loop below to deadlock. In other words, these two lines
-    // protect this function against yet-unknown bugs in other parts of the code base.
-    oldCursorPos.x = std::clamp(oldCursorPos.x, 0, oldBuffer._width - 1);
-    oldCursorPos.y = std::clamp(oldCursorPos.y, 0, oldBuffer._height - 1);
+    if (oldBegin == 0 || newTop <= 0)
+    {
+        return;
+    }
 
-    const auto lastRowWithText = oldBuffer.GetLastNonSpaceCharacter(lastCharacterViewport).y;
+    // _reflow() anchored the rows it wrote to the bottom of the buffer.
+    positionInfo.mutableViewportTop += newTop;
+    positionInfo.visibleViewportTop += newTop;
+
+    // The old buffer is only ever read from now on and shouldn't trigger any redraws.
+    oldBuffer->SetAsActiveBuffer(false);
+    newBuffer._pendingReflow = std::make_unique<PendingReflow>(PendingReflow{
+        .oldBuffer = std::move(oldBuffer),
+        .oldEnd = oldBegin,
+        .newTop = newTop,
+        .materialized = std::vector<til::CoordType>(newBuffer._height, til::CoordTypeMin),
+    });
+}
+
+bool TextBuffer::IsReflowPending() const noexcept
+{
+    return _pendingReflow != nullptr;
+}
+
+// Rewraps about rowBudget many rows that ReflowIncremental() left for later.
+// Returns true if there are any rows left afterwards.
+bool TextBuffer::ContinueReflow(til::CoordType rowBudget)
+{
+    if (!_pendingReflow)
+    {
+        return false;
+    }
+
+    auto& pending = *_pendingReflow;
+    auto& oldBuffer = *pending.oldBuffer;
+
+    while (rowBudget > 0 && pending.oldEnd > 0 && pending.newTop > 0)
+    {
+        // Find the start of the logical line that ends right above oldEnd.
+        auto oldBegin = pending.oldEnd - 1;
+        oldBuffer._continueReflowUntil(oldBegin);
+        while (oldBegin > 0)
+        {
+            oldBuffer._continueReflowUntil(oldBegin - 1);
+            if (!oldBuffer.GetRowByOffset(oldBegin - 1).WasWrapForced())
+            {
+                break;
+            }
+            oldBegin--;
+        }
+
+        // We fill the buffer from the bottom up, so we need to know the height of the line before we can write it.
+        const auto height = _reflowLine(oldBuffer, oldBegin, pending.oldEnd, 0, true);
+        const auto newY = pending.newTop - height;
+        _reflowLine(oldBuffer, oldBegin, pending.oldEnd, newY, false);
+
+        rowBudget -= pending.oldEnd - oldBegin;
+        pending.oldEnd = oldBegin;
+        pending.newTop = std::max(0, newY);
+    }
+
+    // _reflowLine() writes rows directly. It's simpler to rebuild the indices once the reflow is done.
+    _searchIndex.Reset();
+    _hyperlinkRefCounts.Reset();
+    _lastMutationId++;
+    TriggerRedrawAll();
+
+    if (pending.oldEnd > 0 && pending.newTop > 0)
+    {
+        return true;
+    }
+
+    // We ran out of old rows before we ran out of new ones. The remaining ones may still hold copies of old rows.
+    for (til::CoordType y = 0; y < pending.newTop; ++y)
+    {
+        _getRow(y).Reset(_initialAttributes);
+    }
+
+    _pendingReflow.reset();
+    return false;
+}
+
+// Rewraps all rows that ReflowIncremental() left for later.
+void TextBuffer::FinishReflow()
+{
+    ContinueReflow(til::CoordTypeMax);
+}
+
+// Rewraps as many rows as necessary for all rows from y on to be final.
+// This allows us to reflow a buffer that has a pending reflow itself, without having to finish it first.
+void TextBuffer::_continueReflowUntil(const til::CoordType y)
+{
+    while (_pendingReflow && y < _pendingReflow->newTop)
+    {
+        ContinueReflow(_reflowTailRowCount);
+    }
+}
+
+// Returns the first row in oldBuffer that ReflowIncremental() should reflow right away.
+// Returns 0 if there are too few rows above it to make deferring them worthwhile.
+til::CoordType TextBuffer::_findReflowTail(TextBuffer& oldBuffer, const PositionInformation& positionInfo)
+{
+    auto y = std::min({ positionInfo.mutableViewportTop, positionInfo.visibleViewportTop, oldBuffer.GetCursor().GetPosition().y });
+    y -= _reflowTailRowCount;
+
+    if (y < _reflowDeferMinRowCount)
+    {
+        oldBuffer.FinishReflow();
+        return 0;
+    }
+
+    // ContinueReflow() rewraps entire logical lines, so the tail has to start at the beginning of one.
+    while (y > 0)
+    {
+        oldBuffer._continueReflowUntil(y - 1);
+        if (!oldBuffer.GetRowByOffset(y - 1).WasWrapForced())
+        {
+            break;
+        }
+        y--;
+    }
+
+    return y;
+}
+
+// Rewraps the logical line made up of the rows [oldBegin,oldEnd) in oldBuffer into this buffer, starting at row newY.
+// Rows above the top of the buffer are written into the scratchpad, just like all rows are if measureOnly is true.
+// Returns the number of rows the line occupies in this buffer. This is a simplified version of the loop in _reflow().
+til::CoordType TextBuffer::_reflowLine(const TextBuffer& oldBuffer, const til::CoordType oldBegin, const til::CoordType oldEnd, til::CoordType newY, const bool measureOnly)
+{
+    const auto newTop = newY;
+    const til::CoordType newWidth = _width;
+    til::CoordType newX = 0;
+
+    const auto getNewRow = [&]() -> ROW& {
+        return measureOnly || newY < 0 ? _getScratchpadRow() : _getRow(newY);
+    };
+
+    for (auto oldY = oldBegin; oldY < oldEnd; ++oldY)
+    {
+        const auto& oldRow = oldBuffer.GetRowByOffset(oldY);
+
+        // See the matching branch in _reflow().
+        if (oldRow.GetLineRendition() != LineRendition::SingleWidth)
+        {
+            if (newX)
+            {
+                newX = 0;
+                newY++;
+            }
+
+            auto& newRow = getNewRow();
+            newRow.Reset(_initialAttributes);
+            newRow.CopyFrom(oldRow);
+            newRow.SetWrapForced(false);
+            newY++;
+            continue;
+        }
+
+        const auto oldRowLimit = oldRow.MeasureRight();
+        til::CoordType oldX = 0;
+
+        do
+        {
+            if (newX >= newWidth)
+            {
+                getNewRow().SetWrapForced(true);
+                newX = 0;
+                newY++;
+            }
+
+            auto& newRow = getNewRow();
+
+            // The rows we write into may still hold copies of old rows. See _getPendingReflowRow().
+            if (newX == 0)
+            {
+                newRow.Reset(_initialAttributes);
+            }
+
+            RowCopyTextFromState state{
+                .source = oldRow,
+                .columnBegin = newX,
+                .columnLimit = til::CoordTypeMax,
+                .sourceColumnBegin = oldX,
+                .sourceColumnLimit = oldRowLimit,
+            };
+            newRow.CopyTextFrom(state);
+
+            if (!measureOnly)
+            {
+                const auto& oldAttr = oldRow.Attributes();
+                auto& newAttr = newRow.Attributes();
+                const auto attributes = oldAttr.slice(gsl::narrow_cast<uint16_t>(oldX), oldAttr.size());
+                newAttr.replace(gsl::narrow_cast<uint16_t>(newX), newAttr.size(), attributes);
+                newAttr.resize_trailing_extent(_width);
+            }
+
+            oldX = state.sourceColumnEnd;
+            newX = state.columnEnd;
+        } while (oldX < oldRowLimit);
+
+        if (!oldRow.WasWrapForced())
+        {
+            newX = 0;
+            newY++;
+        }
+    }
+
+    return newY - newTop;
+}
+
+// The implementation of Reflow() and ReflowIncremental(). Reflows the rows starting at oldBegin.
+// If oldBegin isn't 0, the reflowed rows are anchored to the bottom of newBuffer.
+// Returns the number of rows that were written into newBuffer, which may exceed its height.
+til::CoordType TextBuffer::_reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const til::CoordType oldBegin, const Viewport* lastCharacterViewport, PositionInformation* positionInfo)
+{
+    const auto& oldCursor = oldBuffer.GetCursor();
+    auto& newCursor = newBuffer.GetCursor();
+
+    til::point oldCursorPos = oldCursor.GetPosition();
+    til::point newCursorPos;
+
+    // BODGY: We use oldCursorPos in two critical places below:
+    // * To compute an oldHeight that includes at a minimum the cursor row
+    // * For REFLOW_JANK_CURSOR_WRAP (see comment below)
+    // Both of these would break the reflow algorithm, but the latter of the two in particular
+    // would cause the main copy loop below to deadlock. In other words, these two lines
+    // protect this function against yet-unknown bugs in other parts of the code base.
+    oldCursorPos.x = std::clamp(oldCursorPos.x, 0, oldBuffer._width - 1);
+    oldCursorPos.y = std::clamp(oldCursorPos.y, 0, oldBuffer._height - 1);
+
+    const auto lastRowWithText = oldBuffer.GetLastNonSpaceCharacter(lastCharacterViewport).y;
 
     auto mutableViewportTop = positionInfo ? positionInfo->mutableViewportTop : til::CoordTypeMax;
     auto visibleViewportTop = positionInfo ? positionInfo->visibleViewportTop : til::CoordTypeMax;
 
-    til::CoordType oldY = 0;
+    til::CoordType oldY = oldBegin;
     til::CoordType newY = 0;
     til::CoordType newX = 0;
     til::CoordType newWidth = newBuffer.GetSize().Width();
@@ -2719,7 +3615,8 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
     // Since we didn't use IncrementCircularBuffer() we need to compute the proper
     // _firstRow offset now, in a way that replicates IncrementCircularBuffer().
     // We need to do the same for newCursorPos.y for basically the same reason.
-    if (newY > newHeight)
+    // If we didn't start at the top of oldBuffer, the same math anchors the rows to the bottom of newBuffer.
+    if (newY > newHeight || oldBegin != 0)
     {
         newBuffer._firstRow = newY % newHeight;
         // _firstRow maps from API coordinates that always start at 0,0 in the top left corner of the
@@ -2738,7 +3635,14 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
     newCursor.SetPosition(newCursorPos);
 
     newBuffer._marks = oldBuffer._marks;
-    newBuffer._trimMarksOutsideBuffer();
+    if (oldBegin != 0)
+    {
+        newBuffer._marks.Scroll(newHeight - newY - oldBegin);
+    }
+    newBuffer._marks.Trim(newHeight);
+
+    newBuffer._queueColdScrollback();
+    return newY;
 }
 
 // Method Description:
@@ -2845,6 +3749,139 @@ void TextBuffer::CopyHyperlinkMaps(const TextBuffer& other)
     _hyperlinkMap = other._hyperlinkMap;
     _hyperlinkCustomIdMap = other._hyperlinkCustomIdMap;
     _currentHyperlinkId = other._currentHyperlinkId;
+    _hyperlinkRefCounts.Reset();
+}
+
+// Returns true if a proper prefix of the needle is also its suffix, like "aa" or "abcab".
+// Only such needles can have overlapping matches, which a parallel search would find inconsistently,
+// depending on where the chunks are split, while a serial search skips them consistently.
+static bool needleHasBorder(const std::wstring_view& needle, bool caseInsensitive)
+{
+    std::vector<char16_t> folded;
+    if (!caseInsensitive)
+    {
+        folded.assign(needle.begin(), needle.end());
+    }
+    else if (!TrigramIndex::Fold(needle, folded))
+    {
+        return true;
+    }
+
+    // This is the prefix function of the Knuth-Morris-Pratt algorithm. prefix[i]
+    // is the length of the longest proper prefix of folded[0..i] that's also its suffix.
+    std::vector<size_t> prefix(folded.size());
+    for (size_t i = 1, k = 0; i < folded.size(); ++i)
+    {
+        while (k != 0 && til::at(folded, i) != til::at(folded, k))
+        {
+            k = til::at(prefix, k - 1);
+        }
+        if (til::at(folded, i) == til::at(folded, k))
+        {
+            ++k;
+        }
+        til::at(prefix, i) = k;
+    }
+
+    return !prefix.empty() && prefix.back() != 0;
+}
+
+static void searchRowsSerial(TextBufferRowReader& reader, URegularExpression* re, til::CoordType rowBeg, til::CoordType rowEnd, std::vector<til::point_span>& results)
+{
+    UErrorCode status = U_ZERO_ERROR;
+    auto text = ICU::UTextFromTextBuffer(reader, rowBeg, rowEnd);
+    uregex_setUText(re, &text, &status);
+
+    if (uregex_find(re, -1, &status))
+    {
+        do
+        {
+            results.emplace_back(ICU::BufferRangeFromMatch(&text, re));
+        } while (uregex_findNext(re, &status));
+    }
+}
+
+// Splits [rowBeg,rowEnd) into chunks and searches them on the thread pool, each with its own clone of `re`.
+// Every chunk extends `overlap` rows into the next one, so that any match that starts in it is found in full,
+// but only the matches that start within the chunk itself are kept. The results are returned in order.
+static void searchRowsParallel(const TextBuffer& buffer, URegularExpression* re, til::CoordType rowBeg, til::CoordType rowEnd, til::CoordType overlap, std::vector<til::point_span>& results)
+{
+    struct Chunk
+    {
+        til::CoordType beg = 0;
+        til::CoordType end = 0;
+        std::vector<til::point_span> results;
+        std::exception_ptr exception;
+    };
+
+    struct Context
+    {
+        const TextBuffer& buffer;
+        URegularExpression* re;
+        til::CoordType rowEnd;
+        til::CoordType overlap;
+        std::vector<Chunk> chunks;
+        std::atomic<size_t> next{ 0 };
+
+        // Run by each worker (and the calling thread) until all chunks are claimed.
+        void run() noexcept
+        {
+            UErrorCode status = U_ZERO_ERROR;
+            const ICU::unique_uregex clone{ uregex_clone(re, &status) };
+            std::optional<TextBufferRowReader> reader;
+
+            for (auto i = next.fetch_add(1, std::memory_order_relaxed); i < chunks.size(); i = next.fetch_add(1, std::memory_order_relaxed))
+            {
+                auto& chunk = til::at(chunks, i);
+                try
+                {
+                    THROW_HR_IF(E_OUTOFMEMORY, U_FAILURE(status));
+                    if (!reader)
+                    {
+                        reader.emplace(buffer);
+                    }
+                    searchRowsSerial(*reader, clone.get(), chunk.beg, std::min(chunk.end + overlap, rowEnd), chunk.results);
+                    std::erase_if(chunk.results, [&](const auto& r) { return r.start.y >= chunk.end; });
+                }
+                catch (...)
+                {
+                    chunk.exception = std::current_exception();
+                }
+            }
+        }
+    };
+
+    Context context{ buffer, re, rowEnd, overlap };
+    for (auto beg = rowBeg; beg < rowEnd; beg += s_parallelSearchChunkRows)
+    {
+        context.chunks.emplace_back(Chunk{ .beg = beg, .end = std::min(beg + s_parallelSearchChunkRows, rowEnd) });
+    }
+
+    const wil::unique_threadpool_work_nocancel work{ CreateThreadpoolWork(
+        [](PTP_CALLBACK_INSTANCE, PVOID ctx, PTP_WORK) noexcept {
+            static_cast<Context*>(ctx)->run();
+        },
+        &context,
+        nullptr) };
+    THROW_LAST_ERROR_IF(!work);
+
+    const auto workers = std::min<size_t>(context.chunks.size(), std::thread::hardware_concurrency());
+    for (size_t i = 1; i < workers; ++i)
+    {
+        SubmitThreadpoolWork(work.get());
+    }
+
+    context.run();
+    WaitForThreadpoolWorkCallbacks(work.get(), FALSE);
+
+    for (auto& chunk : context.chunks)
+    {
+        if (chunk.exception)
+        {
+            std::rethrow_exception(chunk.exception);
+        }
+        results.insert(results.end(), chunk.results.begin(), chunk.results.end());
+    }
 }
 
 // Searches through the entire (committed) text buffer for `needle` and returns the coordinates in absolute coordinates.
@@ -2868,29 +3905,163 @@ std::vector<til::point_span> TextBuffer::SearchText(const std::wstring_view& nee
         return results;
     }
 
-    auto text = ICU::UTextFromTextBuffer(*this, rowBeg, rowEnd);
-
     uint32_t flags = UREGEX_LITERAL;
     WI_SetFlagIf(flags, UREGEX_CASE_INSENSITIVE, caseInsensitive);
 
     UErrorCode status = U_ZERO_ERROR;
     const auto re = ICU::CreateRegex(needle, flags, &status);
-    uregex_setUText(re.get(), &text, &status);
+    if (U_FAILURE(status))
+    {
+        return results;
+    }
+
+    // Large ranges of rows are searched in parallel, as long as the needle can't have overlapping matches.
+    // Case folding may expand a needle up to 3x and every row holds at least _width/2 characters,
+    // which gives us the number of rows a match can extend past the row it starts in.
+    const auto parallel = std::thread::hardware_concurrency() > 1 && !needleHasBorder(needle, caseInsensitive);
+    const auto minRowLength = std::max<size_t>(1, gsl::narrow_cast<size_t>(_width) / 2);
+    const auto overlap = gsl::narrow_cast<til::CoordType>((needle.size() * 3 + minRowLength - 1) / minRowLength);
 
-    if (uregex_find(re.get(), -1, &status))
+    // Rows are read through TextBufferRowReader, which doesn't thaw the cold scrollback and is safe to use
+    // from the parallel workers. It can't rewrap rows for a pending reflow however, which we do here instead.
+    _settlePendingReflow(rowBeg, std::min(rowEnd + 1, _height));
+    TextBufferRowReader reader{ *this };
+
+    const auto searchRows = [&](til::CoordType beg, til::CoordType end) {
+        if (parallel && end - beg >= 2 * s_parallelSearchChunkRows)
+        {
+            searchRowsParallel(*this, re.get(), beg, end, overlap, results);
+        }
+        else
+        {
+            searchRowsSerial(reader, re.get(), beg, end, results);
+        }
+    };
+
+    // The index needs at least 1 trigram to work with. Rows narrower than that
+    // would also result in most matches spanning more rows than it's worth.
+    const auto query = _width >= 4 ? TrigramIndex::CreateQuery(needle) : TrigramIndex::Query{};
+    if (query.bits.empty())
     {
-        do
+        searchRows(rowBeg, rowEnd);
+        return results;
+    }
+
+    _updateSearchIndex(reader, rowBeg, rowEnd);
+
+    // A match that starts in row y contains the needle's first trigram in row y and all the other ones
+    // in the rows it spans. All rows but the first and last one of a match are entirely part of it,
+    // which limits how far we need to look. The candidate ranges are merged, so that matches that
+    // span multiple candidates are found, and verified with ICU as usual.
+    til::CoordType candidateBeg = 0;
+    til::CoordType candidateEnd = 0;
+
+    for (auto y = rowBeg; y < rowEnd; ++y)
+    {
+        if (!(_searchIndex.Match(_getRowOffset(y) - 1, query) & 1))
+        {
+            continue;
+        }
+
+        uint64_t found = 0;
+        size_t spanned = 0;
+
+        for (auto end = y; end < rowEnd; ++end)
         {
-            results.emplace_back(ICU::BufferRangeFromMatch(&text, re.get()));
-        } while (uregex_findNext(re.get(), &status));
+            const auto offset = _getRowOffset(end) - 1;
+            found |= _searchIndex.Match(offset, query);
+
+            if (found == query.mask)
+            {
+                if (y > candidateEnd)
+                {
+                    if (candidateBeg < candidateEnd)
+                    {
+                        searchRows(candidateBeg, candidateEnd);
+                    }
+                    candidateBeg = y;
+                }
+                candidateEnd = std::max(candidateEnd, end + 1);
+                break;
+            }
+
+            if (end != y)
+            {
+                spanned += _searchIndex.FoldedLength(offset);
+                if (spanned >= query.length)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (candidateBeg < candidateEnd)
+    {
+        searchRows(candidateBeg, candidateEnd);
     }
 
     return results;
 }
 
-const std::vector<ScrollMark>& TextBuffer::GetMarks() const noexcept
+// Re-indexes all dirty rows in [rowBeg,rowEnd) for SearchText().
+void TextBuffer::_updateSearchIndex(TextBufferRowReader& reader, til::CoordType rowBeg, til::CoordType rowEnd) const
+{
+    _searchIndex.Resize(gsl::narrow_cast<size_t>(_height));
+
+    for (auto y = rowBeg; y < rowEnd; ++y)
+    {
+        const auto offset = _getRowOffset(y);
+        if (!_searchIndex.IsDirty(offset - 1))
+        {
+            continue;
+        }
+
+        // The trigrams at the end of a row continue into the next one, just like they do for the UText.
+        // Rows that haven't been committed yet are blank and we don't want to commit them just for this.
+        std::wstring_view nextText;
+        if (y + 1 < _height)
+        {
+            const auto nextPage = (_getRowOffset(y + 1) - 1) / _pageRowCount;
+            nextText = nextPage < _committedPages ? reader.GetRow(y + 1).GetText() : L"  ";
+        }
+
+        _searchIndex.Update(offset - 1, reader.GetRow(y).GetText(), nextText);
+    }
+}
+
+bool TextBuffer::HasMarks() const noexcept
 {
-    return _marks;
+    return !_marks.Empty();
+}
+
+std::vector<ScrollMark> TextBuffer::GetMarks() const
+{
+    return _marks.GetAll();
+}
+
+// Returns the marks that start within the rows [rowBeg, rowEnd), sorted by their start position.
+std::vector<ScrollMark> TextBuffer::GetMarksInRange(const til::CoordType rowBeg, const til::CoordType rowEnd) const
+{
+    return _marks.GetInRange(rowBeg, rowEnd);
+}
+
+// Returns the closest mark that starts above the given row.
+std::optional<ScrollMark> TextBuffer::GetPreviousMark(const til::CoordType row) const
+{
+    return _marks.GetPrevious(row);
+}
+
+// Returns the closest mark that starts below the given row.
+std::optional<ScrollMark> TextBuffer::GetNextMark(const til::CoordType row) const
+{
+    return _marks.GetNext(row);
+}
+
+// Returns the mark of the active prompt, if there is one.
+std::optional<ScrollMark> TextBuffer::GetCurrentMark() const
+{
+    return _marks.GetCurrent();
 }
 
 // Remove all marks between `start` & `end`, inclusive.
@@ -2898,19 +4069,11 @@ void TextBuffer::ClearMarksInRange(
     const til::point start,
     const til::point end)
 {
-    auto inRange = [&start, &end](const ScrollMark& m) {
-        return (m.start >= start && m.start <= end) ||
-               (m.end >= start && m.end <= end);
-    };
-
-    _marks.erase(std::remove_if(_marks.begin(),
-                                _marks.end(),
-                                inRange),
-                 _marks.end());
+    _marks.ClearRange(start, end);
 }
 void TextBuffer::ClearAllMarks() noexcept
 {
-    _marks.clear();
+    _marks.Clear();
 }
 
 // Adjust all the marks in the y-direction by `delta`. Positive values move the
@@ -2918,63 +4081,39 @@ void TextBuffer::ClearAllMarks() noexcept
 // trim marks that are no longer have a start in the bounds of the buffer
 void TextBuffer::ScrollMarks(const int delta)
 {
-    for (auto& mark : _marks)
-    {
-        mark.start.y += delta;
-
-        // If the mark had sub-regions, then move those pointers too
-        if (mark.commandEnd.has_value())
-        {
-            (*mark.commandEnd).y += delta;
-        }
-        if (mark.outputEnd.has_value())
-        {
-            (*mark.outputEnd).y += delta;
-        }
-    }
-    _trimMarksOutsideBuffer();
+    _marks.Scroll(delta);
+    _marks.Trim(_height);
 }
 
 // Method Description:
 // - Add a mark to our list of marks, and treat it as the active "prompt". For
 //   the sake of shell integration, we need to know which mark represents the
-//   current prompt/command/output. Internally, we'll always treat the _last_
-//   mark in the list as the current prompt.
+//   current prompt/command/output.
 // Arguments:
 // - m: the mark to add.
 void TextBuffer::StartPromptMark(const ScrollMark& m)
 {
-    _marks.push_back(m);
+    _marks.Add(m, true);
 }
 // Method Description:
 // - Add a mark to our list of marks. Don't treat this as the active prompt.
 //   This should be used for marks created by the UI or from other user input.
-//   By inserting at the start of the list, we can separate out marks that were
-//   generated by client programs vs ones created by the user.
 // Arguments:
 // - m: the mark to add.
 void TextBuffer::AddMark(const ScrollMark& m)
 {
-    _marks.insert(_marks.begin(), m);
-}
-
-void TextBuffer::_trimMarksOutsideBuffer()
-{
-    const til::CoordType height = _height;
-    std::erase_if(_marks, [height](const auto& m) {
-        return (m.start.y < 0) || (m.start.y >= height);
-    });
+    _marks.Add(m, false);
 }
 
 std::wstring_view TextBuffer::CurrentCommand() const
 {
-    if (_marks.size() == 0)
+    const auto curr = _marks.GetCurrent();
+    if (!curr)
     {
         return L"";
     }
 
-    const auto& curr{ _marks.back() };
-    const auto& start{ curr.end };
+    const auto& start{ curr->end };
     const auto& end{ GetCursor().GetPosition() };
 
     const auto line = start.y;
@@ -2984,29 +4123,13 @@ std::wstring_view TextBuffer::CurrentCommand() const
 
 void TextBuffer::SetCurrentPromptEnd(const til::point pos) noexcept
 {
-    if (_marks.empty())
-    {
-        return;
-    }
-    auto& curr{ _marks.back() };
-    curr.end = pos;
+    _marks.SetCurrentPromptEnd(pos);
 }
 void TextBuffer::SetCurrentCommandEnd(const til::point pos) noexcept
 {
-    if (_marks.empty())
-    {
-        return;
-    }
-    auto& curr{ _marks.back() };
-    curr.commandEnd = pos;
+    _marks.SetCurrentCommandEnd(pos);
 }
 void TextBuffer::SetCurrentOutputEnd(const til::point pos, ::MarkCategory category) noexcept
 {
-    if (_marks.empty())
-    {
-        return;
-    }
-    auto& curr{ _marks.back() };
-    curr.outputEnd = pos;
-    curr.category = category;
+    _marks.SetCurrentOutputEnd(pos, category);
 }
@@ -51,56 +51,26 @@ filling in the last row, and updating the screen.
 
 #include <vector>
 
+#include "ColdRowBlock.hpp"
 #include "cursor.h"
+#include "HyperlinkRefCounts.hpp"
 #include "Row.hpp"
+#include "ScrollMarkStore.hpp"
 #include "TextAttribute.hpp"
+#include "TrigramIndex.hpp"
 #include "../types/inc/Viewport.hpp"
 
 #include "../buffer/out/textBufferCellIterator.hpp"
 #include "../buffer/out/textBufferTextIterator.hpp"
 
 struct URegularExpression;
+class TextBufferRowReader;
 
 namespace Microsoft::Console::Render
 {
     class Renderer;
 }
 
-enum class MarkCategory
-{
-    Prompt = 0,
-    Error = 1,
-    Warning = 2,
-    Success = 3,
-    Info = 4
-};
-struct ScrollMark
-{
-    std::optional<til::color> color;
-    til::point start;
-    til::point end; // exclusive
-    std::optional<til::point> commandEnd;
-    std::optional<til::point> outputEnd;
-
-    MarkCategory category{ MarkCategory::Info };
-    // Other things we may want to think about in the future are listed in
-    // GH#11000
-
-    bool HasCommand() const noexcept
-    {
-        return commandEnd.has_value() && *commandEnd != end;
-    }
-    bool HasOutput() const noexcept
-    {
-        return outputEnd.has_value() && *outputEnd != *commandEnd;
-    }
-    std::pair<til::point, til::point> GetExtent() const
-    {
-        til::point realEnd{ til::coalesce_value(outputEnd, commandEnd, end) };
-        return std::make_pair(til::point{ start }, realEnd);
-    }
-};
-
 class TextBuffer final
 {
 public:
@@ -156,6 +126,8 @@ public:
                                  const std::optional<bool> setWrap = std::nullopt,
                                  const std::optional<til::CoordType> limitRight = std::nullopt);
 
+    size_t WriteCharInfos(std::span<const CHAR_INFO> charInfos, til::point target, std::optional<bool> wrap = true);
+
     void InsertCharacter(const wchar_t wch, const DbcsAttribute dbcsAttribute, const TextAttribute attr);
     void InsertCharacter(const std::wstring_view chars, const DbcsAttribute dbcsAttribute, const TextAttribute attr);
     void IncrementCursor();
@@ -175,6 +147,7 @@ public:
     const Microsoft::Console::Types::Viewport GetSize() const noexcept;
 
     void ScrollRows(const til::CoordType firstRow, const til::CoordType size, const til::CoordType delta);
+    void CopyRect(const til::rect& source, const til::point target);
 
     til::CoordType TotalRowCount() const noexcept;
 
@@ -326,11 +299,20 @@ public:
     };
 
     static void Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const Microsoft::Console::Types::Viewport* lastCharacterViewport = nullptr, PositionInformation* positionInfo = nullptr);
+    static void ReflowIncremental(std::unique_ptr<TextBuffer>& oldBuffer, TextBuffer& newBuffer, const Microsoft::Console::Types::Viewport* lastCharacterViewport, PositionInformation& positionInfo);
+    bool IsReflowPending() const noexcept;
+    bool ContinueReflow(til::CoordType rowBudget);
+    void FinishReflow();
 
     std::vector<til::point_span> SearchText(const std::wstring_view& needle, bool caseInsensitive) const;
     std::vector<til::point_span> SearchText(const std::wstring_view& needle, bool caseInsensitive, til::CoordType rowBeg, til::CoordType rowEnd) const;
 
-    const std::vector<ScrollMark>& GetMarks() const noexcept;
+    bool HasMarks() const noexcept;
+    std::vector<ScrollMark> GetMarks() const;
+    std::vector<ScrollMark> GetMarksInRange(const til::CoordType rowBeg, const til::CoordType rowEnd) const;
+    std::optional<ScrollMark> GetPreviousMark(const til::CoordType row) const;
+    std::optional<ScrollMark> GetNextMark(const til::CoordType row) const;
+    std::optional<ScrollMark> GetCurrentMark() const;
     void ClearMarksInRange(const til::point start, const til::point end);
     void ClearAllMarks() noexcept;
     void ScrollMarks(const int delta);
@@ -343,13 +325,34 @@ public:
 
 private:
     void _reserve(til::size screenBufferSize, const TextAttribute& defaultAttributes);
-    void _commit(const std::byte* row);
+    std::byte* _commit(size_t page);
     void _decommit() noexcept;
-    void _construct(const std::byte* until) noexcept;
-    void _destroy() const noexcept;
+    void _construct(std::byte* page, size_t rowCount, const TextAttribute& attributes) const noexcept;
+    void _destroy(size_t firstPage = 0) noexcept;
+    void _swapStorage(TextBuffer& other) noexcept;
+    size_t _getPageRowCount(size_t page) const noexcept;
     ROW& _getRowByOffsetDirect(size_t offset);
     ROW& _getRow(til::CoordType y) const;
+    ROW& _getScratchpadRow() const noexcept;
+    size_t _getRowOffset(til::CoordType y) const noexcept;
     til::CoordType _estimateOffsetOfLastCommittedRow() const noexcept;
+    bool _tryResizeInPlace(til::size newSize, til::CoordType srcRow, til::CoordType copyableRows);
+    bool _isChunkCold(size_t chunk) const noexcept;
+    void _freezeChunk(size_t chunk);
+    void _thawChunk(size_t chunk);
+    void _compactColdScrollback();
+    void _queueColdScrollback();
+    void _resetColdScrollback() noexcept;
+    std::vector<uint16_t> _getRowHyperlinks(size_t offset) const;
+    ROW& _getPendingReflowRow(til::CoordType y) const;
+    void _settlePendingReflow(til::CoordType rowBeg, til::CoordType rowEnd) const;
+    const ROW* _getLiveRow(til::CoordType y) const noexcept;
+    void _restoreRow(til::CoordType y, ROW& row) const;
+    static til::CoordType _reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, til::CoordType oldBegin, const Microsoft::Console::Types::Viewport* lastCharacterViewport, PositionInformation* positionInfo);
+    static til::CoordType _findReflowTail(TextBuffer& oldBuffer, const PositionInformation& positionInfo);
+    void _continueReflowUntil(til::CoordType y);
+    til::CoordType _reflowLine(const TextBuffer& oldBuffer, til::CoordType oldBegin, til::CoordType oldEnd, til::CoordType newY, bool measureOnly);
+    void _updateSearchIndex(TextBufferRowReader& reader, til::CoordType rowBeg, til::CoordType rowEnd) const;
 
     void _SetFirstRowIndex(const til::CoordType FirstRowIndex) noexcept;
     til::point _GetPreviousFromCursor() const;
@@ -364,9 +367,21 @@ private:
     til::point _GetWordEndForAccessibility(const til::point target, const std::wstring_view wordDelimiters, const til::point limit) const;
     til::point _GetWordEndForSelection(const til::point target, const std::wstring_view wordDelimiters) const;
     void _PruneHyperlinks();
-    void _trimMarksOutsideBuffer();
     std::tuple<til::CoordType, til::CoordType, bool> _RowCopyHelper(const CopyRequest& req, const til::CoordType iRow, const ROW& row) const;
 
+    // The markup that GenHTML() and GenRTF() write before and after each run of text with the same attribute.
+    struct RunMarkup
+    {
+        std::string prefix;
+        std::string_view suffix;
+    };
+    void _FormatRuns(const CopyRequest& req,
+                     std::string& output,
+                     const std::function<RunMarkup(const TextAttribute&)>& getRunMarkup,
+                     void (*appendText)(std::string&, const std::wstring_view&),
+                     const std::string_view lineBreak) const;
+
+    static void _AppendHTMLText(std::string& contentBuilder, const std::wstring_view& text);
     static void _AppendRTFText(std::string& contentBuilder, const std::wstring_view& text);
 
     Microsoft::Console::Render::Renderer& _renderer;
@@ -374,10 +389,15 @@ private:
     std::unordered_map<uint16_t, std::wstring> _hyperlinkMap;
     std::unordered_map<std::wstring, uint16_t> _hyperlinkCustomIdMap;
     uint16_t _currentHyperlinkId = 1;
-
-    // This block describes the state of the underlying virtual memory buffer that holds all ROWs, text and attributes.
-    // Initially memory is only allocated with MEM_RESERVE to reduce the private working set of conhost.
-    // ROWs are laid out like this in memory:
+    // Used by _PruneHyperlinks() to find the hyperlinks that are only referenced by the row that's being recycled.
+    // Just like _searchIndex, it's indexed by row offset and every write to a row marks it as dirty.
+    mutable HyperlinkRefCounts _hyperlinkRefCounts;
+
+    // This block describes the storage of all ROWs, text and attributes. ROWs are grouped into pages of
+    // _pageRowCount ROWs each, which are allocated from the process-wide RowPagePool. _pages is the directory
+    // that maps a row's offset to its page. This gives us O(1) lookups no matter how large the scrollback is,
+    // and allows us to grow, shrink and clear the buffer by handing out and taking back whole pages.
+    // Within each page the ROWs are laid out like this:
     //   ROW                <-- sizeof(ROW), stores
     //   (padding)
     //   ROW::_charsBuffer  <-- _width * sizeof(wchar_t)
@@ -387,34 +407,25 @@ private:
     //   ...
     // Padding may exist for alignment purposes.
     //
-    // The base (start) address of the memory arena.
-    wil::unique_virtualalloc_ptr<std::byte> _buffer;
-    // The past-the-end pointer of the memory arena.
-    std::byte* _bufferEnd = nullptr;
-    // The range between _buffer (inclusive) and _commitWatermark (exclusive) is the range of
-    // memory that has already been committed via MEM_COMMIT and contains ready-to-use ROWs.
-    //
-    // The problem is that calling VirtualAlloc(MEM_COMMIT) on each ROW one by one is extremely expensive, which forces
-    // us to commit ROWs in batches and avoid calling it on already committed ROWs. Let's say we commit memory in
-    // batches of 128 ROWs. One option to know whether a ROW has already been committed is to allocate a vector<uint8_t>
-    // of size `(height + 127) / 128` and mark the corresponding slot as 1 if that 128-sized batch has been committed.
-    // That way we know not to commit it again. But ROWs aren't accessed randomly. Instead, they're usually accessed
-    // fairly linearly from row 1 to N. As such we can just commit ROWs up to the point of the highest accessed ROW
-    // plus some read-ahead of 128 ROWs. This is exactly what _commitWatermark stores: The highest accessed ROW plus
-    // some read-ahead. It's the amount of memory that has been committed and is ready to use.
-    //
-    // _commitWatermark will always be a multiple of _bufferRowStride away from _buffer.
-    // In other words, _commitWatermark itself will either point exactly onto the next ROW
-    // that should be committed or be equal to _bufferEnd when all ROWs are committed.
-    std::byte* _commitWatermark = nullptr;
-    // This will MEM_COMMIT 128 rows more than we need, to avoid us from having to call VirtualAlloc too often.
-    // This equates to roughly the following commit chunk sizes at these column counts:
-    // *  80 columns (the usual minimum) =  60KB chunks,  4.1MB buffer at 9001 rows
-    // * 120 columns (the most common)   =  80KB chunks,  5.6MB buffer at 9001 rows
-    // * 400 columns (the usual maximum) = 220KB chunks, 15.5MB buffer at 9001 rows
+    // Page p stores the rows with the offsets [p * _pageRowCount + 1, (p + 1) * _pageRowCount + 1). The last page
+    // may store fewer rows, see _getPageRowCount(). Offset 0 is the scratchpad row which is stored separately.
+    // A null entry either hasn't been committed yet (if its index is >= _committedPages) or is frozen (see _coldChunks).
+    std::vector<std::byte*> _pages;
+    // Pages are committed in order, because ROWs are usually accessed fairly linearly from row 1 to N.
+    // This way we know that rows past _committedPages * _pageRowCount are still blank, without looking at them.
+    size_t _committedPages = 0;
+    // The size of each page in bytes. This is _pageRowCount * _bufferRowStride, unless the buffer is
+    // shorter than that, in which case it's just large enough for _height rows.
+    size_t _pageSize = 0;
+    // The scratchpad row returned by GetScratchpadRow(). It's a page of its own, just large enough for 1 row.
+    std::byte* _scratchpad = nullptr;
+    // Each page equates to roughly the following sizes at these column counts:
+    // *  80 columns (the usual minimum) =  60KB pages,  4.1MB buffer at 9001 rows
+    // * 120 columns (the most common)   =  80KB pages,  5.6MB buffer at 9001 rows
+    // * 400 columns (the usual maximum) = 220KB pages, 15.5MB buffer at 9001 rows
     // There's probably a better metric than this. (This comment was written when ROW had both,
     // a _chars array containing text and a _charOffsets array contain column-to-text indices.)
-    static constexpr size_t _commitReadAheadRowCount = 128;
+    static constexpr size_t _pageRowCount = 128;
     // Before TextBuffer was made to use virtual memory it initialized the entire memory arena with the initial
     // attributes right away. To ensure it continues to work the way it used to, this stores these initial attributes.
     TextAttribute _initialAttributes;
@@ -432,16 +443,85 @@ private:
     // The height of the buffer in rows, excluding the scratchpad row.
     uint16_t _height = 0;
 
+    // This block describes the cold scrollback tier. Each page in _pages forms a chunk. Once a chunk has
+    // scrolled more than _coldRowDistance rows above the bottom of the buffer, its ROWs are compacted into
+    // a ColdRowBlock (text at its real length, attributes as-is) and its page is returned to the RowPagePool.
+    // _getRowByOffsetDirect() restores a chunk transparently the moment any of its ROWs is accessed again.
+    //
+    // A non-null entry in _coldChunks means that the chunk is frozen. _coldChunks is empty until the first freeze.
+    std::vector<std::unique_ptr<ColdRowBlock>> _coldChunks;
+    // Chunks which are cold but weren't frozen when they crossed the _coldRowDistance threshold,
+    // because they were restored later on or because the buffer got resized. Each entry stores
+    // the _rotationCount from which on the chunk may be frozen again. See _compactColdScrollback().
+    std::deque<std::pair<size_t, uint64_t>> _coldCandidates;
+    size_t _frozenChunkCount = 0;
+    // The number of times IncrementCircularBuffer() has been called. Used as a clock for _coldCandidates.
+    uint64_t _rotationCount = 0;
+    static constexpr size_t _coldChunkRowCount = _pageRowCount;
+    // This should be comfortably larger than any viewport, since those rows are constantly being read.
+    static constexpr size_t _coldRowDistance = 1024;
+
+    // See ReflowIncremental(). The rows [0,newTop) of this buffer haven't been rewrapped yet. Until they are, they read
+    // as 1:1 copies of the old rows that end at oldEnd, clipped to our width. ContinueReflow() rewraps the old rows
+    // bottom-up, one logical line at a time, until either the old rows or the new rows run out.
+    struct PendingReflow
+    {
+        std::unique_ptr<TextBuffer> oldBuffer;
+        til::CoordType oldEnd = 0;
+        til::CoordType newTop = 0;
+        // For each row in the arena, the old row that _getPendingReflowRow() last copied into it.
+        std::vector<til::CoordType> materialized;
+    };
+    std::unique_ptr<PendingReflow> _pendingReflow;
+    // The number of rows above the viewport that ReflowIncremental() rewraps right away.
+    static constexpr til::CoordType _reflowTailRowCount = 512;
+    // ReflowIncremental() only defers the remaining rows if there are at least this many.
+    static constexpr til::CoordType _reflowDeferMinRowCount = 4096;
+
+    // Used by SearchText() to skip rows that can't contain the needle. It's allocated by the first search and
+    // indexed by row offset in the arena. Every write to a row marks it as dirty and the next search re-indexes it.
+    mutable TrigramIndex _searchIndex;
+
     TextAttribute _currentAttributes;
     til::CoordType _firstRow = 0; // indexes top row (not necessarily 0)
     uint64_t _lastMutationId = 0;
 
     Cursor _cursor;
-    std::vector<ScrollMark> _marks;
+    ScrollMarkStore _marks;
     bool _isActiveBuffer = false;
 
+    friend class TextBufferRowReader;
+
 #ifdef UNIT_TESTING
     friend class TextBufferTests;
     friend class UiaTextRangeTests;
 #endif
 };
+
+// Reads the rows of a TextBuffer without modifying it, unlike GetRowByOffset(). This makes it safe to use
+// from multiple threads at once, as long as the buffer isn't modified and no reflow is pending for the rows.
+// Rows that are frozen in the cold scrollback are restored into a few scratch rows instead of being thawed.
+class TextBufferRowReader final
+{
+public:
+    explicit TextBufferRowReader(const TextBuffer& buffer);
+
+    const TextBuffer& GetBuffer() const noexcept;
+    const ROW& GetRow(til::CoordType y);
+
+private:
+    struct Slot
+    {
+        std::unique_ptr<wchar_t[]> chars;
+        std::unique_ptr<uint16_t[]> charOffsets;
+        std::optional<ROW> row;
+        til::CoordType y = til::CoordTypeMin;
+        uint64_t lastUse = 0;
+    };
+
+    const TextBuffer& _buffer;
+    // A UText and the clone a regex makes of it each need the row they're currently at to stay valid,
+    // while the match positions are resolved through yet another row. The least recently used slot is reused.
+    std::array<Slot, 4> _slots;
+    uint64_t _clock = 0;
+};
@@ -805,6 +805,76 @@ class ReflowTests
             _compareTextBufferAgainstTestBuffer(*textBuffer, testBuffer);
         }
     }
+
+    static std::unique_ptr<TextBuffer> _textBufferWithScrollback(const til::size size)
+    {
+        auto buffer = std::make_unique<TextBuffer>(size, TextAttribute{ 0x7 }, 0, false, renderer);
+
+        for (til::CoordType y = 0; y < size.height; ++y)
+        {
+            // Every third row continues onto the next one, so that there are logical lines that span multiple rows.
+            const auto text = fmt::format(FMT_COMPILE(L"r{:05}-abcdefghijklm"), y);
+            RowWriteState state{ .text = text };
+            auto& row = buffer->GetMutableRowByOffset(y);
+            row.ReplaceText(state);
+            row.SetAttrToEnd(0, TextAttribute{ gsl::narrow_cast<WORD>(y % 16) });
+            row.SetWrapForced(y % 3 == 0);
+        }
+
+        buffer->GetCursor().SetPosition({ 0, size.height - 1 });
+        return buffer;
+    }
+
+    static void _compareRows(const TextBuffer& expected, const TextBuffer& actual, const til::CoordType beg, const til::CoordType end)
+    {
+        for (auto y = beg; y < end; ++y)
+        {
+            const auto& expectedRow = expected.GetRowByOffset(y);
+            const auto& actualRow = actual.GetRowByOffset(y);
+            const auto indexString = NoThrowString().Format(L"[Row %d]", y);
+            VERIFY_ARE_EQUAL(expectedRow.GetText(), actualRow.GetText(), indexString);
+            VERIFY_ARE_EQUAL(expectedRow.WasWrapForced(), actualRow.WasWrapForced(), indexString);
+            VERIFY_IS_TRUE(expectedRow.Attributes() == actualRow.Attributes(), indexString);
+        }
+    }
+
+    TEST_METHOD(TestReflowIncremental)
+    {
+        WEX::TestExecution::SetVerifyOutput verifyOutputScope{ WEX::TestExecution::VerifyOutputSettings::LogOnlyFailures };
+
+        static constexpr til::size oldSize{ 20, 6000 };
+        static constexpr til::size newSize{ 15, 6000 };
+        static constexpr til::CoordType viewportTop = 5970;
+
+        // Shrinking the buffer horizontally results in more rows than fit into the new buffer.
+        // In that case ReflowIncremental() should produce the exact same result as Reflow().
+        const auto expectedOld = _textBufferWithScrollback(oldSize);
+        const auto expected = std::make_unique<TextBuffer>(newSize, TextAttribute{ 0x7 }, 0, false, renderer);
+        TextBuffer::Reflow(*expectedOld, *expected);
+
+        auto actualOld = _textBufferWithScrollback(oldSize);
+        const auto actual = std::make_unique<TextBuffer>(newSize, TextAttribute{ 0x7 }, 0, false, renderer);
+        TextBuffer::PositionInformation positionInfo{
+            .mutableViewportTop = viewportTop,
+            .visibleViewportTop = viewportTop,
+        };
+        TextBuffer::ReflowIncremental(actualOld, *actual, nullptr, positionInfo);
+
+        VERIFY_IS_TRUE(actual->IsReflowPending());
+        VERIFY_IS_NULL(actualOld.get());
+        VERIFY_ARE_EQUAL(expected->GetCursor().GetPosition(), actual->GetCursor().GetPosition());
+
+        // The rows around the viewport must be final right away.
+        _compareRows(*expected, *actual, positionInfo.mutableViewportTop, newSize.height);
+
+        // ...and the rest of them once the reflow is done.
+        while (actual->ContinueReflow(1000))
+        {
+        }
+
+        VERIFY_IS_FALSE(actual->IsReflowPending());
+        _compareRows(*expected, *actual, 0, newSize.height);
+    }
 };
 
 DummyRenderer ReflowTests::renderer{};
@@ -5,6 +5,7 @@
 
 #include "../TerminalSettingsModel/ColorScheme.h"
 #include "../TerminalSettingsModel/CascadiaSettings.h"
+#include "../TerminalSettingsModel/IDynamicProfileGenerator.h"
 #include "JsonTestClass.h"
 #include "TestUtils.h"
 
@@ -76,7 +77,42 @@ namespace SettingsModelLocalTests
 
         TEST_METHOD(MigrateReloadEnvVars);
 
+        TEST_METHOD(GeneratorCacheRoundtrip);
+        TEST_METHOD(SettingsSnapshotRoundtrip);
+        TEST_METHOD(SettingsSnapshotColdVersusWarm);
+        TEST_METHOD(GeneratorCacheSkipsUnchangedGenerators);
+        TEST_METHOD(GeneratorCacheColdVersusWarm);
+
     private:
+        // Counts how often it had to generate its profiles, instead of scanning anything.
+        class StubProfileGenerator final : public IDynamicProfileGenerator
+        {
+        public:
+            std::wstring_view GetNamespace() const noexcept override
+            {
+                return L"Windows.Terminal.Stub";
+            }
+
+            void GenerateProfiles(std::vector<winrt::com_ptr<implementation::Profile>>& profiles) const override
+            {
+                generateCount.fetch_add(1, std::memory_order_relaxed);
+
+                static constexpr winrt::guid guid{ 0x7a0b7f55, 0x3c7e, 0x4d39, { 0x9b, 0x6e, 0x51, 0x2d, 0x8f, 0x0c, 0x46, 0x11 } };
+                auto profile = winrt::make_self<implementation::Profile>(guid);
+                profile->Name(L"Stub");
+                profile->Commandline(L"stub.exe");
+                profiles.emplace_back(std::move(profile));
+            }
+
+            std::wstring GetCacheKey() const override
+            {
+                return key;
+            }
+
+            std::wstring key;
+            mutable std::atomic<int> generateCount{ 0 };
+        };
+
         static winrt::com_ptr<implementation::CascadiaSettings> createSettings(const std::string_view& userJSON)
         {
             static constexpr std::string_view inboxJSON{ R"({
@@ -2058,4 +2094,293 @@ namespace SettingsModelLocalTests
         VERIFY_IS_TRUE(settings->ProfileDefaults().HasReloadEnvironmentVariables());
         VERIFY_IS_FALSE(settings->ProfileDefaults().ReloadEnvironmentVariables());
     }
+
+    void DeserializationTests::GeneratorCacheRoundtrip()
+    {
+        const auto cachePath = std::filesystem::temp_directory_path() / L"GeneratorCacheRoundtrip.json";
+        const auto cleanup = wil::scope_exit([&]() {
+            std::error_code ec;
+            std::filesystem::remove(cachePath, ec);
+        });
+        std::filesystem::remove(cachePath);
+
+        const auto writeCache = [&](const std::string_view& content) {
+            std::ofstream file{ cachePath, std::ios::binary | std::ios::trunc };
+            file.write(content.data(), content.size());
+        };
+
+        implementation::SettingsLoader cold{ std::string_view{}, DefaultJson };
+        cold.GenerateProfiles(cachePath);
+
+        // The PowerShell generator always returns a cache key, even if there's no pwsh installed.
+        VERIFY_IS_TRUE(std::filesystem::exists(cachePath));
+
+        const auto verifyProfiles = [&](const wchar_t* description) {
+            Log::Comment(description);
+
+            implementation::SettingsLoader warm{ std::string_view{}, DefaultJson };
+            warm.GenerateProfiles(cachePath);
+
+            const auto& expected = cold.inboxSettings.profiles;
+            const auto& actual = warm.inboxSettings.profiles;
+            VERIFY_ARE_EQUAL(expected.size(), actual.size());
+
+            for (size_t i = 0; i < expected.size(); ++i)
+            {
+                VERIFY_ARE_EQUAL(expected[i]->Guid(), actual[i]->Guid());
+                VERIFY_ARE_EQUAL(expected[i]->Name(), actual[i]->Name());
+                VERIFY_ARE_EQUAL(expected[i]->Source(), actual[i]->Source());
+                VERIFY_ARE_EQUAL(expected[i]->Commandline(), actual[i]->Commandline());
+                VERIFY_ARE_EQUAL(expected[i]->StartingDirectory(), actual[i]->StartingDirectory());
+                VERIFY_ARE_EQUAL(expected[i]->Icon(), actual[i]->Icon());
+                VERIFY_ARE_EQUAL(expected[i]->Hidden(), actual[i]->Hidden());
+                VERIFY_IS_TRUE(expected[i]->Origin() == actual[i]->Origin());
+            }
+        };
+
+        verifyProfiles(L"Profiles read from the cache should be identical to generated ones");
+
+        writeCache("{ \"version\": ");
+        verifyProfiles(L"A corrupted cache should be ignored");
+
+        const auto version = til::u16u8(implementation::CascadiaSettings::ApplicationVersion());
+        writeCache(fmt::format(R"({{
+            "version": "{}",
+            "generators": {{
+                "Windows.Terminal.PowershellCore": {{
+                    "key": "stale",
+                    "profiles": [ {{ "name": "Stale", "commandline": "stale.exe" }} ]
+                }}
+            }}
+        }})",
+                               version));
+        verifyProfiles(L"A cache entry whose key doesn't match should be ignored");
+    }
+
+    void DeserializationTests::SettingsSnapshotRoundtrip()
+    {
+        using Kind = SettingsSnapshot::LayerKind;
+
+        const auto path = std::filesystem::temp_directory_path() / L"SettingsSnapshotRoundtrip.snapshot";
+        const auto cleanup = wil::scope_exit([&]() {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        });
+        std::filesystem::remove(path);
+
+        // Every type of value, including strings with embedded NULs and 64-bit integers.
+        const auto user = VerifyParseSucceeded(R"({
+            "null": null,
+            "bools": [ true, false ],
+            "numbers": [ 0, -1, 9223372036854775807, 18446744073709551615, 0.5 ],
+            "strings": [ "", "abc", "\u0000x\u00e4" ],
+            "nested": { "empty array": [], "empty object": {}, "profiles": [ { "name": "A" } ] }
+        })");
+        const auto inbox = VerifyParseSucceeded(R"({ "profiles": [ { "name": "B" } ] })");
+        const std::array fragments{
+            SettingsSnapshot::Entry{ L"Fragment.A", VerifyParseSucceeded(R"({ "schemes": [ { "name": "C" } ] })") },
+            SettingsSnapshot::Entry{ L"Fragment.B", Json::Value{ Json::ValueType::objectValue } },
+        };
+
+        {
+            auto snapshot = SettingsSnapshot::Open(path, 1);
+            VERIFY_IS_FALSE(snapshot.ReadSingle(Kind::User, 2).has_value());
+            snapshot.UpdateSingle(Kind::User, 2, user);
+            snapshot.UpdateSingle(Kind::InBox, 3, inbox);
+            snapshot.Update(Kind::Fragments, 4, fragments);
+            snapshot.Save();
+        }
+
+        {
+            auto snapshot = SettingsSnapshot::Open(path, 1);
+
+            const auto actualUser = snapshot.ReadSingle(Kind::User, 2);
+            VERIFY_IS_TRUE(actualUser.has_value());
+            VERIFY_IS_TRUE(*actualUser == user);
+
+            const auto actualFragments = snapshot.Read(Kind::Fragments, 4);
+            VERIFY_IS_TRUE(actualFragments.has_value());
+            VERIFY_ARE_EQUAL(fragments.size(), actualFragments->size());
+            for (size_t i = 0; i < fragments.size(); ++i)
+            {
+                VERIFY_ARE_EQUAL(fragments[i].source, actualFragments->at(i).source);
+                VERIFY_IS_TRUE(fragments[i].json == actualFragments->at(i).json);
+            }
+
+            Log::Comment(L"A layer whose key doesn't match must be ignored");
+            VERIFY_IS_FALSE(snapshot.ReadSingle(Kind::InBox, 4).has_value());
+
+            Log::Comment(L"Updating a layer must keep the others");
+            snapshot.UpdateSingle(Kind::InBox, 5, inbox);
+            snapshot.Save();
+        }
+
+        {
+            const auto snapshot = SettingsSnapshot::Open(path, 1);
+            VERIFY_IS_TRUE(snapshot.ReadSingle(Kind::User, 2) == user);
+            VERIFY_IS_TRUE(snapshot.ReadSingle(Kind::InBox, 5) == inbox);
+            VERIFY_IS_TRUE(snapshot.Read(Kind::Fragments, 4).has_value());
+        }
+
+        Log::Comment(L"A snapshot from another build must be ignored");
+        VERIFY_IS_FALSE(SettingsSnapshot::Open(path, 2).ReadSingle(Kind::User, 2).has_value());
+
+        Log::Comment(L"A truncated snapshot must be ignored");
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+        const auto truncated = SettingsSnapshot::Open(path, 1);
+        VERIFY_IS_FALSE(truncated.Read(Kind::Fragments, 4).has_value());
+    }
+
+    // This is less of a test and more of a benchmark for the startup time.
+    // It parses and layers the default settings with and without the settings snapshot.
+    void DeserializationTests::SettingsSnapshotColdVersusWarm()
+    {
+        static constexpr auto iterations = 10;
+        const auto path = std::filesystem::temp_directory_path() / L"SettingsSnapshotColdVersusWarm.snapshot";
+        const auto cleanup = wil::scope_exit([&]() {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        });
+
+        std::vector<winrt::hstring> profileNames;
+        const auto measure = [&](bool cold) {
+            std::array<std::chrono::microseconds, iterations> durations;
+
+            for (auto& duration : durations)
+            {
+                if (cold)
+                {
+                    std::error_code ec;
+                    std::filesystem::remove(path, ec);
+                }
+
+                const auto beg = std::chrono::steady_clock::now();
+                implementation::SettingsLoader loader{ UserSettingsJson, DefaultJson, path };
+                loader.MergeInboxIntoUserSettings();
+                loader.FinalizeLayering();
+                loader.SaveSnapshot();
+                const auto settings = winrt::make_self<implementation::CascadiaSettings>(std::move(loader));
+                const auto end = std::chrono::steady_clock::now();
+                duration = std::chrono::duration_cast<std::chrono::microseconds>(end - beg);
+
+                // Cold and warm loads must result in the same profiles.
+                std::vector<winrt::hstring> names;
+                for (const auto& profile : settings->AllProfiles())
+                {
+                    names.emplace_back(profile.Name());
+                }
+                if (!profileNames.empty())
+                {
+                    VERIFY_IS_TRUE(profileNames == names);
+                }
+                profileNames = std::move(names);
+            }
+
+            std::sort(durations.begin(), durations.end());
+            return durations[iterations / 2];
+        };
+
+        const auto cold = measure(true);
+        const auto warm = measure(false);
+        Log::Comment(NoThrowString().Format(L"Loading the default settings, median of %d: cold %lldus, warm %lldus", iterations, cold.count(), warm.count()));
+    }
+
+    void DeserializationTests::GeneratorCacheSkipsUnchangedGenerators()
+    {
+        const auto cachePath = std::filesystem::temp_directory_path() / L"GeneratorCacheSkipsUnchangedGenerators.json";
+        const auto cleanup = wil::scope_exit([&]() {
+            std::error_code ec;
+            std::filesystem::remove(cachePath, ec);
+        });
+        std::filesystem::remove(cachePath);
+
+        StubProfileGenerator stub;
+        stub.key = L"1";
+        const IDynamicProfileGenerator* generators[]{ &stub };
+
+        const auto load = [&]() {
+            implementation::SettingsLoader loader{ std::string_view{}, DefaultJson };
+            const auto inboxProfiles = loader.inboxSettings.profiles.size();
+            loader._executeGenerators(generators, cachePath);
+
+            VERIFY_ARE_EQUAL(inboxProfiles + 1, loader.inboxSettings.profiles.size());
+            const auto& profile = loader.inboxSettings.profiles.back();
+            VERIFY_ARE_EQUAL(L"Stub", profile->Name());
+            VERIFY_ARE_EQUAL(L"stub.exe", profile->Commandline());
+            VERIFY_ARE_EQUAL(L"Windows.Terminal.Stub", profile->Source());
+        };
+
+        Log::Comment(L"A cold load must run the generator");
+        load();
+        VERIFY_ARE_EQUAL(1, stub.generateCount.load());
+
+        Log::Comment(L"A warm load with an unchanged key must reuse the cached profiles");
+        load();
+        VERIFY_ARE_EQUAL(1, stub.generateCount.load());
+
+        Log::Comment(L"A changed key must run the generator again");
+        stub.key = L"2";
+        load();
+        VERIFY_ARE_EQUAL(2, stub.generateCount.load());
+
+        Log::Comment(L"A generator without a key must always run");
+        stub.key.clear();
+        load();
+        load();
+        VERIFY_ARE_EQUAL(4, stub.generateCount.load());
+    }
+
+    // This is less of a test and more of a benchmark for the startup time.
+    // It runs the same steps as LoadAll() with and without the generator cache, using the real generators.
+    // The cache is kept in the temp directory and the user's settings are never read or written.
+    void DeserializationTests::GeneratorCacheColdVersusWarm()
+    {
+        static constexpr auto iterations = 10;
+        const auto cachePath = std::filesystem::temp_directory_path() / L"GeneratorCacheColdVersusWarm.json";
+        const auto cleanup = wil::scope_exit([&]() {
+            std::error_code ec;
+            std::filesystem::remove(cachePath, ec);
+        });
+
+        uint32_t profileCount = 0;
+        const auto measure = [&](bool cold) {
+            std::array<std::chrono::microseconds, iterations> durations;
+
+            for (auto& duration : durations)
+            {
+                if (cold)
+                {
+                    std::error_code ec;
+                    std::filesystem::remove(cachePath, ec);
+                }
+
+                const auto beg = std::chrono::steady_clock::now();
+                implementation::SettingsLoader loader{ UserSettingsJson, DefaultJson };
+                loader.GenerateProfiles(cachePath);
+                loader.MergeInboxIntoUserSettings();
+                loader.FinalizeLayering();
+                const auto settings = winrt::make_self<implementation::CascadiaSettings>(std::move(loader));
+                const auto end = std::chrono::steady_clock::now();
+                duration = std::chrono::duration_cast<std::chrono::microseconds>(end - beg);
+
+                // Cold and warm loads must result in the same profiles.
+                const auto count = settings->AllProfiles().Size();
+                if (profileCount)
+                {
+                    VERIFY_ARE_EQUAL(profileCount, count);
+                }
+                profileCount = count;
+            }
+
+            std::sort(durations.begin(), durations.end());
+            return durations[iterations / 2];
+        };
+
+        // The first round warms up the file system cache.
+        std::ignore = measure(true);
+
+        const auto cold = measure(true);
+        const auto warm = measure(false);
+        Log::Comment(NoThrowString().Format(L"Loading the settings, median of %d: cold %lldus, warm %lldus", iterations, cold.count(), warm.count()));
+    }
 }
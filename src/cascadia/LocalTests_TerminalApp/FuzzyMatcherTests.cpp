@@ -0,0 +1,280 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "../TerminalApp/FuzzyMatcher.h"
+
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+using namespace WEX::Common;
+using namespace ::TerminalApp;
+
+namespace TerminalAppLocalTests
+{
+    class FuzzyMatcherTests
+    {
+        TEST_CLASS(FuzzyMatcherTests);
+
+        TEST_METHOD(VerifyMatching);
+        TEST_METHOD(VerifyWeight);
+        TEST_METHOD(VerifyRefinement);
+        TEST_METHOD(VerifyRefinementAfterCandidateChange);
+        TEST_METHOD(VerifySortPage);
+        TEST_METHOD(TenThousandEntries);
+
+    private:
+        static std::vector<FuzzyMatcher::Candidate> _makeCandidates(std::span<const std::wstring_view> texts)
+        {
+            std::vector<FuzzyMatcher::Candidate> candidates;
+            candidates.reserve(texts.size());
+            for (const auto text : texts)
+            {
+                candidates.emplace_back(text);
+            }
+            return candidates;
+        }
+
+        static std::vector<const FuzzyMatcher::Candidate*> _pointers(const std::vector<FuzzyMatcher::Candidate>& candidates)
+        {
+            std::vector<const FuzzyMatcher::Candidate*> pointers;
+            pointers.reserve(candidates.size());
+            for (const auto& candidate : candidates)
+            {
+                pointers.push_back(&candidate);
+            }
+            return pointers;
+        }
+
+        static void _verifyIndices(std::initializer_list<uint32_t> expected, const std::vector<FuzzyMatcher::Match>& actual)
+        {
+            VERIFY_ARE_EQUAL(expected.size(), actual.size());
+            for (size_t i = 0; i < actual.size(); ++i)
+            {
+                VERIFY_ARE_EQUAL(expected.begin()[i], actual[i].index);
+            }
+        }
+
+        static void _verifyMatches(const std::vector<FuzzyMatcher::Match>& expected, const std::vector<FuzzyMatcher::Match>& actual)
+        {
+            VERIFY_ARE_EQUAL(expected.size(), actual.size());
+            for (size_t i = 0; i < actual.size(); ++i)
+            {
+                VERIFY_ARE_EQUAL(expected[i].index, actual[i].index);
+                VERIFY_ARE_EQUAL(expected[i].weight, actual[i].weight);
+            }
+        }
+    };
+
+    void FuzzyMatcherTests::VerifyMatching()
+    {
+        static constexpr std::wstring_view texts[]{
+            L"New Tab",
+            L"Close Tab",
+            L"Close Pane",
+            L"[-] Split Horizontal",
+            L"[ | ] Split Vertical",
+            L"Open Settings",
+        };
+        const auto candidates = _makeCandidates(texts);
+        const auto pointers = _pointers(candidates);
+
+        FuzzyMatcher matcher;
+
+        Log::Comment(L"An empty query matches everything");
+        VERIFY_ARE_EQUAL(6u, matcher.Filter(pointers, L"").size());
+
+        Log::Comment(L"Matching is case-insensitive and the characters don't need to be consecutive");
+        _verifyIndices({ 3, 4 }, matcher.Filter(pointers, L"SPL"));
+        _verifyIndices({ 4 }, matcher.Filter(pointers, L"sv"));
+
+        Log::Comment(L"The characters must appear in order");
+        VERIFY_ARE_EQUAL(0u, matcher.Filter(pointers, L"vs").size());
+
+        Log::Comment(L"Characters that appear in no candidate are rejected");
+        VERIFY_ARE_EQUAL(0u, matcher.Filter(pointers, L"xyz").size());
+
+        Log::Comment(L"Punctuation is matched as well");
+        _verifyIndices({ 4 }, matcher.Filter(pointers, L"|"));
+    }
+
+    void FuzzyMatcherTests::VerifyWeight()
+    {
+        std::vector<size_t> positions;
+        const auto weigh = [&](std::wstring_view text, std::wstring_view query) {
+            const auto folded = FuzzyMatcher::Fold(text);
+            VERIFY_IS_TRUE(FuzzyMatcher::FindPositions(folded, FuzzyMatcher::Fold(query), positions));
+            return FuzzyMatcher::ComputeWeight(folded, positions);
+        };
+
+        // These match the weights FilteredCommandTests expects.
+        VERIFY_ARE_EQUAL(0, weigh(L"AAAAAABBBBBBCCC", L""));
+        VERIFY_ARE_EQUAL(30, weigh(L"AAAAAABBBBBBCCC", L"AAAAAABBBBBBCCC"));
+        VERIFY_ARE_EQUAL(2, weigh(L"AAAAAABBBBBBCCC", L"a"));
+        VERIFY_ARE_EQUAL(3, weigh(L"AAAAAABBBBBBCCC", L"ab"));
+
+        // A match at the beginning of a word scores higher.
+        VERIFY_IS_GREATER_THAN(weigh(L"Split Pane", L"sp"), weigh(L"Close Pane", L"sp"));
+    }
+
+    void FuzzyMatcherTests::VerifyRefinement()
+    {
+        static constexpr std::wstring_view texts[]{
+            L"ssh user@alpha",
+            L"ssh admin@beta",
+            L"Split Pane",
+            L"Set Color Scheme",
+            L"Toggle Pane Zoom",
+        };
+        const auto candidates = _makeCandidates(texts);
+        const auto pointers = _pointers(candidates);
+
+        FuzzyMatcher incremental;
+        std::wstring query;
+        for (const auto ch : std::wstring_view{ L"spa" })
+        {
+            query.push_back(ch);
+
+            FuzzyMatcher fresh;
+            Log::Comment(NoThrowString().Format(L"Query \"%s\"", query.c_str()));
+            _verifyMatches(fresh.Filter(pointers, query), incremental.Filter(pointers, query));
+        }
+
+        Log::Comment(L"Deleting a character must bring back the candidates that were filtered out");
+        _verifyIndices({ 0, 1, 2, 3 }, incremental.Filter(pointers, L"s"));
+
+        Log::Comment(L"A different list of candidates must not be refined");
+        const std::span<const FuzzyMatcher::Candidate* const> subset{ pointers.data() + 2, 3 };
+        _verifyIndices({ 0, 1 }, incremental.Filter(subset, L"s"));
+    }
+
+    void FuzzyMatcherTests::VerifyRefinementAfterCandidateChange()
+    {
+        static constexpr std::wstring_view texts[]{
+            L"Windows PowerShell",
+            L"Command Prompt",
+        };
+        auto candidates = _makeCandidates(texts);
+        const auto pointers = _pointers(candidates);
+
+        FuzzyMatcher matcher;
+        _verifyIndices({ 0, 1 }, matcher.Filter(pointers, L"p"));
+        _verifyIndices({ 0 }, matcher.Filter(pointers, L"pw"));
+
+        Log::Comment(L"A candidate changing its text (like a tab title) must be considered again");
+        candidates[1] = FuzzyMatcher::Candidate{ L"Command Prompt - pwsh" };
+        _verifyIndices({ 0, 1 }, matcher.Filter(pointers, L"pws"));
+    }
+
+    void FuzzyMatcherTests::VerifySortPage()
+    {
+        static constexpr size_t page = 256;
+
+        std::vector<FuzzyMatcher::Match> matches;
+        for (uint32_t i = 0; i < 10000; ++i)
+        {
+            matches.push_back({ i, static_cast<int>((i * 7919) % 101) });
+        }
+
+        const auto less = [](const auto& first, const auto& second) {
+            return first.weight != second.weight ? first.weight > second.weight : first.index < second.index;
+        };
+
+        auto expected = matches;
+        std::sort(expected.begin(), expected.end(), less);
+
+        Log::Comment(L"The first page must be sorted and no match may be dropped");
+        FuzzyMatcher::SortPage(matches, page, less);
+        VERIFY_ARE_EQUAL(expected.size(), matches.size());
+        for (size_t i = 0; i < page; ++i)
+        {
+            VERIFY_ARE_EQUAL(expected[i].index, matches[i].index);
+        }
+
+        Log::Comment(L"Sorting the remaining matches must result in the same order as a full sort");
+        FuzzyMatcher::SortRemaining(matches, page, less);
+        _verifyMatches(expected, matches);
+
+        Log::Comment(L"A page larger than the list must sort the entire list");
+        std::vector<FuzzyMatcher::Match> few{ { 0, 1 }, { 1, 3 }, { 2, 2 } };
+        FuzzyMatcher::SortPage(few, page, less);
+        FuzzyMatcher::SortRemaining(few, page, less);
+        _verifyIndices({ 1, 2, 0 }, few);
+    }
+
+    // This is less of a test and more of a benchmark for typing into the command palette.
+    // It compares filtering 10k entries from scratch on every keystroke with refining the previous results.
+    // It then compares sorting all matches of a broad query with sorting only the first page.
+    void FuzzyMatcherTests::TenThousandEntries()
+    {
+        static constexpr auto count = 10000;
+        static constexpr std::wstring_view verbs[]{ L"ssh", L"Split", L"Close", L"Open", L"Toggle", L"Set", L"Move", L"Run" };
+        static constexpr std::wstring_view nouns[]{ L"Pane", L"Tab", L"Settings", L"Color Scheme", L"Focus Mode", L"Profile", L"Window", L"Host" };
+
+        std::vector<std::wstring> texts;
+        texts.reserve(count);
+        for (auto i = 0; i < count; ++i)
+        {
+            texts.emplace_back(fmt::format(FMT_COMPILE(L"{} {} {}@server-{}.contoso.com"), verbs[i % std::size(verbs)], nouns[(i / 7) % std::size(nouns)], i % 113, i));
+        }
+
+        std::vector<FuzzyMatcher::Candidate> candidates;
+        candidates.reserve(count);
+        for (const auto& text : texts)
+        {
+            candidates.emplace_back(text);
+        }
+        const auto pointers = _pointers(candidates);
+
+        const auto less = [&](const auto& first, const auto& second) {
+            return FuzzyMatcher::CompareMatches(first, second, pointers);
+        };
+
+        static constexpr std::wstring_view typed{ L"spl pane 42" };
+        const auto measure = [&](bool refine) {
+            FuzzyMatcher matcher;
+            std::vector<FuzzyMatcher::Match> top;
+
+            const auto beg = std::chrono::steady_clock::now();
+            for (size_t i = 1; i <= typed.size(); ++i)
+            {
+                if (!refine)
+                {
+                    matcher.Invalidate();
+                }
+                top = matcher.Filter(pointers, typed.substr(0, i));
+                FuzzyMatcher::SortPage(top, 256, less);
+            }
+            const auto end = std::chrono::steady_clock::now();
+
+            return std::pair{ std::chrono::duration_cast<std::chrono::microseconds>(end - beg), top };
+        };
+
+        const auto [scratch, scratchTop] = measure(false);
+        const auto [refined, refinedTop] = measure(true);
+
+        _verifyMatches(scratchTop, refinedTop);
+
+        Log::Comment(NoThrowString().Format(L"Typing %zu characters into %d entries: from scratch %lldus, refined %lldus", typed.size(), count, scratch.count(), refined.count()));
+
+        // "pane" matches far more entries than fit on the first page.
+        FuzzyMatcher matcher;
+        const auto broad = matcher.Filter(pointers, L"pane");
+        VERIFY_IS_GREATER_THAN(broad.size(), size_t{ 256 });
+
+        auto full = broad;
+        auto beg = std::chrono::steady_clock::now();
+        std::sort(full.begin(), full.end(), less);
+        const auto fullSort = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - beg);
+
+        auto paged = broad;
+        beg = std::chrono::steady_clock::now();
+        FuzzyMatcher::SortPage(paged, 256, less);
+        const auto pageSort = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - beg);
+
+        // The matches past the first page must still be reachable and in order once they're sorted.
+        FuzzyMatcher::SortRemaining(paged, 256, less);
+        _verifyMatches(full, paged);
+
+        Log::Comment(NoThrowString().Format(L"Sorting %zu matches: all %lldus, first page %lldus", broad.size(), fullSort.count(), pageSort.count()));
+    }
+}
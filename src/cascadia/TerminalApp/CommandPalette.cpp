@@ -108,6 +108,13 @@ namespace winrt::TerminalApp::implementation
     void CommandPalette::SelectNextItem(const bool moveDown)
     {
         auto selected = _filteredActionsView().SelectedIndex();
+
+        // Moving past the last item or wrapping around to it needs the rest of the matches.
+        if (selected == (moveDown ? ::base::saturated_cast<int>(_filteredActions.Size()) - 1 : 0))
+        {
+            _appendPendingActions();
+        }
+
         const auto numItems = ::base::saturated_cast<int>(_filteredActionsView().Items().Size());
 
         // Do not try to select an item if
@@ -188,6 +195,10 @@ namespace winrt::TerminalApp::implementation
     {
         auto selected = _filteredActionsView().SelectedIndex();
         auto numVisibleItems = _getNumVisibleItems();
+        if (selected + numVisibleItems >= _filteredActions.Size())
+        {
+            _appendPendingActions();
+        }
         _scrollToIndex(selected + numVisibleItems);
     }
 
@@ -210,6 +221,7 @@ namespace winrt::TerminalApp::implementation
     // - <none>
     void CommandPalette::ScrollToBottom()
     {
+        _appendPendingActions();
         _scrollToIndex(_filteredActionsView().Items().Size() - 1);
     }
 
@@ -861,7 +873,8 @@ namespace winrt::TerminalApp::implementation
 
         if (_currentMode == CommandPaletteMode::TabSearchMode || _currentMode == CommandPaletteMode::ActionMode)
         {
-            const auto currentNeedleHasResults{ _filteredActions.Size() > 0 };
+            const auto matchCount{ _filteredActions.Size() + _pendingActions.Size() };
+            const auto currentNeedleHasResults{ matchCount > 0 };
             _noMatchesText().Visibility(currentNeedleHasResults ? Visibility::Collapsed : Visibility::Visible);
             if (auto automationPeer{ Automation::Peers::FrameworkElementAutomationPeer::FromElement(_searchBox()) })
             {
@@ -869,7 +882,7 @@ namespace winrt::TerminalApp::implementation
                     Automation::Peers::AutomationNotificationKind::ActionCompleted,
                     Automation::Peers::AutomationNotificationProcessing::ImportantMostRecent,
                     currentNeedleHasResults ?
-                        winrt::hstring{ fmt::format(std::wstring_view{ RS_(L"CommandPalette_MatchesAvailable") }, _filteredActions.Size()) } :
+                        winrt::hstring{ fmt::format(std::wstring_view{ RS_(L"CommandPalette_MatchesAvailable") }, matchCount) } :
                         NoMatchesText(), // what to announce if results were found
                     L"CommandPaletteResultAnnouncement" /* unique name for this group of notifications */);
             }
@@ -1074,6 +1087,7 @@ namespace winrt::TerminalApp::implementation
     std::vector<winrt::TerminalApp::FilteredCommand> CommandPalette::_collectFilteredActions()
     {
         std::vector<winrt::TerminalApp::FilteredCommand> actions;
+        _pendingActions = {};
 
         winrt::hstring searchText{ _getTrimmedInput() };
 
@@ -1085,25 +1099,10 @@ namespace winrt::TerminalApp::implementation
         }
         else if (_currentMode == CommandPaletteMode::TabSearchMode || _currentMode == CommandPaletteMode::ActionMode || _currentMode == CommandPaletteMode::CommandlineMode)
         {
-            for (const auto& action : commandsToFilter)
-            {
-                // Update filter for all commands
-                // This will modify the highlighting but will also lead to re-computation of weight (and consequently sorting).
-                // Pay attention that it already updates the highlighting in the UI
-                action.UpdateFilter(searchText);
-
-                // if there is active search we skip commands with 0 weight
-                if (searchText.empty() || action.Weight() > 0)
-                {
-                    actions.push_back(action);
-                }
-            }
-        }
-
-        // We want to present the commands sorted
-        if (_currentMode == CommandPaletteMode::ActionMode)
-        {
-            std::sort(actions.begin(), actions.end(), FilteredCommand::Compare);
+            // We want to present the commands sorted
+            const auto sortByWeight = _currentMode == CommandPaletteMode::ActionMode;
+            // Only the first page is sorted. The rest is sorted once the list is scrolled past it.
+            actions = FilteredCommand::FilterCommands(_matcher, commandsToFilter, searchText, sortByWeight, &_pendingActions);
         }
 
         return actions;
@@ -1155,6 +1154,26 @@ namespace winrt::TerminalApp::implementation
         }
     }
 
+    // Method Description:
+    // - Appends the matches that _collectFilteredActions left out, because
+    //   they're past the first page. They're sorted at this point.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void CommandPalette::_appendPendingActions()
+    {
+        if (_pendingActions.Size() == 0)
+        {
+            return;
+        }
+
+        for (const auto& action : _pendingActions.Take())
+        {
+            _filteredActions.Append(action);
+        }
+    }
+
     // Method Description:
     // - Update the list of current nested commands to match that of the
     //   given parent command.
@@ -1290,6 +1309,18 @@ namespace winrt::TerminalApp::implementation
         else
         {
             itemContainer.DataContext(args.Item());
+
+            // The last item is being shown, so the user scrolled past the first page.
+            // The list can't be modified while it's being laid out, so this is deferred.
+            if (_pendingActions.Size() != 0 && args.ItemIndex() + 1 >= ::base::saturated_cast<int>(_filteredActions.Size()))
+            {
+                Dispatcher().RunAsync(CoreDispatcherPriority::Low, [weak = get_weak()]() {
+                    if (auto self{ weak.get() })
+                    {
+                        self->_appendPendingActions();
+                    }
+                });
+            }
         }
     }
 
@@ -24,7 +24,8 @@ namespace winrt::TerminalApp::implementation
     FilteredCommand::FilteredCommand(const winrt::TerminalApp::PaletteItem& item) :
         _Item(item),
         _Filter(L""),
-        _Weight(0)
+        _Weight(0),
+        _searchCandidate{ item.Name() }
     {
         _HighlightedName = _computeHighlightedName();
 
@@ -33,6 +34,7 @@ namespace winrt::TerminalApp::implementation
             auto filteredCommand{ weakThis.get() };
             if (filteredCommand && e.PropertyName() == L"Name")
             {
+                filteredCommand->_searchCandidate = ::TerminalApp::FuzzyMatcher::Candidate{ filteredCommand->_Item.Name() };
                 filteredCommand->HighlightedName(filteredCommand->_computeHighlightedName());
                 filteredCommand->Weight(filteredCommand->_computeWeight());
             }
@@ -51,6 +53,13 @@ namespace winrt::TerminalApp::implementation
         }
     }
 
+    // Method Description:
+    // - Returns the precomputed data used by FuzzyMatcher to match the item name.
+    const ::TerminalApp::FuzzyMatcher::Candidate& FilteredCommand::SearchCandidate() const noexcept
+    {
+        return _searchCandidate;
+    }
+
     // Method Description:
     // - Looks up the filter characters within the item name.
     // Iterating through the filter and the item name it tries to associate the next filter character
@@ -66,85 +75,44 @@ namespace winrt::TerminalApp::implementation
     //
     // E.g., ("CL", true) ("ose ", false), ("T", true), ("ab", false), ("S", true), ("after this", false)
     //
-    // TODO: we probably need to merge this logic with _getWeight computation?
-    //
     // Return Value:
     // - The HighlightedText object initialized with the segments computed according to the algorithm above.
     winrt::TerminalApp::HighlightedText FilteredCommand::_computeHighlightedName()
     {
         const auto segments = winrt::single_threaded_observable_vector<winrt::TerminalApp::HighlightedTextSegment>();
-        auto commandName = _Item.Name();
-        auto isProcessingMatchedSegment = false;
-        uint32_t nextOffsetToReport = 0;
-        uint32_t currentOffset = 0;
+        const auto commandName = _Item.Name();
+        const std::wstring_view name{ commandName };
+
+        // GH#9941: search should be locale-aware as well
+        // We use the same matching as the palettes use when filtering to guarantee consistent behavior.
+        // If there are unmatched filter characters, no positions are returned and the entire name is unmatched.
+        std::vector<size_t> positions;
+        ::TerminalApp::FuzzyMatcher::FindPositions(_searchCandidate.folded, ::TerminalApp::FuzzyMatcher::Fold(_Filter), positions);
 
-        for (const auto searchChar : _Filter)
+        size_t offset = 0;
+        for (size_t i = 0; i < positions.size();)
         {
-            const WCHAR searchCharAsString[] = { searchChar, L'\0' };
-            while (true)
+            // Consecutive matched characters form a single highlighted segment.
+            const auto matchStart = positions[i];
+            auto matchEnd = matchStart + 1;
+            for (++i; i < positions.size() && positions[i] == matchEnd; ++i)
             {
-                if (currentOffset == commandName.size())
-                {
-                    // There are still unmatched filter characters but we finished scanning the name.
-                    // In this case we return the entire item name as unmatched
-                    auto entireNameSegment{ winrt::make<HighlightedTextSegment>(commandName, false) };
-                    segments.Clear();
-                    segments.Append(entireNameSegment);
-                    return winrt::make<HighlightedText>(segments);
-                }
-
-                // GH#9941: search should be locale-aware as well
-                // We use the same comparison method as upon sorting to guarantee consistent behavior
-                const WCHAR currentCharAsString[] = { commandName[currentOffset], L'\0' };
-                auto isCurrentCharMatched = lstrcmpi(searchCharAsString, currentCharAsString) == 0;
-                if (isProcessingMatchedSegment != isCurrentCharMatched)
-                {
-                    // We reached the end of the region (matched character came after a series of unmatched or vice versa).
-                    // Conclude the segment and add it to the list.
-                    // Skip segment if it is empty (might happen when the first character of the name is matched)
-                    auto sizeToReport = currentOffset - nextOffsetToReport;
-                    if (sizeToReport > 0)
-                    {
-                        winrt::hstring segment{ commandName.data() + nextOffsetToReport, sizeToReport };
-                        auto highlightedSegment{ winrt::make<HighlightedTextSegment>(segment, isProcessingMatchedSegment) };
-                        segments.Append(highlightedSegment);
-                        nextOffsetToReport = currentOffset;
-                    }
-                    isProcessingMatchedSegment = isCurrentCharMatched;
-                }
-
-                currentOffset++;
-
-                if (isCurrentCharMatched)
-                {
-                    // We have matched this filter character, let's move to matching the next filter char
-                    break;
-                }
+                ++matchEnd;
             }
-        }
 
-        // Either the filter or the item name were fully processed.
-        // If we were in the middle of the matched segment - add it.
-        if (isProcessingMatchedSegment)
-        {
-            auto sizeToReport = currentOffset - nextOffsetToReport;
-            if (sizeToReport > 0)
+            if (matchStart > offset)
             {
-                winrt::hstring segment{ commandName.data() + nextOffsetToReport, sizeToReport };
-                auto highlightedSegment{ winrt::make<HighlightedTextSegment>(segment, true) };
-                segments.Append(highlightedSegment);
-                nextOffsetToReport = currentOffset;
+                segments.Append(winrt::make<HighlightedTextSegment>(winrt::hstring{ name.substr(offset, matchStart - offset) }, false));
             }
+            segments.Append(winrt::make<HighlightedTextSegment>(winrt::hstring{ name.substr(matchStart, matchEnd - matchStart) }, true));
+            offset = matchEnd;
         }
 
         // Now create a segment for all remaining characters.
         // We will have remaining characters as long as the filter is shorter than the item name.
-        auto sizeToReport = commandName.size() - nextOffsetToReport;
-        if (sizeToReport > 0)
+        if (offset < name.size())
         {
-            winrt::hstring segment{ commandName.data() + nextOffsetToReport, sizeToReport };
-            auto highlightedSegment{ winrt::make<HighlightedTextSegment>(segment, false) };
-            segments.Append(highlightedSegment);
+            segments.Append(winrt::make<HighlightedTextSegment>(winrt::hstring{ name.substr(offset) }, false));
         }
 
         return winrt::make<HighlightedText>(segments);
@@ -239,4 +207,108 @@ namespace winrt::TerminalApp::implementation
 
         return firstWeight > secondWeight;
     }
+
+    // Function Description:
+    // - Produces the list of commands matching the given filter, shared by the
+    //   CommandPalette and the SuggestionsControl. The highlighting and weight
+    //   are only updated for the commands that are returned.
+    // - When sorting by weight with a non-null `pending`, only the first PageSize
+    //   matches are sorted and returned. The remaining ones are stored in
+    //   `pending`, which sorts them once they're taken.
+    // Arguments:
+    // - matcher: the matcher used for the previous filter of the same list, so
+    //   that it can refine its previous results
+    // - commands: the commands to filter
+    // - filter: the search text
+    // - sortByWeight: if true, the results are ordered like Compare. Otherwise
+    //   they retain their original order.
+    // - pending: optionally receives the matches past the first page
+    // Return Value:
+    // - the matching commands
+    std::vector<winrt::TerminalApp::FilteredCommand> FilteredCommand::FilterCommands(::TerminalApp::FuzzyMatcher& matcher,
+                                                                                     const Collections::IVector<winrt::TerminalApp::FilteredCommand>& commands,
+                                                                                     const winrt::hstring& filter,
+                                                                                     bool sortByWeight,
+                                                                                     PendingCommands* pending)
+    {
+        if (pending)
+        {
+            *pending = {};
+        }
+
+        std::vector<winrt::TerminalApp::FilteredCommand> allCommands(commands.Size(), nullptr);
+        commands.GetMany(0, allCommands);
+
+        std::vector<const ::TerminalApp::FuzzyMatcher::Candidate*> candidates;
+        candidates.reserve(allCommands.size());
+        for (const auto& command : allCommands)
+        {
+            candidates.push_back(&winrt::get_self<FilteredCommand>(command)->_searchCandidate);
+        }
+
+        auto matches = matcher.Filter(candidates, filter);
+        const auto less = [&](const auto& first, const auto& second) {
+            return ::TerminalApp::FuzzyMatcher::CompareMatches(first, second, candidates);
+        };
+
+        auto count = matches.size();
+        if (sortByWeight)
+        {
+            if (pending)
+            {
+                count = std::min(count, PageSize);
+            }
+            ::TerminalApp::FuzzyMatcher::SortPage(matches, count, less);
+        }
+
+        std::vector<winrt::TerminalApp::FilteredCommand> results;
+        results.reserve(count);
+        for (const auto& match : std::span{ matches }.first(count))
+        {
+            // This updates the highlighting in the UI.
+            auto& command = allCommands[match.index];
+            command.UpdateFilter(filter);
+            results.push_back(command);
+        }
+
+        if (count < matches.size())
+        {
+            pending->_commands = std::move(allCommands);
+            pending->_candidates = std::move(candidates);
+            pending->_matches = std::move(matches);
+            pending->_filter = filter;
+        }
+
+        return results;
+    }
+
+    size_t FilteredCommand::PendingCommands::Size() const noexcept
+    {
+        return _matches.size() > PageSize ? _matches.size() - PageSize : 0;
+    }
+
+    // Method Description:
+    // - Sorts the matches past the first page and returns their commands.
+    //   Afterwards this is empty.
+    // Return Value:
+    // - the remaining matching commands, in the order following the first page
+    std::vector<winrt::TerminalApp::FilteredCommand> FilteredCommand::PendingCommands::Take()
+    {
+        const auto less = [&](const auto& first, const auto& second) {
+            return ::TerminalApp::FuzzyMatcher::CompareMatches(first, second, _candidates);
+        };
+        ::TerminalApp::FuzzyMatcher::SortRemaining(_matches, PageSize, less);
+
+        std::vector<winrt::TerminalApp::FilteredCommand> results;
+        results.reserve(Size());
+        for (const auto& match : std::span{ _matches }.subspan(std::min(PageSize, _matches.size())))
+        {
+            auto& command = _commands[match.index];
+            command.UpdateFilter(_filter);
+            results.push_back(command);
+        }
+
+        *this = {};
+        return results;
+    }
 }
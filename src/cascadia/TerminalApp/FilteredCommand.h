@@ -4,6 +4,7 @@
 #pragma once
 
 #include "HighlightedTextControl.h"
+#include "FuzzyMatcher.h"
 #include "FilteredCommand.g.h"
 
 // fwdecl unittest classes
@@ -21,7 +22,34 @@ namespace winrt::TerminalApp::implementation
 
         void UpdateFilter(const winrt::hstring& filter);
 
+        // When sorting by weight, FilterCommands only sorts the first PageSize matches.
+        // The remaining ones are only sorted once the list is scrolled past that page.
+        static constexpr size_t PageSize{ 256 };
+
+        // The matches FilterCommands didn't return, because they're past the first page.
+        class PendingCommands
+        {
+        public:
+            size_t Size() const noexcept;
+            std::vector<winrt::TerminalApp::FilteredCommand> Take();
+
+        private:
+            std::vector<winrt::TerminalApp::FilteredCommand> _commands;
+            std::vector<const ::TerminalApp::FuzzyMatcher::Candidate*> _candidates;
+            std::vector<::TerminalApp::FuzzyMatcher::Match> _matches;
+            winrt::hstring _filter;
+
+            friend struct FilteredCommand;
+        };
+
         static int Compare(const winrt::TerminalApp::FilteredCommand& first, const winrt::TerminalApp::FilteredCommand& second);
+        static std::vector<winrt::TerminalApp::FilteredCommand> FilterCommands(::TerminalApp::FuzzyMatcher& matcher,
+                                                                               const Windows::Foundation::Collections::IVector<winrt::TerminalApp::FilteredCommand>& commands,
+                                                                               const winrt::hstring& filter,
+                                                                               bool sortByWeight,
+                                                                               PendingCommands* pending = nullptr);
+
+        const ::TerminalApp::FuzzyMatcher::Candidate& SearchCandidate() const noexcept;
 
         WINRT_CALLBACK(PropertyChanged, Windows::UI::Xaml::Data::PropertyChangedEventHandler);
         WINRT_OBSERVABLE_PROPERTY(winrt::TerminalApp::PaletteItem, Item, _PropertyChangedHandlers, nullptr);
@@ -32,6 +60,8 @@ namespace winrt::TerminalApp::implementation
     private:
         winrt::TerminalApp::HighlightedText _computeHighlightedName();
         int _computeWeight();
+
+        ::TerminalApp::FuzzyMatcher::Candidate _searchCandidate;
         Windows::UI::Xaml::Data::INotifyPropertyChanged::PropertyChanged_revoker _itemChangedRevoker;
 
         friend class TerminalAppLocalTests::FilteredCommandTests;
@@ -0,0 +1,229 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "FuzzyMatcher.h"
+
+using namespace ::TerminalApp;
+
+std::atomic<uint64_t> FuzzyMatcher::_revision{ 0 };
+
+FuzzyMatcher::Candidate::Candidate(std::wstring_view text) :
+    folded{ Fold(text) },
+    mask{ ComputeMask(folded) }
+{
+    _revision.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Function Description:
+// - Lowercases the given text according to the user's locale.
+// - GH#9941: search should be locale-aware. This used to compare each pair of
+//   characters with lstrcmpi. Folding the text once upfront allows us to
+//   compare plain code units instead.
+// - The result has the same length as the input, so that positions in the
+//   folded text can be used to highlight the original text.
+// Arguments:
+// - text: the text to fold
+// Return Value:
+// - the case folded text
+std::wstring FuzzyMatcher::Fold(std::wstring_view text)
+{
+    std::wstring folded{ text };
+    if (folded.empty())
+    {
+        return folded;
+    }
+
+    const auto length = gsl::narrow<int>(folded.size());
+    const auto written = LCMapStringEx(LOCALE_NAME_USER_DEFAULT, LCMAP_LOWERCASE | LCMAP_LINGUISTIC_CASING, text.data(), length, folded.data(), length, nullptr, nullptr, 0);
+    if (written != length)
+    {
+        // Lowercasing never changes the length of the string, but if it
+        // ever does, we can't map positions back, so just match the text as is.
+        LOG_LAST_ERROR_IF(written == 0);
+        folded.assign(text);
+    }
+
+    return folded;
+}
+
+// Function Description:
+// - Computes a bitmask of the characters that appear in the given folded text.
+//   Letters and digits get a bit each, everything else shares the remaining bits.
+// - If a query contains a character that a candidate doesn't, then the query's
+//   mask has a bit set that the candidate's mask doesn't have.
+// Arguments:
+// - folded: the case folded text
+// Return Value:
+// - the character mask of the text
+uint64_t FuzzyMatcher::ComputeMask(std::wstring_view folded) noexcept
+{
+    uint64_t mask = 0;
+    for (const auto ch : folded)
+    {
+        unsigned int bit;
+        if (ch >= L'a' && ch <= L'z')
+        {
+            bit = ch - L'a';
+        }
+        else if (ch >= L'0' && ch <= L'9')
+        {
+            bit = 26 + (ch - L'0');
+        }
+        else
+        {
+            bit = 36 + (ch % 28);
+        }
+        mask |= uint64_t{ 1 } << bit;
+    }
+    return mask;
+}
+
+// Function Description:
+// - Associates each character of the query with its first appearance in the
+//   remainder of the text. E.g., for the query "c l t s" and the text
+//   "close all tabs after this", the match will be "CLose TabS after this".
+// Arguments:
+// - folded: the case folded text to search in
+// - foldedQuery: the case folded query
+// - positions: receives the offsets of the matched characters in `folded`
+// Return Value:
+// - true if all the characters of the query were found
+bool FuzzyMatcher::FindPositions(std::wstring_view folded, std::wstring_view foldedQuery, std::vector<size_t>& positions)
+{
+    positions.clear();
+
+    size_t offset = 0;
+    for (const auto ch : foldedQuery)
+    {
+        offset = folded.find(ch, offset);
+        if (offset == std::wstring_view::npos)
+        {
+            positions.clear();
+            return false;
+        }
+        positions.push_back(offset++);
+    }
+
+    return true;
+}
+
+// Function Description:
+// - Calculates the weight of a match, which is used to order the results:
+//   * The weight is incremented once for each matched character.
+//   * Consecutive matches get 2 points for each character after the first one.
+//   * A run of matches at the start of a word gets an extra point.
+//     * For example, for a search string "sp", we want "Split Pane" to
+//       appear in the list before "Close Pane"
+// Arguments:
+// - folded: the case folded text that was searched in
+// - positions: the offsets of the matched characters, as returned by FindPositions
+// Return Value:
+// - the relative weight of this match
+int FuzzyMatcher::ComputeWeight(std::wstring_view folded, std::span<const size_t> positions) noexcept
+{
+    auto result = 0;
+
+    for (size_t i = 0; i < positions.size();)
+    {
+        const auto start = positions[i];
+        auto length = 1;
+        for (++i; i < positions.size() && positions[i] == positions[i - 1] + 1; ++i)
+        {
+            ++length;
+        }
+
+        result += 1 + 2 * (length - 1);
+
+        if (start == 0 || folded[start - 1] == L' ')
+        {
+            result++;
+        }
+    }
+
+    return result;
+}
+
+// Function Description:
+// - Orders matches first by weight, then by their text. This is the same order
+//   as FilteredCommand::Compare, without calling into the FilteredCommand.
+// Return Value:
+// - true if `first` should appear before `second`
+bool FuzzyMatcher::CompareMatches(const Match& first, const Match& second, std::span<const Candidate* const> candidates) noexcept
+{
+    if (first.weight == second.weight)
+    {
+        return lstrcmpi(candidates[first.index]->folded.c_str(), candidates[second.index]->folded.c_str()) < 0;
+    }
+
+    return first.weight > second.weight;
+}
+
+// Method Description:
+// - Finds all candidates that match the given query. If the query extends the
+//   previous one and the candidates didn't change, only the previous matches are
+//   checked again, as a candidate that didn't match "ab" can't match "abc" either.
+// Arguments:
+// - candidates: the candidates to search through
+// - query: the text to search for. An empty query matches every candidate.
+// Return Value:
+// - The matching candidates in their original order. The reference is valid
+//   until the next call to Filter.
+const std::vector<FuzzyMatcher::Match>& FuzzyMatcher::Filter(std::span<const Candidate* const> candidates, std::wstring_view query)
+{
+    auto foldedQuery = Fold(query);
+    const auto revision = _revision.load(std::memory_order_relaxed);
+
+    const auto refine = _valid &&
+                        _candidatesRevision == revision &&
+                        foldedQuery.starts_with(_query) &&
+                        std::equal(candidates.begin(), candidates.end(), _candidates.begin(), _candidates.end());
+
+    if (!refine)
+    {
+        _candidates.assign(candidates.begin(), candidates.end());
+        _candidatesRevision = revision;
+        _matches.clear();
+        _matches.reserve(candidates.size());
+        for (uint32_t i = 0; i < gsl::narrow<uint32_t>(candidates.size()); ++i)
+        {
+            _matches.push_back({ i, 0 });
+        }
+    }
+
+    if (!foldedQuery.empty() && (!refine || foldedQuery.size() != _query.size()))
+    {
+        const auto queryMask = ComputeMask(foldedQuery);
+
+        // _matches is compacted in place, which keeps the original order.
+        auto out = _matches.begin();
+        for (const auto& match : _matches)
+        {
+            const auto& candidate = *candidates[match.index];
+            if ((candidate.mask & queryMask) != queryMask)
+            {
+                continue;
+            }
+            if (!FindPositions(candidate.folded, foldedQuery, _positions))
+            {
+                continue;
+            }
+            *out++ = { match.index, ComputeWeight(candidate.folded, _positions) };
+        }
+        _matches.erase(out, _matches.end());
+    }
+
+    _query = std::move(foldedQuery);
+    _valid = true;
+    return _matches;
+}
+
+// Method Description:
+// - Forgets the previous results, forcing the next call to Filter to check all candidates.
+void FuzzyMatcher::Invalidate() noexcept
+{
+    _valid = false;
+    _candidates.clear();
+    _matches.clear();
+    _query.clear();
+}
@@ -0,0 +1,84 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+//
+// Module Name:
+// - FuzzyMatcher.h
+//
+// Abstract:
+// - The matching engine behind the filterable lists of the CommandPalette and
+//   the SuggestionsControl. A candidate matches a query if all the characters
+//   of the query appear in it in order (case-insensitive).
+// - Every candidate carries a precomputed, case folded copy of its text and a
+//   bitmask of the characters it contains. Candidates missing any character of
+//   the query are rejected without looking at their text.
+// - When the query is extended (e.g. the user typed another character), only
+//   the candidates that matched the previous query are checked again.
+//
+
+#pragma once
+
+namespace TerminalApp
+{
+    class FuzzyMatcher;
+};
+
+class TerminalApp::FuzzyMatcher final
+{
+public:
+    struct Candidate
+    {
+        Candidate() = default;
+        explicit Candidate(std::wstring_view text);
+
+        std::wstring folded;
+        uint64_t mask = 0;
+    };
+
+    struct Match
+    {
+        uint32_t index;
+        int weight;
+    };
+
+    static std::wstring Fold(std::wstring_view text);
+    static uint64_t ComputeMask(std::wstring_view folded) noexcept;
+    static bool FindPositions(std::wstring_view folded, std::wstring_view foldedQuery, std::vector<size_t>& positions);
+    static int ComputeWeight(std::wstring_view folded, std::span<const size_t> positions) noexcept;
+    static bool CompareMatches(const Match& first, const Match& second, std::span<const Candidate* const> candidates) noexcept;
+
+    const std::vector<Match>& Filter(std::span<const Candidate* const> candidates, std::wstring_view query);
+    void Invalidate() noexcept;
+
+    // Orders the first `count` entries of `matches` by `less`. The remaining entries
+    // stay unordered, but none of them is ordered before the first `count` ones.
+    // This avoids sorting the entire list if only the first page is shown.
+    template<typename Less>
+    static void SortPage(std::span<Match> matches, size_t count, Less&& less)
+    {
+        const auto mid = matches.begin() + std::min(count, matches.size());
+        std::partial_sort(matches.begin(), mid, matches.end(), less);
+    }
+
+    // Orders the entries after the first `count` ones, which SortPage skipped.
+    // Afterwards `matches` is in the same order as if it had been sorted entirely.
+    template<typename Less>
+    static void SortRemaining(std::span<Match> matches, size_t count, Less&& less)
+    {
+        if (matches.size() > count)
+        {
+            std::sort(matches.begin() + count, matches.end(), less);
+        }
+    }
+
+private:
+    // Incremented whenever any Candidate is constructed, because a candidate
+    // that changed its text must be re-evaluated even if the query was extended.
+    static std::atomic<uint64_t> _revision;
+
+    std::vector<const Candidate*> _candidates;
+    std::vector<Match> _matches;
+    std::vector<size_t> _positions;
+    std::wstring _query;
+    uint64_t _candidatesRevision = 0;
+    bool _valid = false;
+};
@@ -821,21 +821,7 @@ namespace winrt::TerminalApp::implementation
 
         auto commandsToFilter = _commandsToFilter();
 
-        {
-            for (const auto& action : commandsToFilter)
-            {
-                // Update filter for all commands
-                // This will modify the highlighting but will also lead to re-computation of weight (and consequently sorting).
-                // Pay attention that it already updates the highlighting in the UI
-                action.UpdateFilter(searchText);
-
-                // if there is active search we skip commands with 0 weight
-                if (searchText.empty() || action.Weight() > 0)
-                {
-                    actions.push_back(action);
-                }
-            }
-        }
+        actions = FilteredCommand::FilterCommands(_matcher, commandsToFilter, searchText, false);
 
         // No sorting in palette mode, so results are still filtered, but in the
         // original order. This feels more right for something like
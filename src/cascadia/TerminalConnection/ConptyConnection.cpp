@@ -645,18 +645,32 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                 }
             }
 
-            const auto result{ til::u8u16(std::string_view{ _buffer.data(), read }, _u16Str, _u8State) };
-            if (FAILED(result))
+            // If anyone can handle UTF-8 we pass it along as-is. That way the output only gets decoded once,
+            // by the StateMachine, which can scan the raw UTF-8 for control characters. See TerminalOutputUtf8.
+            const auto utf8 = static_cast<bool>(_TerminalOutputUtf8Handlers);
+
+            if (utf8)
             {
-                // EXIT POINT
-                _indicateExitWithStatus(result); // print a message
-                _transitionToState(ConnectionState::Failed);
-                return gsl::narrow_cast<DWORD>(result);
+                if (!read)
+                {
+                    return 0;
+                }
             }
-
-            if (_u16Str.empty())
+            else
             {
-                return 0;
+                const auto result{ til::u8u16(std::string_view{ _buffer.data(), read }, _u16Str, _u8State) };
+                if (FAILED(result))
+                {
+                    // EXIT POINT
+                    _indicateExitWithStatus(result); // print a message
+                    _transitionToState(ConnectionState::Failed);
+                    return gsl::narrow_cast<DWORD>(result);
+                }
+
+                if (_u16Str.empty())
+                {
+                    return 0;
+                }
             }
 
             if (!_receivedFirstByte)
@@ -676,7 +690,17 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
             }
 
             // Pass the output to our registered event handlers
-            _TerminalOutputHandlers(_u16Str);
+            if (utf8)
+            {
+#pragma warning(suppress : 26490) // Don't use reinterpret_cast (type.1).
+                const auto data = reinterpret_cast<const uint8_t*>(_buffer.data());
+#pragma warning(suppress : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+                _TerminalOutputUtf8Handlers(winrt::array_view<const uint8_t>{ data, data + read });
+            }
+            else
+            {
+                _TerminalOutputHandlers(_u16Str);
+            }
         }
 
         return 0;
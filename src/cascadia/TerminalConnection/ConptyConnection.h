@@ -58,6 +58,7 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                                                                          const winrt::guid& profileGuid);
 
         WINRT_CALLBACK(TerminalOutput, TerminalOutputHandler);
+        WINRT_CALLBACK(TerminalOutputUtf8, TerminalOutputUtf8Handler);
 
     private:
         static void closePseudoConsoleAsync(HPCON hPC) noexcept;
@@ -38,6 +38,9 @@ constexpr const auto TsfRedrawInterval = std::chrono::milliseconds(100);
 // The minimum delay between updating the locations of regex patterns
 constexpr const auto UpdatePatternLocationsInterval = std::chrono::milliseconds(500);
 
+// The delay before reflowing the remaining scrollback after a resize.
+constexpr const auto ContinueReflowInterval = std::chrono::milliseconds(100);
+
 // The delay before performing the search after change of search criteria
 constexpr const auto SearchAfterChangeDelay = std::chrono::milliseconds(200);
 
@@ -179,6 +182,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         //   need to hop across the process boundary every time text is output.
         //   We can throttle this to once every 8ms, which will get us out of
         //   the way of the main output & rendering threads.
+        // * _continueReflow: After a resize only the viewport is reflowed right
+        //   away. The rest of the scrollback is reflowed once the user stopped
+        //   resizing the window, in small steps so that we never hold the
+        //   terminal lock for long.
         const auto shared = _shared.lock();
         shared->tsfTryRedrawCanvas = std::make_shared<ThrottledFuncTrailing<>>(
             _dispatcher,
@@ -202,6 +209,21 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                 }
             });
 
+        // NOTE: Just like UpdatePatternLocations this runs on a background thread.
+        shared->continueReflow = std::make_unique<til::throttled_func_trailing<>>(
+            ContinueReflowInterval,
+            [weakTerminal = std::weak_ptr{ _terminal }]() {
+                if (const auto t = weakTerminal.lock())
+                {
+                    // The lock is released between each step, so that output and rendering can proceed in between.
+                    for (auto pending = true; pending;)
+                    {
+                        const auto lock = t->LockForWriting();
+                        pending = t->ContinueReflowUnderLock();
+                    }
+                }
+            });
+
         shared->updateScrollBar = std::make_shared<ThrottledFuncTrailing<Control::ScrollPositionChangedArgs>>(
             _dispatcher,
             ScrollBarUpdateInterval,
@@ -216,6 +238,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     ControlCore::~ControlCore()
     {
         Close();
+        _stopOutputApplyThread();
 
         if (_renderer)
         {
@@ -235,6 +258,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         const auto shared = _shared.lock();
         shared->tsfTryRedrawCanvas.reset();
         shared->updatePatternLocations.reset();
+        shared->continueReflow.reset();
         shared->updateScrollBar.reset();
     }
 
@@ -269,8 +293,12 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // revoke ALL old handlers immediately
 
         _connectionOutputEventRevoker.revoke();
+        _connectionOutputUtf8EventRevoker.revoke();
         _connectionStateChangedRevoker.revoke();
 
+        // Write out whatever the previous connection queued up and start over with a fresh queue.
+        _stopOutputApplyThread();
+
         _connection = newConnection;
         if (_connection)
         {
@@ -293,10 +321,22 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             if (auto conpty{ newConnection.try_as<TerminalConnection::ConptyConnection>() })
             {
                 conpty.ReparentWindow(_owningHwnd);
-            }
 
-            // This event is explicitly revoked in the destructor: does not need weak_ref
-            _connectionOutputEventRevoker = _connection.TerminalOutput(winrt::auto_revoke, { this, &ControlCore::_connectionOutputHandler });
+                // ConPTY produces output in a tight loop on its own thread. Instead of taking the terminal lock
+                // for every chunk, we queue them up and let _outputApplyThread write them in batches.
+                // Both events go through the queue, so that they stay in order.
+                _startOutputApplyThread();
+
+                // ConPTY's output is UTF-8 and our StateMachine can process it without decoding it up-front.
+                // These events are explicitly revoked in the destructor: does not need weak_ref
+                _connectionOutputUtf8EventRevoker = conpty.TerminalOutputUtf8(winrt::auto_revoke, { this, &ControlCore::_connectionOutputUtf8Handler });
+                _connectionOutputEventRevoker = _connection.TerminalOutput(winrt::auto_revoke, { this, &ControlCore::_connectionOutputQueuedHandler });
+            }
+            else
+            {
+                // This event is explicitly revoked in the destructor: does not need weak_ref
+                _connectionOutputEventRevoker = _connection.TerminalOutput(winrt::auto_revoke, { this, &ControlCore::_connectionOutputHandler });
+            }
         }
 
         // Fire off a connection state changed notification, to let our hosting
@@ -1122,6 +1162,13 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         if (SUCCEEDED(hr) && hr != S_FALSE)
         {
             _connection.Resize(vp.Height(), vp.Width());
+
+            // Reflow whatever scrollback UserResize() left for later.
+            const auto shared = _shared.lock_shared();
+            if (shared->continueReflow)
+            {
+                (*shared->continueReflow)();
+            }
         }
     }
 
@@ -1701,6 +1748,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
             // Stop accepting new output and state changes before we disconnect everything.
             _connectionOutputEventRevoker.revoke();
+            _connectionOutputUtf8EventRevoker.revoke();
             _connectionStateChangedRevoker.revoke();
             _connection.Close();
         }
@@ -1881,11 +1929,9 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             const auto cursorPos{ _terminal->GetCursorPosition() };
 
             // Does the current buffer line have a mark on it?
-            const auto& marks{ _terminal->GetScrollMarks() };
-            if (!marks.empty())
+            if (const auto last = _terminal->GetTextBuffer().GetCurrentMark())
             {
-                const auto& last{ marks.back() };
-                const auto [start, end] = last.GetExtent();
+                const auto [start, end] = last->GetExtent();
                 const auto lastNonSpace = _terminal->GetTextBuffer().GetLastNonSpaceCharacter();
 
                 // If the user clicked off to the right side of the prompt, we
@@ -1997,12 +2043,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                 _terminal->Write(hstr);
             }
 
-            // Start the throttled update of where our hyperlinks are.
-            const auto shared = _shared.lock_shared();
-            if (shared->updatePatternLocations)
-            {
-                (*shared->updatePatternLocations)();
-            }
+            _updatePatternLocationsAfterOutput();
         }
         catch (...)
         {
@@ -2011,6 +2052,125 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
     }
 
+    // Queues up the raw UTF-8 output of a ConptyConnection for _outputApplyThread.
+    // This blocks if the queue is full, which throttles the connection until we caught up.
+    void ControlCore::_connectionOutputUtf8Handler(const winrt::array_view<const uint8_t>& data)
+    try
+    {
+#pragma warning(suppress : 26490) // Don't use reinterpret_cast (type.1).
+        _queueOutput(OutputChunk{ .utf8 = std::string{ reinterpret_cast<const char*>(data.data()), data.size() } });
+    }
+    CATCH_LOG()
+
+    // Same as _connectionOutputUtf8Handler, but for the UTF-16 messages a ConptyConnection
+    // prints itself, like the exit code. They must not overtake any of the queued output.
+    void ControlCore::_connectionOutputQueuedHandler(const hstring& hstr)
+    try
+    {
+        _queueOutput(OutputChunk{ .utf16 = hstr });
+    }
+    CATCH_LOG()
+
+    // The handlers of a revoked connection may still be running, so this ensures that only one
+    // of them pushes into the queue at a time. Output that arrives after the queue was torn down is dropped.
+    void ControlCore::_queueOutput(OutputChunk&& chunk)
+    {
+        const std::lock_guard guard{ _outputProducerMutex };
+        if (_outputProducer)
+        {
+            _outputProducer->emplace(std::move(chunk));
+        }
+    }
+
+    void ControlCore::_startOutputApplyThread()
+    {
+        auto [producer, consumer] = til::spsc::channel<OutputChunk>(OutputQueueCapacity);
+        {
+            const std::lock_guard guard{ _outputProducerMutex };
+            _outputProducer.emplace(std::move(producer));
+        }
+        _outputApplyThread = std::thread{ [this, consumer = std::move(consumer)]() {
+            _outputApplyThreadMain(consumer);
+        } };
+        LOG_IF_FAILED(SetThreadDescription(_outputApplyThread.native_handle(), L"ControlCore Output Thread"));
+    }
+
+    void ControlCore::_stopOutputApplyThread() noexcept
+    try
+    {
+        // Dropping the producer makes the consumer exit once it processed any remaining chunks.
+        // This waits for a handler that is blocked in emplace(), which is fine, since the consumer keeps draining the queue.
+        {
+            const std::lock_guard guard{ _outputProducerMutex };
+            _outputProducer.reset();
+        }
+
+        if (_outputApplyThread.joinable())
+        {
+            _outputApplyThread.join();
+        }
+    }
+    CATCH_LOG()
+
+    void ControlCore::_outputApplyThreadMain(const til::spsc::consumer<OutputChunk>& consumer)
+    {
+        std::vector<OutputChunk> batch(OutputQueueCapacity);
+
+        for (;;)
+        {
+            // Wait for at least one chunk and then grab whatever else got queued up in the meantime.
+            // Under heavy load this will be quite a few, all of which we write while holding the lock just once.
+            const auto [count, ok] = consumer.pop_n(til::spsc::block_initially, batch.begin(), batch.size());
+            const auto chunks = std::span{ batch }.first(count);
+
+            if (!chunks.empty())
+            {
+                try
+                {
+                    {
+                        const auto lock = _terminal->LockForWriting();
+                        for (const auto& chunk : chunks)
+                        {
+                            if (chunk.utf16.empty())
+                            {
+                                _terminal->WriteUtf8(chunk.utf8);
+                            }
+                            else
+                            {
+                                _terminal->Write(chunk.utf16);
+                            }
+                        }
+                    }
+
+                    _updatePatternLocationsAfterOutput();
+                }
+                catch (...)
+                {
+                    // We're expecting to receive an exception here if the terminal
+                    // is closed while we're blocked playing a MIDI note.
+                }
+
+                // Release the memory of the chunks now, instead of whenever they get overwritten by a later batch.
+                std::fill(chunks.begin(), chunks.end(), OutputChunk{});
+            }
+
+            if (!ok)
+            {
+                break;
+            }
+        }
+    }
+
+    void ControlCore::_updatePatternLocationsAfterOutput()
+    {
+        // Start the throttled update of where our hyperlinks are.
+        const auto shared = _shared.lock_shared();
+        if (shared->updatePatternLocations)
+        {
+            (*shared->updatePatternLocations)();
+        }
+    }
+
     uint64_t ControlCore::SwapChainHandle() const
     {
         // This is only ever called by TermControl::AttachContent, which occurs
@@ -2326,13 +2486,24 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     Windows::Foundation::Collections::IVector<Control::ScrollMark> ControlCore::ScrollMarks() const
     {
         const auto lock = _terminal->LockForReading();
-        const auto& internalMarks = _terminal->GetScrollMarks();
+        // The marks are sorted by row, so this is a single slice of them.
+        // The alt buffer never has any marks, just like GetScrollMarks().
+        const auto& textBuffer = _terminal->GetTextBuffer();
+        const auto internalMarks = textBuffer.GetMarksInRange(0, textBuffer.GetSize().Height());
         std::vector<Control::ScrollMark> v;
 
         v.reserve(internalMarks.size());
 
+        const ::ScrollMark* previous = nullptr;
         for (const auto& mark : internalMarks)
         {
+            // The scrollbar draws a pip per row. Marks on the same row in the same color would just draw the same pip again.
+            if (previous && previous->start.y == mark.start.y && previous->color == mark.color && previous->category == mark.category)
+            {
+                continue;
+            }
+            previous = &mark;
+
             v.emplace_back(
                 mark.start.to_core_point(),
                 mark.end.to_core_point(),
@@ -2383,67 +2554,42 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     {
         const auto lock = _terminal->LockForWriting();
         const auto currentOffset = ScrollOffset();
-        const auto& marks{ _terminal->GetScrollMarks() };
+        const auto& textBuffer = _terminal->GetTextBuffer();
 
+        // The marks are sorted by row, so each of these is a binary search.
         std::optional<::ScrollMark> tgt;
 
         switch (direction)
         {
         case ScrollToMarkDirection::Last:
         {
-            int highest = currentOffset;
-            for (const auto& mark : marks)
+            // The last mark in the buffer, if it's below the current offset.
+            tgt = textBuffer.GetPreviousMark(til::CoordTypeMax);
+            if (tgt && tgt->start.y <= currentOffset)
             {
-                const auto newY = mark.start.y;
-                if (newY > highest)
-                {
-                    tgt = mark;
-                    highest = newY;
-                }
+                tgt.reset();
             }
             break;
         }
         case ScrollToMarkDirection::First:
         {
-            int lowest = currentOffset;
-            for (const auto& mark : marks)
+            // The first mark in the buffer (marks never start above row 0), if it's above the current offset.
+            tgt = textBuffer.GetNextMark(-1);
+            if (tgt && tgt->start.y >= currentOffset)
             {
-                const auto newY = mark.start.y;
-                if (newY < lowest)
-                {
-                    tgt = mark;
-                    lowest = newY;
-                }
+                tgt.reset();
             }
             break;
         }
         case ScrollToMarkDirection::Next:
         {
-            int minDistance = INT_MAX;
-            for (const auto& mark : marks)
-            {
-                const auto delta = mark.start.y - currentOffset;
-                if (delta > 0 && delta < minDistance)
-                {
-                    tgt = mark;
-                    minDistance = delta;
-                }
-            }
+            tgt = textBuffer.GetNextMark(currentOffset);
             break;
         }
         case ScrollToMarkDirection::Previous:
         default:
         {
-            int minDistance = INT_MAX;
-            for (const auto& mark : marks)
-            {
-                const auto delta = currentOffset - mark.start.y;
-                if (delta > 0 && delta < minDistance)
-                {
-                    tgt = mark;
-                    minDistance = delta;
-                }
-            }
+            tgt = textBuffer.GetPreviousMark(currentOffset);
             break;
         }
         }
@@ -24,6 +24,7 @@
 #include "../../cascadia/TerminalCore/Terminal.hpp"
 #include "../buffer/out/search.h"
 #include "../buffer/out/TextColor.h"
+#include <til/spsc.h>
 
 namespace ControlUnitTests
 {
@@ -287,16 +288,38 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         {
             std::shared_ptr<ThrottledFuncTrailing<>> tsfTryRedrawCanvas;
             std::unique_ptr<til::throttled_func_trailing<>> updatePatternLocations;
+            std::unique_ptr<til::throttled_func_trailing<>> continueReflow;
             std::shared_ptr<ThrottledFuncTrailing<Control::ScrollPositionChangedArgs>> updateScrollBar;
         };
 
+        // A chunk of ConPTY output on its way from the connection's output thread to _outputApplyThread.
+        // Exactly one of the two members is set, depending on which event it was received from.
+        struct OutputChunk
+        {
+            std::string utf8;
+            winrt::hstring utf16;
+        };
+
+        // 4KiB per ConPTY read = at most 1MiB of output in flight, before the connection gets throttled.
+        static constexpr uint32_t OutputQueueCapacity = 256;
+
         std::atomic<bool> _initializedTerminal{ false };
         bool _closing{ false };
 
         TerminalConnection::ITerminalConnection _connection{ nullptr };
         TerminalConnection::ITerminalConnection::TerminalOutput_revoker _connectionOutputEventRevoker;
+        TerminalConnection::ConptyConnection::TerminalOutputUtf8_revoker _connectionOutputUtf8EventRevoker;
         TerminalConnection::ITerminalConnection::StateChanged_revoker _connectionStateChangedRevoker;
 
+        // The output of a ConptyConnection doesn't get written to the _terminal on the connection's thread.
+        // It's queued up here instead, so that _outputApplyThread can write all of the pending chunks
+        // at once while holding the lock, instead of fighting with the renderer over it for each chunk.
+        // The producer is guarded by _outputProducerMutex, because a revoked event handler of a previous
+        // connection may still be running when the next connection starts pushing its output.
+        std::mutex _outputProducerMutex;
+        std::optional<til::spsc::producer<OutputChunk>> _outputProducer;
+        std::thread _outputApplyThread;
+
         winrt::com_ptr<ControlSettings> _settings{ nullptr };
 
         std::shared_ptr<::Microsoft::Terminal::Core::Terminal> _terminal{ nullptr };
@@ -388,6 +411,13 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         void _raiseReadOnlyWarning();
         void _updateAntiAliasingMode();
         void _connectionOutputHandler(const hstring& hstr);
+        void _connectionOutputUtf8Handler(const winrt::array_view<const uint8_t>& data);
+        void _connectionOutputQueuedHandler(const hstring& hstr);
+        void _queueOutput(OutputChunk&& chunk);
+        void _startOutputApplyThread();
+        void _stopOutputApplyThread() noexcept;
+        void _outputApplyThreadMain(const til::spsc::consumer<OutputChunk>& consumer);
+        void _updatePatternLocationsAfterOutput();
         void _updateHoveredCell(const std::optional<til::point> terminalPosition);
         void _setOpacity(const double opacity, const bool focused = true);
 
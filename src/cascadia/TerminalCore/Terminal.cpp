@@ -23,6 +23,15 @@ using namespace Microsoft::Console::VirtualTerminal;
 
 using PointTree = interval_tree::IntervalTree<til::point, size_t>;
 
+// The number of rows ContinueReflowUnderLock() reflows at a time.
+// This takes about a millisecond and keeps the lock from being held for too long.
+constexpr til::CoordType ReflowRowsPerStep = 4096;
+// Matches can span rows that are joined by wrapping. To bound the cost of a lookup,
+// pathologically long lines are split into pieces of this many rows.
+constexpr til::CoordType PatternLineMaxRows = 64;
+// The number of lines whose matches _getPatterns() keeps around. That's a couple full screens.
+constexpr size_t PatternCacheSizeLimit = 1024;
+
 #pragma warning(suppress : 26455) // default constructor is throwing, too much effort to rearrange at this time.
 Terminal::Terminal()
 {
@@ -295,11 +304,13 @@ try
         .visibleViewportTop = _VisibleStartIndex(),
     };
 
-    TextBuffer::Reflow(*_mainBuffer.get(), *newTextBuffer.get(), &_mutableViewport, &positionInfo);
-
     // Restore the active text attributes
     newTextBuffer->SetCurrentAttributes(_mainBuffer->GetCurrentAttributes());
 
+    // Only the rows around the viewport are reflowed right away. The new buffer takes ownership of the old one
+    // and the remaining scrollback is reflowed in the background by calling ContinueReflowUnderLock().
+    TextBuffer::ReflowIncremental(_mainBuffer, *newTextBuffer.get(), &_mutableViewport, positionInfo);
+
     // Conpty resizes a little oddly - if the height decreased, and there were
     // blank lines at the bottom, those lines will get trimmed. If there's not
     // blank lines, then the top will get "shifted down", moving the top line
@@ -434,6 +445,23 @@ void Terminal::Write(std::wstring_view stringView)
     }
 }
 
+// Same as Write(), but for UTF-8 text. This avoids decoding the output of
+// ConptyConnection up-front. See StateMachine::ProcessStringUtf8().
+void Terminal::WriteUtf8(std::string_view stringView)
+{
+    const auto& cursor = _activeBuffer().GetCursor();
+    const til::point cursorPosBefore{ cursor.GetPosition() };
+
+    _stateMachine->ProcessStringUtf8(stringView);
+
+    const til::point cursorPosAfter{ cursor.GetPosition() };
+
+    if (cursorPosBefore != cursorPosAfter)
+    {
+        _NotifyTerminalCursorPositionChanged();
+    }
+}
+
 // Method Description:
 // - Attempts to snap to the bottom of the buffer, if SnapOnInput is true. Does
 //   nothing if SnapOnInput is set to false, or we're already at the bottom of
@@ -514,6 +542,7 @@ std::wstring Terminal::GetHyperlinkAtBufferPosition(const til::point bufferPos)
     {
         // Hyperlink is outside of the current view.
         // We need to find if there's a pattern at that location.
+        // This is cheap for lines that were scanned before, since _getPatterns() caches its results.
         const auto patterns = _getPatterns(bufferPos.y, bufferPos.y);
 
         // NOTE: patterns is stored with top y-position being 0,
@@ -1197,6 +1226,17 @@ void Terminal::UpdatePatternsUnderLock()
     _InvalidatePatternTree();
 }
 
+// Method Description:
+// - Reflows the next couple rows of scrollback that were left over from the last UserResize().
+// - This is called by TerminalControl (through a throttled function) until it returns false.
+// - INVARIANT: this function can only be called if the caller has the writing lock on the terminal
+// Return Value:
+// - true if there are still rows left to be reflowed.
+bool Terminal::ContinueReflowUnderLock()
+{
+    return _mainBuffer->ContinueReflow(ReflowRowsPerStep);
+}
+
 // Method Description:
 // - Clears and invalidates the interval pattern tree
 // - This is called to prevent the renderer from rendering patterns while the
@@ -1332,6 +1372,7 @@ void Terminal::_updateUrlDetection()
     else
     {
         _clearPatternTree();
+        _patternCache = {};
     }
 }
 
@@ -1402,7 +1443,98 @@ private:
 
 static URegularExpressionInterner uregexInterner;
 
+// Returns the pattern matches of all lines that overlap the rows [beg, end] (inclusive),
+// relative to `beg`. Matches that wrap across the edges are returned in full.
 PointTree Terminal::_getPatterns(til::CoordType beg, til::CoordType end) const
+{
+    const auto& buffer = _activeBuffer();
+    const auto lastRow = buffer.GetSize().BottomInclusive();
+    beg = std::clamp(beg, 0, lastRow);
+    end = std::clamp(end, beg, lastRow);
+
+    _patternCacheGeneration++;
+
+    // Find the start of the line that the first row belongs to.
+    auto lineBeg = beg;
+    for (const auto limit = beg - PatternLineMaxRows + 1; lineBeg > 0 && lineBeg > limit && buffer.GetRowByOffset(lineBeg - 1).WasWrapForced();)
+    {
+        --lineBeg;
+    }
+
+    PointTree::interval_vector intervals;
+
+    while (lineBeg <= end)
+    {
+        auto lineEnd = lineBeg;
+        while (lineEnd < lastRow && lineEnd - lineBeg + 1 < PatternLineMaxRows && buffer.GetRowByOffset(lineEnd).WasWrapForced())
+        {
+            ++lineEnd;
+        }
+
+        const auto dy = lineBeg - beg;
+        for (auto interval : _getLinePatterns(lineBeg, lineEnd))
+        {
+            interval.start.y += dy;
+            interval.stop.y += dy;
+            intervals.push_back(interval);
+        }
+
+        lineBeg = lineEnd + 1;
+    }
+
+    // Drop the lines that this call didn't use. The ones it did are kept, even if they exceed the limit on their own.
+    if (_patternCache.size() > PatternCacheSizeLimit)
+    {
+        std::erase_if(_patternCache, [&](const auto& it) {
+            return it.second.generation != _patternCacheGeneration;
+        });
+    }
+
+    return PointTree{ std::move(intervals) };
+}
+
+// Returns the cached matches of the rows [beg, end] (inclusive), relative to `beg`.
+const std::vector<PointTree::interval>& Terminal::_getLinePatterns(til::CoordType beg, til::CoordType end) const
+{
+    const auto& buffer = _activeBuffer();
+    til::hasher h;
+    for (auto y = beg; y <= end; ++y)
+    {
+        h.write(buffer.GetRowByOffset(y).ContentHash());
+    }
+
+    auto& entry = _patternCache[h.finalize()];
+
+    // The hash only narrows it down. It's a hit if each row still has the text it had when the entry was made.
+    const std::wstring_view cachedText{ entry.text };
+    auto hit = entry.generation != 0 && entry.rowEnds.size() == gsl::narrow_cast<size_t>(end - beg + 1);
+    size_t rowBeg = 0;
+    for (auto y = beg; hit && y <= end; ++y)
+    {
+        const auto rowEnd = til::at(entry.rowEnds, gsl::narrow_cast<size_t>(y - beg));
+        hit = cachedText.substr(rowBeg, rowEnd - rowBeg) == buffer.GetRowByOffset(y).GetText();
+        rowBeg = rowEnd;
+    }
+
+    if (!hit)
+    {
+        // Either a line we haven't seen yet or a hash collision. The latter simply replaces the other line.
+        entry.text.clear();
+        entry.rowEnds.clear();
+        for (auto y = beg; y <= end; ++y)
+        {
+            entry.text.append(buffer.GetRowByOffset(y).GetText());
+            entry.rowEnds.push_back(entry.text.size());
+        }
+        entry.intervals = _matchPatterns(beg, end);
+    }
+
+    entry.generation = _patternCacheGeneration;
+    return entry.intervals;
+}
+
+// Runs the patterns over the rows [beg, end] (inclusive) and returns the matches relative to `beg`.
+std::vector<PointTree::interval> Terminal::_matchPatterns(til::CoordType beg, til::CoordType end) const
 {
     static constexpr std::array<std::wstring_view, 1> patterns{
         LR"(\b(?:https?|ftp|file)://[-A-Za-z0-9+&@#/%?=~_|$!:,.;]*[A-Za-z0-9+&@#/%=~_|$])",
@@ -1410,7 +1542,7 @@ PointTree Terminal::_getPatterns(til::CoordType beg, til::CoordType end) const
 
     auto text = ICU::UTextFromTextBuffer(_activeBuffer(), beg, end + 1);
     UErrorCode status = U_ZERO_ERROR;
-    PointTree::interval_vector intervals;
+    std::vector<PointTree::interval> intervals;
 
     for (size_t i = 0; i < patterns.size(); ++i)
     {
@@ -1431,7 +1563,7 @@ PointTree Terminal::_getPatterns(til::CoordType beg, til::CoordType end) const
         }
     }
 
-    return PointTree{ std::move(intervals) };
+    return intervals;
 }
 
 // NOTE: This is the version of AddMark that comes from the UI. The VT api call into this too.
@@ -1495,12 +1627,11 @@ void Terminal::ClearAllMarks()
     _NotifyScrollEvent();
 }
 
-const std::vector<ScrollMark>& Terminal::GetScrollMarks() const noexcept
+std::vector<ScrollMark> Terminal::GetScrollMarks() const
 {
     // TODO: GH#11000 - when the marks are stored per-buffer, get rid of this.
     // We want to return _no_ marks when we're in the alt buffer, to effectively
-    // hide them. We need to return a reference, so we can't just ctor an empty
-    // list here just for when we're in the alt buffer.
+    // hide them. The alt buffer never has any marks, so this does just that.
     return _activeBuffer().GetMarks();
 }
 
@@ -102,6 +102,7 @@ public:
 
     // Write comes from the PTY and goes to our parser to be stored in the output buffer
     void Write(std::wstring_view stringView);
+    void WriteUtf8(std::string_view stringView);
 
     void _assertLocked() const noexcept;
     void _assertUnlocked() const noexcept;
@@ -117,7 +118,7 @@ public:
     RenderSettings& GetRenderSettings() noexcept;
     const RenderSettings& GetRenderSettings() const noexcept;
 
-    const std::vector<ScrollMark>& GetScrollMarks() const noexcept;
+    std::vector<ScrollMark> GetScrollMarks() const;
     void AddMark(const ScrollMark& mark,
                  const til::point& start,
                  const til::point& end,
@@ -242,6 +243,7 @@ public:
     void SetCursorOn(const bool isOn) noexcept;
 
     void UpdatePatternsUnderLock();
+    bool ContinueReflowUnderLock();
 
     const std::optional<til::color> GetTabColor() const;
 
@@ -470,6 +472,23 @@ private:
     TextBuffer& _activeBuffer() const noexcept;
     void _updateUrlDetection();
     interval_tree::IntervalTree<til::point, size_t> _getPatterns(til::CoordType beg, til::CoordType end) const;
+    const std::vector<interval_tree::Interval<til::point, size_t>>& _getLinePatterns(til::CoordType beg, til::CoordType end) const;
+    std::vector<interval_tree::Interval<til::point, size_t>> _matchPatterns(til::CoordType beg, til::CoordType end) const;
+
+    // The pattern matches of each logical line (rows joined by wrapping), keyed by the hash of their contents.
+    // This way only lines that changed are matched again, no matter where in the buffer they are.
+    struct PatternCacheEntry
+    {
+        // The text of the line's rows, concatenated. Used to verify a hit, because the key is just a hash.
+        std::wstring text;
+        // The end offset of each row's text in `text`.
+        std::vector<size_t> rowEnds;
+        // The y of each interval is relative to the line's first row.
+        std::vector<interval_tree::Interval<til::point, size_t>> intervals;
+        size_t generation = 0;
+    };
+    mutable std::unordered_map<size_t, PatternCacheEntry> _patternCache;
+    mutable size_t _patternCacheGeneration = 0;
 
 #pragma region TextSelection
     // These methods are defined in TerminalSelection.cpp
@@ -334,7 +334,7 @@ void Terminal::MarkCommandStart()
     const til::point cursorPos{ _activeBuffer().GetCursor().GetPosition() };
 
     if ((_currentPromptState == PromptState::Prompt) &&
-        (_activeBuffer().GetMarks().size() > 0))
+        _activeBuffer().GetCurrentMark().has_value())
     {
         // We were in the right state, and there's a previous mark to work
         // with.
@@ -369,7 +369,7 @@ void Terminal::MarkOutputStart()
     const til::point cursorPos{ _activeBuffer().GetCursor().GetPosition() };
 
     if ((_currentPromptState == PromptState::Command) &&
-        (_activeBuffer().GetMarks().size() > 0))
+        _activeBuffer().GetCurrentMark().has_value())
     {
         // We were in the right state, and there's a previous mark to work
         // with.
@@ -411,7 +411,7 @@ void Terminal::MarkCommandFinish(std::optional<unsigned int> error)
     }
 
     if ((_currentPromptState == PromptState::Output) &&
-        (_activeBuffer().GetMarks().size() > 0))
+        _activeBuffer().GetCurrentMark().has_value())
     {
         // We were in the right state, and there's a previous mark to work
         // with.
@@ -497,8 +497,7 @@ void Terminal::NotifyBufferRotation(const int delta)
     // manually erase our pattern intervals since the locations have changed now
     _patternIntervalTree = {};
 
-    auto& marks{ _activeBuffer().GetMarks() };
-    const auto hasScrollMarks = marks.size() > 0;
+    const auto hasScrollMarks = _activeBuffer().HasMarks();
     if (hasScrollMarks)
     {
         _activeBuffer().ScrollMarks(-delta);
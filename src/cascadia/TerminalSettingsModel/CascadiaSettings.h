@@ -21,6 +21,7 @@ Author(s):
 
 #include "GlobalAppSettings.h"
 #include "Profile.h"
+#include "SettingsSnapshot.h"
 
 namespace winrt::Microsoft::Terminal::Settings::Model
 {
@@ -52,8 +53,9 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
     {
         static SettingsLoader Default(const std::string_view& userJSON, const std::string_view& inboxJSON);
         SettingsLoader(const std::string_view& userJSON, const std::string_view& inboxJSON);
+        SettingsLoader(const std::string_view& userJSON, const std::string_view& inboxJSON, const std::filesystem::path& snapshotPath);
 
-        void GenerateProfiles();
+        void GenerateProfiles(const std::filesystem::path& cachePath = {});
         void ApplyRuntimeInitialSettings();
         void MergeInboxIntoUserSettings();
         void FindFragmentsAndMergeIntoUserSettings();
@@ -61,12 +63,15 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         void FinalizeLayering();
         bool DisableDeletedProfiles();
         bool FixupUserSettings();
+        void SaveSnapshot();
 
         ParsedSettings inboxSettings;
         ParsedSettings userSettings;
         bool duplicateProfile = false;
 
     private:
+        friend class SettingsModelLocalTests::DeserializationTests;
+
         struct JsonSettings
         {
             Json::Value root;
@@ -81,17 +86,21 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         static Json::Value _parseJSON(const std::string_view& content);
         static const Json::Value& _getJSONValue(const Json::Value& json, const std::string_view& key) noexcept;
         std::span<const winrt::com_ptr<implementation::Profile>> _getNonUserOriginProfiles() const;
-        void _parse(const OriginTag origin, const winrt::hstring& source, const std::string_view& content, ParsedSettings& settings);
-        void _parseFragment(const winrt::hstring& source, const std::string_view& content, ParsedSettings& settings);
+        void _parse(const OriginTag origin, const winrt::hstring& source, const JsonSettings& json, ParsedSettings& settings);
+        void _parseFragment(const winrt::hstring& source, const JsonSettings& json, ParsedSettings& settings);
         static JsonSettings _parseJson(const std::string_view& content);
+        static JsonSettings _splitJson(Json::Value root);
+        Json::Value _parseLayer(SettingsSnapshot::LayerKind kind, const std::string_view& content);
         static winrt::com_ptr<implementation::Profile> _parseProfile(const OriginTag origin, const winrt::hstring& source, const Json::Value& profileJson);
         void _appendProfile(winrt::com_ptr<Profile>&& profile, const winrt::guid& guid, ParsedSettings& settings);
         void _addUserProfileParent(const winrt::com_ptr<implementation::Profile>& profile);
-        void _executeGenerator(const IDynamicProfileGenerator& generator);
+        void _executeGenerators(std::span<const IDynamicProfileGenerator* const> generators, const std::filesystem::path& cachePath);
 
         std::unordered_set<std::wstring_view> _ignoredNamespaces;
         // See _getNonUserOriginProfiles().
         size_t _userProfileCount = 0;
+        // Does nothing unless a snapshotPath was given to the constructor.
+        SettingsSnapshot _snapshot;
     };
 
     struct CascadiaSettings : CascadiaSettingsT<CascadiaSettings>
@@ -148,6 +157,8 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
     private:
         static const std::filesystem::path& _settingsPath();
         static const std::filesystem::path& _releaseSettingsPath();
+        static const std::filesystem::path& _generatorCachePath();
+        static const std::filesystem::path& _settingsSnapshotPath();
         static winrt::hstring _calculateHash(std::string_view settings, const FILETIME& lastWriteTime);
 
         winrt::com_ptr<implementation::Profile> _createNewProfile(const std::wstring_view& name) const;
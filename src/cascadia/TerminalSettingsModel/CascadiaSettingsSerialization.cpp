@@ -29,6 +29,7 @@
 #include "ApplicationState.h"
 #include "DefaultTerminal.h"
 #include "FileUtils.h"
+#include "../../types/inc/utils.hpp"
 
 #include "ProfileEntry.h"
 #include "FolderEntry.h"
@@ -41,6 +42,8 @@ using namespace winrt::Microsoft::Terminal::Settings::Model::implementation;
 
 static constexpr std::wstring_view SettingsFilename{ L"settings.json" };
 static constexpr std::wstring_view DefaultsFilename{ L"defaults.json" };
+static constexpr std::wstring_view GeneratorCacheFilename{ L"generator-cache.json" };
+static constexpr std::wstring_view SettingsSnapshotFilename{ L"settings.snapshot" };
 
 static constexpr std::string_view ProfilesKey{ "profiles" };
 static constexpr std::string_view DefaultSettingsKey{ "defaults" };
@@ -48,6 +51,10 @@ static constexpr std::string_view ProfilesListKey{ "list" };
 static constexpr std::string_view SchemesKey{ "schemes" };
 static constexpr std::string_view ThemesKey{ "themes" };
 
+static constexpr std::string_view GeneratorCacheVersionKey{ "version" };
+static constexpr std::string_view GeneratorCacheGeneratorsKey{ "generators" };
+static constexpr std::string_view GeneratorCacheKeyKey{ "key" };
+
 constexpr std::wstring_view systemThemeName{ L"system" };
 constexpr std::wstring_view darkThemeName{ L"dark" };
 constexpr std::wstring_view lightThemeName{ L"light" };
@@ -98,6 +105,19 @@ static auto extractValueFromTaskWithoutMainThreadAwait(TTask&& task) -> decltype
 
 // Concatenates the two given strings (!) and returns them as a path.
 // You better make sure there's a path separator at the end of lhs or at the start of rhs.
+// Hashes the path, size and last write time of the given file, as a key for the settings snapshot.
+static uint64_t fileStampKey(const std::filesystem::path& path)
+{
+    std::error_code ec;
+    const std::filesystem::directory_entry entry{ path, ec };
+
+    til::hasher h;
+    h.write(path.native());
+    h.write(entry.file_size(ec));
+    h.write(entry.last_write_time(ec).time_since_epoch().count());
+    return h.finalize();
+}
+
 static std::filesystem::path buildPath(const std::wstring_view& lhs, const std::wstring_view& rhs)
 {
     std::wstring buffer;
@@ -132,13 +152,27 @@ SettingsLoader SettingsLoader::Default(const std::string_view& userJSON, const s
 //
 // This constructor only handles parsing the two given JSON strings.
 // At a minimum you should do at least everything that SettingsLoader::Default does.
-SettingsLoader::SettingsLoader(const std::string_view& userJSON, const std::string_view& inboxJSON)
+SettingsLoader::SettingsLoader(const std::string_view& userJSON, const std::string_view& inboxJSON) :
+    SettingsLoader{ userJSON, inboxJSON, {} }
 {
-    _parse(OriginTag::InBox, {}, inboxJSON, inboxSettings);
+}
+
+// If a snapshotPath is given, the parsed JSON of each layer is decoded from the SettingsSnapshot
+// at that path instead, as long as the layer's sources didn't change. See _parseLayer().
+// SaveSnapshot() writes the layers that had to be parsed back to it.
+SettingsLoader::SettingsLoader(const std::string_view& userJSON, const std::string_view& inboxJSON, const std::filesystem::path& snapshotPath)
+{
+    if (!snapshotPath.empty())
+    {
+        // Another version may deserialize the same JSON differently. Each version thus gets its own snapshot.
+        _snapshot = SettingsSnapshot::Open(snapshotPath, til::hash(std::wstring_view{ CascadiaSettings::ApplicationVersion() }));
+    }
+
+    _parse(OriginTag::InBox, {}, _splitJson(_parseLayer(SettingsSnapshot::LayerKind::InBox, inboxJSON)), inboxSettings);
 
     try
     {
-        _parse(OriginTag::User, {}, userJSON, userSettings);
+        _parse(OriginTag::User, {}, _splitJson(_parseLayer(SettingsSnapshot::LayerKind::User, userJSON)), userSettings);
     }
     catch (const JsonUtils::DeserializationError& e)
     {
@@ -160,15 +194,28 @@ SettingsLoader::SettingsLoader(const std::string_view& userJSON, const std::stri
 
 // Generate dynamic profiles and add them to the list of "inbox" profiles
 // (meaning profiles specified by the application rather by the user).
-void SettingsLoader::GenerateProfiles()
+// If a cachePath is given, the results are cached in that file. See _executeGenerators().
+void SettingsLoader::GenerateProfiles(const std::filesystem::path& cachePath)
 {
-    _executeGenerator(PowershellCoreProfileGenerator{});
-    _executeGenerator(WslDistroGenerator{});
-    _executeGenerator(AzureCloudShellGenerator{});
-    _executeGenerator(VisualStudioGenerator{});
+    PowershellCoreProfileGenerator powershellCoreGenerator;
+    WslDistroGenerator wslDistroGenerator;
+    AzureCloudShellGenerator azureCloudShellGenerator;
+    VisualStudioGenerator visualStudioGenerator;
 #if TIL_FEATURE_DYNAMICSSHPROFILES_ENABLED
-    _executeGenerator(SshHostGenerator{});
+    SshHostGenerator sshHostGenerator;
 #endif
+
+    const IDynamicProfileGenerator* generators[]{
+        &powershellCoreGenerator,
+        &wslDistroGenerator,
+        &azureCloudShellGenerator,
+        &visualStudioGenerator,
+#if TIL_FEATURE_DYNAMICSSHPROFILES_ENABLED
+        &sshHostGenerator,
+#endif
+    };
+
+    _executeGenerators(generators, cachePath);
 }
 
 // A new settings.json gets a special treatment:
@@ -225,21 +272,41 @@ void SettingsLoader::MergeInboxIntoUserSettings()
 // merge them. Unfortunately however the "updates" key in fragment profiles make this impossible:
 // The targeted profile might be one that got created as part of SettingsLoader::MergeInboxIntoUserSettings.
 // Additionally the GUID in "updates" will conflict with existing GUIDs in .inboxSettings.
+//
+// The fragments are a layer of the settings snapshot, keyed by the paths, sizes and last write times of
+// the fragment files and the full names of the extension packages. If the snapshot has a matching layer,
+// the public folders of the extensions aren't looked up and no file is read or parsed.
 void SettingsLoader::FindFragmentsAndMergeIntoUserSettings()
 {
+    struct FragmentFile
+    {
+        std::filesystem::path path;
+        winrt::hstring source;
+    };
+
     ParsedSettings fragmentSettings;
+    std::vector<FragmentFile> fragmentFiles;
+    til::hasher hasher;
+
+    const auto hashString = [&](const std::wstring_view& str) {
+        hasher.write(str.size());
+        hasher.write(str);
+    };
 
-    const auto parseAndLayerFragmentFiles = [&](const std::filesystem::path& path, const winrt::hstring& source) {
+    const auto addFragmentFiles = [&](const std::filesystem::path& path, const winrt::hstring& source) {
         for (const auto& fragmentExt : std::filesystem::directory_iterator{ path })
         {
             if (fragmentExt.path().extension() == jsonExtension)
             {
-                try
-                {
-                    const auto content = ReadUTF8File(fragmentExt.path());
-                    _parseFragment(source, content, fragmentSettings);
-                }
-                CATCH_LOG();
+                // directory_iterator already got the size and last write time from FindNextFileW().
+                // (For app extensions this happens after the snapshot key was computed, which is fine,
+                // because the full name of their package already covers their files.)
+                std::error_code ec;
+                hashString(fragmentExt.path().native());
+                hasher.write(fragmentExt.file_size(ec));
+                hasher.write(fragmentExt.last_write_time(ec).time_since_epoch().count());
+
+                fragmentFiles.push_back({ fragmentExt.path(), source });
             }
         }
     };
@@ -260,7 +327,7 @@ void SettingsLoader::FindFragmentsAndMergeIntoUserSettings()
 
                 if (!_ignoredNamespaces.count(std::wstring_view{ source }) && fragmentExtFolder.is_directory())
                 {
-                    parseAndLayerFragmentFiles(fragmentExtFolder.path(), winrt::hstring{ source });
+                    addFragmentFiles(fragmentExtFolder.path(), winrt::hstring{ source });
                 }
             }
         }
@@ -285,37 +352,72 @@ void SettingsLoader::FindFragmentsAndMergeIntoUserSettings()
     }
     CATCH_LOG();
 
-    if (!extensions)
+    std::vector<AppExtension> fragmentExtensions;
+    if (extensions)
     {
-        return;
+        for (const auto& ext : extensions)
+        {
+            const auto packageId = ext.Package().Id();
+            if (_ignoredNamespaces.count(std::wstring_view{ packageId.FamilyName() }))
+            {
+                continue;
+            }
+
+            // The full name includes the version. The files in the package can't change without it changing too.
+            hashString(packageId.FullName());
+            fragmentExtensions.emplace_back(ext);
+        }
     }
 
-    for (const auto& ext : extensions)
+    const uint64_t snapshotKey = hasher.finalize();
+    auto fragments = _snapshot.Read(SettingsSnapshot::LayerKind::Fragments, snapshotKey);
+
+    if (!fragments)
     {
-        const auto packageName = ext.Package().Id().FamilyName();
-        if (_ignoredNamespaces.count(std::wstring_view{ packageName }))
+        fragments.emplace();
+
+        for (const auto& ext : fragmentExtensions)
         {
-            continue;
+            // Likewise, getting the public folder from an extension is an async operation.
+            auto foundFolder = extractValueFromTaskWithoutMainThreadAwait(ext.GetPublicFolderAsync());
+            if (!foundFolder)
+            {
+                continue;
+            }
+
+            // the StorageFolder class has its own methods for obtaining the files within the folder
+            // however, all those methods are Async methods
+            // you may have noticed that we need to resort to clunky implementations for async operations
+            // (they are in extractValueFromTaskWithoutMainThreadAwait)
+            // so for now we will just take the folder path and access the files that way
+            const auto path = buildPath(foundFolder.Path(), FragmentsSubDirectory);
+
+            if (std::filesystem::is_directory(path))
+            {
+                addFragmentFiles(path, ext.Package().Id().FamilyName());
+            }
         }
 
-        // Likewise, getting the public folder from an extension is an async operation.
-        auto foundFolder = extractValueFromTaskWithoutMainThreadAwait(ext.GetPublicFolderAsync());
-        if (!foundFolder)
+        for (const auto& file : fragmentFiles)
         {
-            continue;
+            try
+            {
+                const auto content = ReadUTF8File(file.path);
+                fragments->push_back({ file.source, content.empty() ? Json::Value{ Json::ValueType::objectValue } : _parseJSON(content) });
+            }
+            CATCH_LOG();
         }
 
-        // the StorageFolder class has its own methods for obtaining the files within the folder
-        // however, all those methods are Async methods
-        // you may have noticed that we need to resort to clunky implementations for async operations
-        // (they are in extractValueFromTaskWithoutMainThreadAwait)
-        // so for now we will just take the folder path and access the files that way
-        const auto path = buildPath(foundFolder.Path(), FragmentsSubDirectory);
+        _snapshot.Update(SettingsSnapshot::LayerKind::Fragments, snapshotKey, *fragments);
+    }
 
-        if (std::filesystem::is_directory(path))
+    for (auto& fragment : *fragments)
+    {
+        try
         {
-            parseAndLayerFragmentFiles(path, packageName);
+            _parseFragment(fragment.source, _splitJson(std::move(fragment.json)), fragmentSettings);
         }
+        CATCH_LOG();
     }
 }
 
@@ -325,7 +427,7 @@ void SettingsLoader::FindFragmentsAndMergeIntoUserSettings()
 void SettingsLoader::MergeFragmentIntoUserSettings(const winrt::hstring& source, const std::string_view& content)
 {
     ParsedSettings fragmentSettings;
-    _parseFragment(source, content, fragmentSettings);
+    _parseFragment(source, _parseJson(content), fragmentSettings);
 }
 
 // Call this method before passing SettingsLoader to the CascadiaSettings constructor.
@@ -464,6 +566,18 @@ bool SettingsLoader::FixupUserSettings()
     return fixedUp;
 }
 
+// Writes the layers that had to be parsed from their sources to the settings snapshot.
+// Call this once all layers were deserialized, so that the snapshot never contains a layer that fails to load.
+// (Deserialization errors are reported with their line and column, which the snapshot doesn't store.)
+void SettingsLoader::SaveSnapshot()
+{
+    try
+    {
+        _snapshot.Save();
+    }
+    CATCH_LOG();
+}
+
 // Give a string of length N and a position of [0,N) this function returns
 // the line/column within the string, similar to how text editors do it.
 // Newlines are considered part of the current line (as per POSIX).
@@ -559,12 +673,10 @@ std::span<const winrt::com_ptr<Profile>> SettingsLoader::_getNonUserOriginProfil
     return std::span{ userSettings.profiles }.subspan(_userProfileCount);
 }
 
-// Parses the given JSON string ("content") and fills a ParsedSettings instance with it.
+// Deserializes the given settings JSON and fills a ParsedSettings instance with it.
 // This function is to be used for user settings files.
-void SettingsLoader::_parse(const OriginTag origin, const winrt::hstring& source, const std::string_view& content, ParsedSettings& settings)
+void SettingsLoader::_parse(const OriginTag origin, const winrt::hstring& source, const JsonSettings& json, ParsedSettings& settings)
 {
-    const auto json = _parseJson(content);
-
     settings.clear();
 
     {
@@ -627,10 +739,8 @@ void SettingsLoader::_parse(const OriginTag origin, const winrt::hstring& source
 
 // Just like _parse, but is to be used for fragment files, which don't support anything but color
 // schemes and profiles. Additionally this function supports profiles which specify an "updates" key.
-void SettingsLoader::_parseFragment(const winrt::hstring& source, const std::string_view& content, ParsedSettings& settings)
+void SettingsLoader::_parseFragment(const winrt::hstring& source, const JsonSettings& json, ParsedSettings& settings)
 {
-    const auto json = _parseJson(content);
-
     settings.clear();
 
     {
@@ -696,7 +806,12 @@ void SettingsLoader::_parseFragment(const winrt::hstring& source, const std::str
 
 SettingsLoader::JsonSettings SettingsLoader::_parseJson(const std::string_view& content)
 {
-    auto root = content.empty() ? Json::Value{ Json::ValueType::objectValue } : _parseJSON(content);
+    return _splitJson(content.empty() ? Json::Value{ Json::ValueType::objectValue } : _parseJSON(content));
+}
+
+// Finds the parts of the given settings JSON that _parse() and _parseFragment() are interested in.
+SettingsLoader::JsonSettings SettingsLoader::_splitJson(Json::Value root)
+{
     const auto& colorSchemes = _getJSONValue(root, SchemesKey);
     const auto& themes = _getJSONValue(root, ThemesKey);
     const auto& profilesObject = _getJSONValue(root, ProfilesKey);
@@ -705,6 +820,22 @@ SettingsLoader::JsonSettings SettingsLoader::_parseJson(const std::string_view&
     return JsonSettings{ std::move(root), colorSchemes, profileDefaults, profilesList, themes };
 }
 
+// Returns the JSON of a layer that consists of a single string, namely settings.json or defaults.json.
+// If the settings snapshot contains the layer and the content didn't change, it's decoded from there.
+// Otherwise the content is parsed and the layer in the snapshot is updated.
+Json::Value SettingsLoader::_parseLayer(SettingsSnapshot::LayerKind kind, const std::string_view& content)
+{
+    const uint64_t key = til::hash(content);
+    if (auto json = _snapshot.ReadSingle(kind, key))
+    {
+        return std::move(*json);
+    }
+
+    auto json = content.empty() ? Json::Value{ Json::ValueType::objectValue } : _parseJSON(content);
+    _snapshot.UpdateSingle(kind, key, json);
+    return json;
+}
+
 // Just a common helper function between _parse and _parseFragment.
 // Parses a profile and ensures it has a Guid if possible.
 winrt::com_ptr<Profile> SettingsLoader::_parseProfile(const OriginTag origin, const winrt::hstring& source, const Json::Value& profileJson)
@@ -791,35 +922,207 @@ void SettingsLoader::_addUserProfileParent(const winrt::com_ptr<implementation::
     }
 }
 
-// As the name implies it executes a generator.
-// Generated profiles are added to .inboxSettings. Used by GenerateProfiles().
-void SettingsLoader::_executeGenerator(const IDynamicProfileGenerator& generator)
+// As the name implies it executes the generators. Used by GenerateProfiles().
+// They spend most of their time waiting for the file system, the registry or COM
+// and so they're run concurrently. Generated profiles are added to .inboxSettings
+// in the order of the given generators, just as if they had been run one after another.
+//
+// If a cachePath is given, the generated profiles are stored in that file together
+// with the generator's GetCacheKey(). On the next launch a generator is skipped
+// if its key didn't change and its profiles are read from the cache instead.
+void SettingsLoader::_executeGenerators(std::span<const IDynamicProfileGenerator* const> generators, const std::filesystem::path& cachePath)
 {
-    const auto generatorNamespace = generator.GetNamespace();
-    if (_ignoredNamespaces.count(generatorNamespace))
+    struct GeneratorRun
     {
-        return;
+        const IDynamicProfileGenerator* generator = nullptr;
+        // The key and profiles stored in the cache by the previous launch, if any.
+        std::wstring cachedKey;
+        const Json::Value* cachedProfiles = nullptr;
+        // The current key. Empty if the generator doesn't support caching or failed.
+        std::wstring cacheKey;
+        bool cacheHit = false;
+        std::vector<winrt::com_ptr<Profile>> profiles;
+    };
+
+    const auto useCache = !cachePath.empty();
+    std::string version;
+    Json::Value cache;
+
+    if (useCache)
+    {
+        try
+        {
+            // An update may change what the generators return, so the cache is only valid for one version.
+            version = til::u16u8(CascadiaSettings::ApplicationVersion());
+
+            // The parsed cache is a layer of the settings snapshot, keyed by the cache file's size and last write time.
+            if (auto json = _snapshot.ReadSingle(SettingsSnapshot::LayerKind::Generated, fileStampKey(cachePath)))
+            {
+                cache = std::move(*json);
+            }
+            else if (const auto content = ReadUTF8FileIfExists(cachePath))
+            {
+                cache = _parseJSON(*content);
+                _snapshot.UpdateSingle(SettingsSnapshot::LayerKind::Generated, fileStampKey(cachePath), cache);
+            }
+        }
+        CATCH_LOG()
     }
 
-    const auto previousSize = inboxSettings.profiles.size();
+    const auto& cachedVersion = _getJSONValue(cache, GeneratorCacheVersionKey);
+    const auto& cachedGenerators = cachedVersion.isString() && cachedVersion.asString() == version ? _getJSONValue(cache, GeneratorCacheGeneratorsKey) : Json::Value::nullSingleton();
 
-    try
+    std::vector<GeneratorRun> runs;
+    runs.reserve(generators.size());
+
+    for (const auto generator : generators)
+    {
+        const auto generatorNamespace = generator->GetNamespace();
+        if (_ignoredNamespaces.count(generatorNamespace))
+        {
+            continue;
+        }
+
+        auto& run = runs.emplace_back();
+        run.generator = generator;
+
+        const auto& entry = _getJSONValue(cachedGenerators, til::u16u8(generatorNamespace));
+        const auto& key = _getJSONValue(entry, GeneratorCacheKeyKey);
+        const auto& profiles = _getJSONValue(entry, ProfilesKey);
+        if (key.isString() && profiles.isArray())
+        {
+            run.cachedKey = til::u8u16(key.asString());
+            run.cachedProfiles = &profiles;
+        }
+    }
+
+    const auto execute = [useCache](GeneratorRun& run) {
+        const auto generatorNamespace = run.generator->GetNamespace();
+
+        if (useCache)
+        {
+            try
+            {
+                run.cacheKey = run.generator->GetCacheKey();
+            }
+            CATCH_LOG()
+
+            if (!run.cacheKey.empty() && run.cacheKey == run.cachedKey)
+            {
+                try
+                {
+                    for (const auto& profileJson : *run.cachedProfiles)
+                    {
+                        run.profiles.emplace_back(Profile::FromJson(profileJson));
+                    }
+                    run.cacheHit = true;
+                    return;
+                }
+                CATCH_LOG()
+
+                // The cache is corrupted. Fall back to running the generator.
+                run.profiles.clear();
+            }
+        }
+
+        try
+        {
+            run.generator->GenerateProfiles(run.profiles);
+        }
+        catch (...)
+        {
+            LOG_CAUGHT_EXCEPTION_MSG("Dynamic Profile Namespace: \"%.*s\"", gsl::narrow<int>(generatorNamespace.size()), generatorNamespace.data());
+            // Don't cache the results of a generator that failed.
+            run.cacheKey.clear();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(runs.size());
+
+    for (auto& run : runs)
+    {
+        try
+        {
+            threads.emplace_back([&execute, &run]() {
+                try
+                {
+                    // The Visual Studio and PowerShell generators use COM and WinRT respectively.
+                    winrt::init_apartment(winrt::apartment_type::multi_threaded);
+                    const auto uninit = wil::scope_exit([]() noexcept { winrt::uninit_apartment(); });
+                    execute(run);
+                }
+                CATCH_LOG()
+            });
+        }
+        catch (...)
+        {
+            LOG_CAUGHT_EXCEPTION();
+            // We failed to spawn a thread. Run the generator on this one instead.
+            execute(run);
+        }
+    }
+
+    for (auto& thread : threads)
     {
-        generator.GenerateProfiles(inboxSettings.profiles);
+        thread.join();
     }
-    CATCH_LOG_MSG("Dynamic Profile Namespace: \"%.*s\"", gsl::narrow<int>(generatorNamespace.size()), generatorNamespace.data())
 
-    // If the generator produced some profiles we're going to give them default attributes.
-    // By setting the Origin/Source/etc. here, we deduplicate some code and ensure they aren't missing accidentally.
-    if (inboxSettings.profiles.size() > previousSize)
+    Json::Value newGenerators{ Json::ValueType::objectValue };
+    auto cacheChanged = false;
+
+    for (auto& run : runs)
     {
+        const auto generatorNamespace = run.generator->GetNamespace();
+
+        if (!run.cacheKey.empty())
+        {
+            auto& entry = newGenerators[til::u16u8(generatorNamespace)];
+            entry[JsonKey(GeneratorCacheKeyKey)] = til::u16u8(run.cacheKey);
+
+            if (run.cacheHit)
+            {
+                entry[JsonKey(ProfilesKey)] = *run.cachedProfiles;
+            }
+            else
+            {
+                // This happens before the Source() is set below, so that ToJson() only
+                // serializes the properties the generator set itself.
+                Json::Value profiles{ Json::ValueType::arrayValue };
+                for (const auto& profile : run.profiles)
+                {
+                    profiles.append(profile->ToJson());
+                }
+                entry[JsonKey(ProfilesKey)] = std::move(profiles);
+                cacheChanged = true;
+            }
+        }
+
+        // If the generator produced some profiles we're going to give them default attributes.
+        // By setting the Origin/Source/etc. here, we deduplicate some code and ensure they aren't missing accidentally.
         const winrt::hstring source{ generatorNamespace };
 
-        for (const auto& profile : std::span(inboxSettings.profiles).subspan(previousSize))
+        for (auto& profile : run.profiles)
         {
             profile->Origin(OriginTag::Generated);
             profile->Source(source);
+            inboxSettings.profiles.emplace_back(std::move(profile));
+        }
+    }
+
+    if (useCache && cacheChanged)
+    {
+        try
+        {
+            Json::Value json{ Json::ValueType::objectValue };
+            json[JsonKey(GeneratorCacheVersionKey)] = version;
+            json[JsonKey(GeneratorCacheGeneratorsKey)] = std::move(newGenerators);
+
+            Json::StreamWriterBuilder wbuilder;
+            WriteUTF8FileAtomic(cachePath, Json::writeString(wbuilder, json));
+            _snapshot.UpdateSingle(SettingsSnapshot::LayerKind::Generated, fileStampKey(cachePath), json);
         }
+        CATCH_LOG()
     }
 }
 
@@ -878,11 +1181,15 @@ try
     const auto settingsStringView = (firstTimeSetup && !releaseSettingExists) ? UserSettingsJson : settingsString;
     auto mustWriteToDisk = firstTimeSetup;
 
-    SettingsLoader loader{ settingsStringView, DefaultJson };
+    // Elevated instances don't use the settings snapshot or the generator cache,
+    // just like they don't share their state.json with unelevated ones.
+    const auto elevated = ::Microsoft::Console::Utils::IsRunningElevated();
+
+    SettingsLoader loader{ settingsStringView, DefaultJson, elevated ? std::filesystem::path{} : _settingsSnapshotPath() };
 
     // Generate dynamic profiles and add them as parents of user profiles.
     // That way the user profiles will get appropriate defaults from the generators (like icons and such).
-    loader.GenerateProfiles();
+    loader.GenerateProfiles(elevated ? std::filesystem::path{} : _generatorCachePath());
 
     // ApplyRuntimeInitialSettings depends on generated profiles.
     // --> ApplyRuntimeInitialSettings must be called after GenerateProfiles.
@@ -903,6 +1210,8 @@ try
     mustWriteToDisk |= loader.DisableDeletedProfiles();
     mustWriteToDisk |= loader.FixupUserSettings();
 
+    loader.SaveSnapshot();
+
     // If this throws, the app will catch it and use the default settings.
     const auto settings = winrt::make_self<CascadiaSettings>(std::move(loader));
 
@@ -1138,6 +1447,30 @@ const std::filesystem::path& CascadiaSettings::_releaseSettingsPath()
     return path;
 }
 
+// Method Description:
+// - Returns the path of the file in which the results of the dynamic profile generators are cached.
+// Arguments:
+// - <none>
+// Return Value:
+// - Path to the generator cache
+const std::filesystem::path& CascadiaSettings::_generatorCachePath()
+{
+    static const auto path = GetBaseSettingsPath() / GeneratorCacheFilename;
+    return path;
+}
+
+// Method Description:
+// - Returns the path of the SettingsSnapshot, which contains the parsed JSON of each settings layer.
+// Arguments:
+// - <none>
+// Return Value:
+// - Path to the settings snapshot
+const std::filesystem::path& CascadiaSettings::_settingsSnapshotPath()
+{
+    static const auto path = GetBaseSettingsPath() / SettingsSnapshotFilename;
+    return path;
+}
+
 // Returns a has (approximately) uniquely identifying the settings.json contents on disk.
 winrt::hstring CascadiaSettings::_calculateHash(std::string_view settings, const FILETIME& lastWriteTime)
 {
@@ -28,3 +28,39 @@ winrt::com_ptr<winrt::Microsoft::Terminal::Settings::Model::implementation::Prof
     profile->Icon(winrt::hstring{ iconPath });
     return profile;
 }
+
+// Method Description:
+// - Helper function for IDynamicProfileGenerator::GetCacheKey() implementations.
+//   Appends the last write time of the given file or directory to the key.
+//   Files that don't exist are written as 0, so that creating them changes the key as well.
+// Arguments:
+// - key: the cache key to append to.
+// - path: the path of the file. May contain environment variables.
+void AppendLastWriteTimeToCacheKey(std::wstring& key, const wchar_t* path)
+{
+    const auto expandedPath = wil::ExpandEnvironmentStringsW<std::wstring>(path);
+    WIN32_FILE_ATTRIBUTE_DATA data{};
+    if (!GetFileAttributesExW(expandedPath.c_str(), GetFileExInfoStandard, &data))
+    {
+        data.ftLastWriteTime = {};
+    }
+    fmt::format_to(std::back_inserter(key), FMT_COMPILE(L"{:x};"), wil::filetime::to_int64(data.ftLastWriteTime));
+}
+
+// Method Description:
+// - Like AppendLastWriteTimeToCacheKey, but for a file whose contents matter.
+//   Appends the path itself, as well as the size and last write time of the file,
+//   so that updating an executable in place changes the key.
+// Arguments:
+// - key: the cache key to append to.
+// - path: the resolved path of the file.
+void AppendFileStampToCacheKey(std::wstring& key, const std::filesystem::path& path)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data{};
+    if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
+    {
+        data = {};
+    }
+    const auto size = (uint64_t{ data.nFileSizeHigh } << 32) | data.nFileSizeLow;
+    fmt::format_to(std::back_inserter(key), FMT_COMPILE(L"{}|{:x}|{:x};"), path.native(), size, wil::filetime::to_int64(data.ftLastWriteTime));
+}
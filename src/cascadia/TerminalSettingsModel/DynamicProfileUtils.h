@@ -24,3 +24,5 @@ Author(s):
 inline constexpr GUID TERMINAL_PROFILE_NAMESPACE_GUID = { 0x2bde4a90, 0xd05f, 0x401c, { 0x94, 0x92, 0xe4, 0x8, 0x84, 0xea, 0xd1, 0xd8 } };
 
 winrt::com_ptr<winrt::Microsoft::Terminal::Settings::Model::implementation::Profile> CreateDynamicProfile(const std::wstring_view& name);
+void AppendLastWriteTimeToCacheKey(std::wstring& key, const wchar_t* path);
+void AppendFileStampToCacheKey(std::wstring& key, const std::filesystem::path& path);
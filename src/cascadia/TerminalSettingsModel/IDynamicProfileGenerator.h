@@ -13,6 +13,10 @@ Abstract:
 - Each DPG must have a unique namespace to associate with itself. If the
   namespace is not unique, the generator risks affecting profiles from
   conflicting generators.
+- A DPG may additionally return a cache key which describes the external state
+  it scanned (e.g. the last write time of the directories it enumerates).
+  As long as that key doesn't change, the profiles generated during the
+  previous launch are reused and GenerateProfiles() isn't called at all.
 
 Author(s):
 - Mike Griese - August 2019
@@ -31,5 +35,10 @@ namespace winrt::Microsoft::Terminal::Settings::Model
         virtual ~IDynamicProfileGenerator() = default;
         virtual std::wstring_view GetNamespace() const noexcept = 0;
         virtual void GenerateProfiles(std::vector<winrt::com_ptr<implementation::Profile>>& profiles) const = 0;
+        // An empty key means that the generator can't be cached and must always be run.
+        virtual std::wstring GetCacheKey() const
+        {
+            return {};
+        }
     };
 };
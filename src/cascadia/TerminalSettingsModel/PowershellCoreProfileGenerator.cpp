@@ -338,6 +338,47 @@ void PowershellCoreProfileGenerator::GenerateProfiles(std::vector<winrt::com_ptr
     }
 }
 
+// Function Description:
+// - Appends the stamp of every ROOT\<version>\pwsh.exe to the cache key.
+//   The last write time of the root changes when a version is added or removed,
+//   but not when one is updated in place, which is why each pwsh.exe is included.
+static void _appendTraditionalLayoutToCacheKey(const wchar_t* directory, std::wstring& key)
+{
+    AppendLastWriteTimeToCacheKey(key, directory);
+
+    const std::filesystem::path root{ wil::ExpandEnvironmentStringsW<std::wstring>(directory) };
+    std::error_code ec;
+    for (const auto& versionedDir : std::filesystem::directory_iterator(root, ec))
+    {
+        AppendFileStampToCacheKey(key, versionedDir.path() / PWSH_EXE);
+    }
+}
+
+// Method Description:
+// - Returns the path, size and last write time of all the pwsh.exe that _collectPowerShellInstances() may find.
+//   Only the queries for the store packages are skipped, as those are the expensive part.
+std::wstring PowershellCoreProfileGenerator::GetCacheKey() const
+{
+    std::wstring key;
+    _appendTraditionalLayoutToCacheKey(L"%ProgramFiles%\\PowerShell", key);
+#if defined(_M_AMD64) || defined(_M_ARM64)
+    _appendTraditionalLayoutToCacheKey(L"%ProgramFiles(x86)%\\PowerShell", key);
+#endif
+#if defined(_M_ARM64)
+    _appendTraditionalLayoutToCacheKey(L"%ProgramFiles(Arm)%\\PowerShell", key);
+#endif
+    for (const auto path : {
+             L"%LOCALAPPDATA%\\Microsoft\\WindowsApps\\Microsoft.PowerShell_8wekyb3d8bbwe\\pwsh.exe",
+             L"%LOCALAPPDATA%\\Microsoft\\WindowsApps\\Microsoft.PowerShellPreview_8wekyb3d8bbwe\\pwsh.exe",
+             L"%USERPROFILE%\\.dotnet\\tools\\pwsh.exe",
+             L"%USERPROFILE%\\scoop\\shims\\pwsh.exe",
+         })
+    {
+        AppendFileStampToCacheKey(key, wil::ExpandEnvironmentStringsW<std::wstring>(path));
+    }
+    return key;
+}
+
 // Function Description:
 // - Returns the thing it's named for.
 // Return value:
@@ -0,0 +1,449 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "SettingsSnapshot.h"
+
+#include "FileUtils.h"
+
+using namespace winrt::Microsoft::Terminal::Settings::Model;
+
+// The file starts with a SnapshotHeader, followed by SnapshotHeader::count layers.
+// Each layer is a LayerHeader, followed by LayerHeader::size bytes with LayerHeader::count entries.
+// Each entry is its source (a string), followed by its JSON (a value).
+//
+// A string is its length in bytes (uint32_t), followed by its UTF-8 contents.
+// A value is a ValueTag, followed by:
+// * Int/UInt/Real: an int64_t/uint64_t/double
+// * String: a string
+// * Array: the number of items (uint32_t), followed by the items (values)
+// * Object: the number of members (uint32_t), followed by each member's name (string) and value
+//
+// Nothing is aligned, so everything is read with memcpy().
+static constexpr uint32_t SnapshotMagic = 0x53535457; // "WTSS"
+static constexpr uint32_t SnapshotVersion = 1;
+// Settings are usually a few hundred KB large at most. Anything beyond this is most likely not a snapshot we wrote.
+static constexpr LONGLONG SnapshotSizeLimit = 64 * 1024 * 1024;
+// The same nesting limit as jsoncpp's CharReader, which produced the JSON to begin with.
+static constexpr int SnapshotDepthLimit = 1000;
+
+struct SnapshotHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t buildKey;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct LayerHeader
+{
+    uint32_t kind;
+    uint32_t count;
+    uint64_t key;
+    uint64_t size;
+};
+
+enum class ValueTag : uint8_t
+{
+    Null,
+    False,
+    True,
+    Int,
+    UInt,
+    Real,
+    String,
+    Array,
+    Object,
+};
+
+template<typename T>
+static void append(std::string& buffer, const T& value)
+{
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void appendString(std::string& buffer, const std::string_view& str)
+{
+    append(buffer, gsl::narrow<uint32_t>(str.size()));
+    buffer.append(str);
+}
+
+static void appendValue(std::string& buffer, const Json::Value& value)
+{
+    switch (value.type())
+    {
+    case Json::ValueType::booleanValue:
+        append(buffer, value.asBool() ? ValueTag::True : ValueTag::False);
+        break;
+    case Json::ValueType::intValue:
+        append(buffer, ValueTag::Int);
+        append(buffer, value.asInt64());
+        break;
+    case Json::ValueType::uintValue:
+        append(buffer, ValueTag::UInt);
+        append(buffer, value.asUInt64());
+        break;
+    case Json::ValueType::realValue:
+        append(buffer, ValueTag::Real);
+        append(buffer, value.asDouble());
+        break;
+    case Json::ValueType::stringValue:
+    {
+        // getString() fails for strings without a buffer, which are empty.
+        const char* beg = nullptr;
+        const char* end = nullptr;
+        value.getString(&beg, &end);
+        append(buffer, ValueTag::String);
+        appendString(buffer, { beg, gsl::narrow_cast<size_t>(end - beg) });
+        break;
+    }
+    case Json::ValueType::arrayValue:
+        append(buffer, ValueTag::Array);
+        append(buffer, gsl::narrow<uint32_t>(value.size()));
+        for (const auto& item : value)
+        {
+            appendValue(buffer, item);
+        }
+        break;
+    case Json::ValueType::objectValue:
+        append(buffer, ValueTag::Object);
+        append(buffer, gsl::narrow<uint32_t>(value.size()));
+        for (auto it = value.begin(); it != value.end(); ++it)
+        {
+            const char* end = nullptr;
+            const auto beg = it.memberName(&end);
+            appendString(buffer, { beg, gsl::narrow_cast<size_t>(end - beg) });
+            appendValue(buffer, *it);
+        }
+        break;
+    default:
+        append(buffer, ValueTag::Null);
+        break;
+    }
+}
+
+namespace
+{
+    // Reads the encoding described at the top of this file.
+    // Every length is checked against the remaining data, as the file might be truncated or corrupted.
+    class SnapshotReader
+    {
+    public:
+        explicit SnapshotReader(std::span<const uint8_t> data) noexcept :
+            _data{ data }
+        {
+        }
+
+        template<typename T>
+        T Read()
+        {
+            T value;
+            memcpy(&value, _take(sizeof(T)).data(), sizeof(T));
+            return value;
+        }
+
+        std::string_view ReadString()
+        {
+            const auto size = Read<uint32_t>();
+            const auto data = _take(size);
+            return { reinterpret_cast<const char*>(data.data()), data.size() };
+        }
+
+        Json::Value ReadValue(int depth = 0)
+        {
+            THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), depth >= SnapshotDepthLimit);
+
+            switch (Read<ValueTag>())
+            {
+            case ValueTag::Null:
+                return {};
+            case ValueTag::False:
+                return false;
+            case ValueTag::True:
+                return true;
+            case ValueTag::Int:
+                return Read<Json::Int64>();
+            case ValueTag::UInt:
+                return Read<Json::UInt64>();
+            case ValueTag::Real:
+                return Read<double>();
+            case ValueTag::String:
+            {
+                const auto str = ReadString();
+                return { str.data(), str.data() + str.size() };
+            }
+            case ValueTag::Array:
+            {
+                // Each item is at least 1 byte large, which protects us against bogus counts.
+                const auto count = Read<uint32_t>();
+                THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), count > _remaining());
+
+                Json::Value array{ Json::ValueType::arrayValue };
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    array.append(ReadValue(depth + 1));
+                }
+                return array;
+            }
+            case ValueTag::Object:
+            {
+                // Each member is at least 5 bytes large (the name's length and the value's tag).
+                const auto count = Read<uint32_t>();
+                THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), count > _remaining() / 5);
+
+                Json::Value object{ Json::ValueType::objectValue };
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    const auto name = ReadString();
+                    auto value = ReadValue(depth + 1);
+                    *object.demand(name.data(), name.data() + name.size()) = std::move(value);
+                }
+                return object;
+            }
+            default:
+                THROW_HR(HRESULT_FROM_WIN32(ERROR_INVALID_DATA));
+            }
+        }
+
+    private:
+        size_t _remaining() const noexcept
+        {
+            return _data.size() - _offset;
+        }
+
+        std::span<const uint8_t> _take(size_t size)
+        {
+            THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), size > _remaining());
+            const auto data = _data.subspan(_offset, size);
+            _offset += size;
+            return data;
+        }
+
+        std::span<const uint8_t> _data;
+        size_t _offset = 0;
+    };
+}
+
+// Maps the snapshot stored at the given path. If it doesn't exist, is corrupted or was written by
+// a different build (buildKey), the returned snapshot is empty, but Update() and Save() still work.
+// A default constructed SettingsSnapshot on the other hand ignores calls to Update() and Save().
+SettingsSnapshot SettingsSnapshot::Open(const std::filesystem::path& path, uint64_t buildKey) noexcept
+{
+    SettingsSnapshot snapshot;
+
+    try
+    {
+        snapshot._path = path;
+        snapshot._buildKey = buildKey;
+
+        // Save() replaces the file by renaming a new one over it, so it never changes while it's mapped.
+        const wil::unique_hfile file{ CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+        if (!file)
+        {
+            return snapshot;
+        }
+
+        LARGE_INTEGER size{};
+        THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(file.get(), &size));
+        if (size.QuadPart < static_cast<LONGLONG>(sizeof(SnapshotHeader)) || size.QuadPart > SnapshotSizeLimit)
+        {
+            return snapshot;
+        }
+
+        const wil::unique_handle mapping{ CreateFileMappingW(file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr) };
+        THROW_LAST_ERROR_IF(!mapping);
+
+        snapshot._view.reset(static_cast<uint8_t*>(MapViewOfFile(mapping.get(), FILE_MAP_READ, 0, 0, 0)));
+        THROW_LAST_ERROR_IF(!snapshot._view);
+        snapshot._size = gsl::narrow_cast<size_t>(size.QuadPart);
+
+        if (!snapshot._parse())
+        {
+            snapshot._view.reset();
+            snapshot._size = 0;
+            snapshot._layers.clear();
+        }
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        snapshot._view.reset();
+        snapshot._size = 0;
+        snapshot._layers.clear();
+    }
+
+    return snapshot;
+}
+
+// Returns the entries of the given layer, or nullopt if the snapshot
+// doesn't contain the layer, its key doesn't match or it's corrupted.
+std::optional<std::vector<SettingsSnapshot::Entry>> SettingsSnapshot::Read(LayerKind kind, uint64_t key) const noexcept
+try
+{
+    const auto it = std::ranges::find_if(_layers, [&](const LayerView& layer) {
+        return layer.kind == kind && layer.key == key;
+    });
+    if (it == _layers.end())
+    {
+        return std::nullopt;
+    }
+
+    SnapshotReader reader{ std::span{ _view.get(), _size }.subspan(it->offset, it->size) };
+    std::vector<Entry> entries;
+    entries.reserve(it->count);
+
+    for (uint32_t i = 0; i < it->count; ++i)
+    {
+        auto& entry = entries.emplace_back();
+        entry.source = winrt::hstring{ til::u8u16(reader.ReadString()) };
+        entry.json = reader.ReadValue();
+    }
+
+    return entries;
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return std::nullopt;
+}
+
+// Like Read(), but for layers with a single entry without a source, like settings.json. See UpdateSingle().
+std::optional<Json::Value> SettingsSnapshot::ReadSingle(LayerKind kind, uint64_t key) const noexcept
+{
+    auto entries = Read(kind, key);
+    if (!entries || entries->size() != 1)
+    {
+        return std::nullopt;
+    }
+    return std::move(entries->front().json);
+}
+
+// Replaces the given layer with the given entries. Call Save() to write the changes to disk.
+void SettingsSnapshot::Update(LayerKind kind, uint64_t key, std::span<const Entry> entries)
+{
+    if (const auto data = _replaceLayer(kind, key, entries.size()))
+    {
+        for (const auto& entry : entries)
+        {
+            appendString(*data, til::u16u8(entry.source));
+            appendValue(*data, entry.json);
+        }
+    }
+}
+
+// Replaces the given layer with a single entry without a source.
+void SettingsSnapshot::UpdateSingle(LayerKind kind, uint64_t key, const Json::Value& json)
+{
+    if (const auto data = _replaceLayer(kind, key, 1))
+    {
+        appendString(*data, {});
+        appendValue(*data, json);
+    }
+}
+
+// Writes the snapshot to disk, if any layer was updated. The layers
+// that weren't updated are copied over from the current file as is.
+void SettingsSnapshot::Save()
+{
+    if (_path.empty() || _updatedLayers.empty())
+    {
+        return;
+    }
+
+    std::string buffer;
+    uint32_t count = 0;
+
+    // The header is filled in at the end, once we know the number of layers.
+    buffer.resize(sizeof(SnapshotHeader));
+
+    for (const auto& layer : _layers)
+    {
+        const auto updated = std::ranges::any_of(_updatedLayers, [&](const UpdatedLayer& u) {
+            return u.kind == layer.kind;
+        });
+        if (!updated)
+        {
+            const auto data = std::span{ _view.get(), _size }.subspan(layer.offset, layer.size);
+            append(buffer, LayerHeader{ static_cast<uint32_t>(layer.kind), layer.count, layer.key, layer.size });
+            buffer.append(reinterpret_cast<const char*>(data.data()), data.size());
+            count++;
+        }
+    }
+
+    for (const auto& layer : _updatedLayers)
+    {
+        append(buffer, LayerHeader{ static_cast<uint32_t>(layer.kind), layer.count, layer.key, layer.data.size() });
+        buffer.append(layer.data);
+        count++;
+    }
+
+    const SnapshotHeader header{ SnapshotMagic, SnapshotVersion, _buildKey, count, 0 };
+    memcpy(buffer.data(), &header, sizeof(header));
+
+    // The file can't be replaced while it's mapped.
+    _view.reset();
+    _size = 0;
+    _layers.clear();
+    _updatedLayers.clear();
+
+    WriteUTF8FileAtomic(_path, buffer);
+}
+
+// Validates the header of the mapped file and of each of its layers and fills _layers.
+bool SettingsSnapshot::_parse()
+{
+    SnapshotReader reader{ std::span{ _view.get(), _size } };
+
+    const auto header = reader.Read<SnapshotHeader>();
+    if (header.magic != SnapshotMagic || header.version != SnapshotVersion || header.buildKey != _buildKey)
+    {
+        return false;
+    }
+
+    auto offset = sizeof(SnapshotHeader);
+    std::vector<LayerView> layers;
+
+    for (uint32_t i = 0; i < header.count; ++i)
+    {
+        if (_size - offset < sizeof(LayerHeader))
+        {
+            return false;
+        }
+
+        LayerHeader layer;
+        memcpy(&layer, _view.get() + offset, sizeof(layer));
+        offset += sizeof(layer);
+
+        if (layer.size > _size - offset)
+        {
+            return false;
+        }
+
+        const auto size = gsl::narrow_cast<size_t>(layer.size);
+        layers.push_back({ static_cast<LayerKind>(layer.kind), layer.key, layer.count, offset, size });
+        offset += size;
+    }
+
+    _layers = std::move(layers);
+    return true;
+}
+
+// Returns the buffer for the new contents of the given layer, or nullptr if the snapshot is disabled.
+std::string* SettingsSnapshot::_replaceLayer(LayerKind kind, uint64_t key, size_t count)
+{
+    if (_path.empty())
+    {
+        return nullptr;
+    }
+
+    std::erase_if(_updatedLayers, [&](const UpdatedLayer& layer) {
+        return layer.kind == kind;
+    });
+
+    auto& layer = _updatedLayers.emplace_back();
+    layer.kind = kind;
+    layer.key = key;
+    layer.count = gsl::narrow<uint32_t>(count);
+    return &layer.data;
+}
@@ -0,0 +1,78 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- SettingsSnapshot.h
+
+Abstract:
+- A binary snapshot of the parsed JSON of each settings layer: settings.json, defaults.json,
+  the generator cache and all fragments. The next launch memory maps it and decodes the
+  Json::Value trees directly, instead of reading the files and parsing them with jsoncpp.
+  For fragments this also skips looking up the public folder of every app extension.
+- Each layer is keyed by a hash of its sources. A layer whose key doesn't match is ignored
+  and parsed from its sources again, while the others are still read from the snapshot.
+- The layers are kept separate instead of storing the resolved settings, because the settings
+  model has to know which layer each setting came from. The SettingsLoader still builds the
+  model from the decoded trees, exactly like it would from parsed ones.
+
+--*/
+#pragma once
+
+namespace winrt::Microsoft::Terminal::Settings::Model
+{
+    class SettingsSnapshot
+    {
+    public:
+        enum class LayerKind : uint32_t
+        {
+            User,
+            InBox,
+            Generated,
+            Fragments,
+        };
+
+        struct Entry
+        {
+            winrt::hstring source;
+            Json::Value json;
+        };
+
+        static SettingsSnapshot Open(const std::filesystem::path& path, uint64_t buildKey) noexcept;
+
+        std::optional<std::vector<Entry>> Read(LayerKind kind, uint64_t key) const noexcept;
+        std::optional<Json::Value> ReadSingle(LayerKind kind, uint64_t key) const noexcept;
+        void Update(LayerKind kind, uint64_t key, std::span<const Entry> entries);
+        void UpdateSingle(LayerKind kind, uint64_t key, const Json::Value& json);
+        void Save();
+
+    private:
+        struct LayerView
+        {
+            LayerKind kind{};
+            uint64_t key = 0;
+            uint32_t count = 0;
+            // The location of the layer's entries in the file.
+            size_t offset = 0;
+            size_t size = 0;
+        };
+
+        struct UpdatedLayer
+        {
+            LayerKind kind{};
+            uint64_t key = 0;
+            uint32_t count = 0;
+            std::string data;
+        };
+
+        bool _parse();
+        std::string* _replaceLayer(LayerKind kind, uint64_t key, size_t count);
+
+        std::filesystem::path _path;
+        uint64_t _buildKey = 0;
+        wil::unique_mapview_ptr<uint8_t> _view;
+        size_t _size = 0;
+        std::vector<LayerView> _layers;
+        std::vector<UpdatedLayer> _updatedLayers;
+    };
+}
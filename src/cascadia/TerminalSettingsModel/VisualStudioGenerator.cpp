@@ -9,11 +9,33 @@
 
 using namespace winrt::Microsoft::Terminal::Settings::Model;
 
+static constexpr wchar_t VsSetupInstancesPath[] = L"%ProgramData%\\Microsoft\\VisualStudio\\Packages\\_Instances";
+
 std::wstring_view VisualStudioGenerator::GetNamespace() const noexcept
 {
     return std::wstring_view{ L"Windows.Terminal.VisualStudio" };
 }
 
+// The setup engine keeps the state of each instance in VsSetupInstancesPath\{instance id}\state.json.
+// Installing, updating or removing an instance updates the last write time of the directory or that file.
+std::wstring VisualStudioGenerator::GetCacheKey() const
+{
+    std::wstring key;
+    AppendLastWriteTimeToCacheKey(key, VsSetupInstancesPath);
+
+    const std::filesystem::path root{ wil::ExpandEnvironmentStringsW<std::wstring>(VsSetupInstancesPath) };
+    if (std::filesystem::exists(root))
+    {
+        for (const auto& instanceDir : std::filesystem::directory_iterator(root))
+        {
+            const auto statePath = instanceDir.path() / L"state.json";
+            AppendLastWriteTimeToCacheKey(key, statePath.c_str());
+        }
+    }
+
+    return key;
+}
+
 void VisualStudioGenerator::GenerateProfiles(std::vector<winrt::com_ptr<implementation::Profile>>& profiles) const
 {
     const auto instances = VsSetupConfiguration::QueryInstances();
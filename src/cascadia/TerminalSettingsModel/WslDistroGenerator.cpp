@@ -208,6 +208,47 @@ static bool getWslNames(const wil::unique_hkey& wslRootKey,
     return true;
 }
 
+// Method Description:
+// - Returns the last write times of the Lxss key and its subkeys. Registering,
+//   unregistering or renaming a distro changes at least one of them.
+// Arguments:
+// - <none>
+// Return Value:
+// - The cache key.
+std::wstring WslDistroGenerator::GetCacheKey() const
+{
+    std::wstring key;
+    const auto wslRootKey{ openWslRegKey() };
+    if (!wslRootKey)
+    {
+        return key;
+    }
+
+    FILETIME lastWriteTime{};
+    if (RegQueryInfoKeyW(wslRootKey.get(), nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &lastWriteTime) != ERROR_SUCCESS)
+    {
+        return key;
+    }
+    fmt::format_to(std::back_inserter(key), FMT_COMPILE(L"{:x};"), wil::filetime::to_int64(lastWriteTime));
+
+    wchar_t buffer[256];
+    for (DWORD i = 0;; i++)
+    {
+        DWORD length = ARRAYSIZE(buffer);
+        const auto result = RegEnumKeyExW(wslRootKey.get(), i, &buffer[0], &length, nullptr, nullptr, nullptr, &lastWriteTime);
+        if (result == ERROR_NO_MORE_ITEMS)
+        {
+            break;
+        }
+        if (result == ERROR_SUCCESS)
+        {
+            fmt::format_to(std::back_inserter(key), FMT_COMPILE(L"{}={:x};"), std::wstring_view{ &buffer[0], length }, wil::filetime::to_int64(lastWriteTime));
+        }
+    }
+
+    return key;
+}
+
 // Method Description:
 // - Generate a list of profiles for each on the installed WSL distros. This
 //   will first try to read the installed distros from the registry. If that
@@ -38,6 +38,7 @@ namespace TerminalCoreUnitTests
         TEST_METHOD(AddHyperlink);
         TEST_METHOD(AddHyperlinkCustomId);
         TEST_METHOD(AddHyperlinkCustomIdDifferentUri);
+        TEST_METHOD(DetectUrlsIncrementally);
 
         TEST_METHOD(SetTaskbarProgress);
         TEST_METHOD(SetWorkingDirectory);
@@ -342,6 +343,53 @@ void TerminalCoreUnitTests::TerminalApiTest::AddHyperlinkCustomIdDifferentUri()
     VERIFY_ARE_NOT_EQUAL(oldAttributes.GetHyperlinkId(), tbi.GetCurrentAttributes().GetHyperlinkId());
 }
 
+void TerminalCoreUnitTests::TerminalApiTest::DetectUrlsIncrementally()
+{
+    Terminal term{ Terminal::TestDummyMarker{} };
+    DummyRenderer renderer{ &term };
+    term.Create({ 20, 5 }, 20, renderer);
+
+    auto& stateMachine = *(term._stateMachine);
+    const auto verifyMatchAt = [](const auto& patterns, til::point pos, til::point expectedStart, til::point expectedStop) {
+        const auto results = patterns.findOverlapping(pos, pos);
+        VERIFY_ARE_EQUAL(1u, results.size());
+        VERIFY_ARE_EQUAL(expectedStart, results.front().start);
+        VERIFY_ARE_EQUAL(expectedStop, results.front().stop);
+    };
+
+    // A URL within a single row and one that wraps from row 1 into row 2.
+    stateMachine.ProcessString(L"a http://a.com/b\r\n");
+    stateMachine.ProcessString(L"http://example.com/0123456789\r\n");
+
+    {
+        const auto patterns = term._getPatterns(0, 2);
+        verifyMatchAt(patterns, { 5, 0 }, { 2, 0 }, { 16, 0 });
+        verifyMatchAt(patterns, { 5, 2 }, { 0, 1 }, { 9, 2 });
+        VERIFY_ARE_EQUAL(2u, term._patternCache.size());
+    }
+
+    // Looking at just the second half of a wrapped URL still returns all of it.
+    {
+        const auto patterns = term._getPatterns(2, 2);
+        verifyMatchAt(patterns, { 5, 0 }, { 0, -1 }, { 9, 0 });
+        VERIFY_ARE_EQUAL(2u, term._patternCache.size());
+    }
+
+    // Only the modified row gets matched again.
+    stateMachine.ProcessString(L"\x1b[1;1Hb\x1b[4;1H");
+    {
+        const auto patterns = term._getPatterns(0, 2);
+        verifyMatchAt(patterns, { 5, 0 }, { 2, 0 }, { 16, 0 });
+        VERIFY_ARE_EQUAL(3u, term._patternCache.size());
+    }
+
+    // URLs that scrolled into the scrollback can still be looked up.
+    stateMachine.ProcessString(L"\r\n\r\n\r\n\r\n\r\n\r\n\r\n\r\n\r\n\r\n");
+    VERIFY_IS_GREATER_THAN(term._VisibleStartIndex(), 2);
+    VERIFY_ARE_EQUAL(L"http://a.com/b", term.GetHyperlinkAtBufferPosition({ 5, 0 }));
+    VERIFY_ARE_EQUAL(L"http://example.com/0123456789", term.GetHyperlinkAtBufferPosition({ 5, 2 }));
+}
+
 void TerminalCoreUnitTests::TerminalApiTest::SetTaskbarProgress()
 {
     Terminal term{ Terminal::TestDummyMarker{} };
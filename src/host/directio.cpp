@@ -470,7 +470,6 @@ CATCH_RETURN();
 {
     try
     {
-        const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
         const auto& storageBuffer = context.GetActiveBuffer().GetTextBuffer();
         const auto storageSize = storageBuffer.GetSize().Dimensions();
 
@@ -507,42 +506,35 @@ CATCH_RETURN();
 
         // We will start reading the buffer at the point of the top left corner (origin) of the (potentially adjusted) request
         const auto sourcePoint = clippedRequestRectangle.Origin();
+        const auto sourceSize = clippedRequestRectangle.Dimensions();
 
-        // Get an iterator to the beginning of the return buffer
-        // We might have to seek this forward or skip around if we clipped the request.
-        auto targetIter = targetBuffer.begin();
-        til::point targetPos;
-        const auto targetLimit = Viewport::FromDimensions(targetPoint, clippedRequestRectangle.Dimensions());
-
-        // Get an iterator to the beginning of the request inside the screen buffer
-        // This should walk exactly along every cell of the clipped request.
-        auto sourceIter = storageBuffer.GetCellDataAt(sourcePoint, clippedRequestRectangle);
-
-        // Walk through every cell of the target, advancing the buffer.
-        // Validate that we always still have a valid iterator to the backing store,
-        // that we always are writing inside the user's buffer (before the end)
-        // and we're always targeting the user's buffer inside its original bounds.
-        while (sourceIter && targetIter < targetBuffer.end())
+        // Copy the clipped request row by row into the user's buffer. Cells of the user's buffer outside the
+        // clipped request are skipped. Instead of converting each cell with CONSOLE_INFORMATION::AsCharInfo,
+        // the legacy attributes are computed once for each run of attributes in the row.
+        for (til::CoordType y = 0; y < sourceSize.height && sourceSize.width > 0; y++)
         {
-            // If the point we're trying to write is inside the limited buffer write zone...
-            if (targetLimit.IsInBounds(targetPos))
+            // Validate that we're always writing inside the user's buffer (before the end).
+            const auto targetOffset = gsl::narrow_cast<size_t>(targetPoint.y + y) * targetSize.width + targetPoint.x;
+            if (targetOffset >= targetBuffer.size())
             {
-                // Copy the data into position...
-                *targetIter = gci.AsCharInfo(*sourceIter);
-                // ... and advance the read iterator.
-                ++sourceIter;
+                break;
             }
 
-            // Always advance the write iterator, we might have skipped it due to clipping.
-            ++targetIter;
+            const auto width = std::min(gsl::narrow_cast<size_t>(sourceSize.width), targetBuffer.size() - targetOffset);
+            const auto target = targetBuffer.subspan(targetOffset, width);
+            const auto& row = storageBuffer.GetRowByOffset(sourcePoint.y + y);
+            const auto columnBegin = sourcePoint.x;
+            const auto columnEnd = gsl::narrow_cast<til::CoordType>(columnBegin + width);
 
-            // Increment the target
-            targetPos.x++;
-            if (targetPos.x >= targetSize.width)
-            {
-                targetPos.x = 0;
-                targetPos.y++;
-            }
+            row.ForEachAttributeRun(columnBegin, columnEnd, [&](const til::CoordType runBegin, const til::CoordType runEnd, const TextAttribute& attr) {
+                const auto legacyAttributes = attr.GetLegacyAttributes();
+                for (auto x = runBegin; x < runEnd; x++)
+                {
+                    auto& charInfo = til::at(target, gsl::narrow_cast<size_t>(x - columnBegin));
+                    charInfo.Char.UnicodeChar = Utf16ToUcs2(row.GlyphAt(x));
+                    charInfo.Attributes = legacyAttributes | GeneratePublicApiAttributeFormat(row.DbcsAttrAt(x));
+                }
+            });
         }
 
         // Reply with the region we read out of the backing buffer (potentially clipped)
@@ -683,12 +675,9 @@ CATCH_RETURN();
             // Now we make a subspan starting from that offset for as much of the original request as would fit
             const auto subspan = buffer.subspan(totalOffset, writeRectangle.Width());
 
-            // Convert to a CHAR_INFO view to fit into the iterator
+            // Convert to a read-only CHAR_INFO view and write it to the target position in bulk.
             const auto charInfos = std::span<const CHAR_INFO>(subspan.data(), subspan.size());
-
-            // Make the iterator and write to the target position.
-            OutputCellIterator it(charInfos);
-            storageBuffer.Write(it, target);
+            storageBuffer.GetTextBuffer().WriteCharInfos(charInfos, target);
         }
 
         // Since we've managed to write part of the request, return the clamped part that we actually used.
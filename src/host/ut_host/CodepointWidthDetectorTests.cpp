@@ -50,6 +50,113 @@ class CodepointWidthDetectorTests
         }
     }
 
+    TEST_METHOD(CanGetWidthsAtBlockBoundaries)
+    {
+        static constexpr std::array<std::pair<char32_t, CodepointWidth>, 10> data{ {
+            { 0xA0, CodepointWidth::Narrow },
+            { 0xA1, CodepointWidth::Wide }, // ambiguous
+            { 0x1100, CodepointWidth::Wide },
+            { 0x115F, CodepointWidth::Wide },
+            { 0x1160, CodepointWidth::Narrow },
+            { 0xFFFD, CodepointWidth::Wide }, // ambiguous
+            { 0x2FFFD, CodepointWidth::Wide },
+            { 0x2FFFE, CodepointWidth::Narrow },
+            { 0x10FFFD, CodepointWidth::Wide }, // ambiguous
+            { 0x10FFFF, CodepointWidth::Narrow },
+        } };
+
+        // Make ambiguous glyphs wide, so that we can tell them apart from narrow ones.
+        CodepointWidthDetector widthDetector;
+        widthDetector.SetFallbackMethod([](const std::wstring_view&) { return true; });
+
+        for (const auto& [codepoint, expected] : data)
+        {
+            std::wstring glyph;
+            if (codepoint < 0x10000)
+            {
+                glyph.push_back(gsl::narrow_cast<wchar_t>(codepoint));
+            }
+            else
+            {
+                glyph.push_back(gsl::narrow_cast<wchar_t>(0xD800 + ((codepoint - 0x10000) >> 10)));
+                glyph.push_back(gsl::narrow_cast<wchar_t>(0xDC00 + (codepoint & 0x3FF)));
+            }
+            VERIFY_ARE_EQUAL(expected, widthDetector.GetWidth(glyph), NoThrowString().Format(L"U+%04X", codepoint));
+        }
+    }
+
+    TEST_METHOD(CanFitIntoColumns)
+    {
+        // a, U+306A hiragana na, U+1F47E alien monster, an unpaired surrogate and b.
+        static constexpr std::wstring_view text{ L"a\x306A\xD83D\xDC7E\xD800b" };
+
+        CodepointWidthDetector widthDetector;
+        size_t columns = 0;
+
+        VERIFY_ARE_EQUAL(text.size(), widthDetector.FitIntoColumns(text, 100, columns));
+        VERIFY_ARE_EQUAL(7u, columns);
+
+        // The alien monster doesn't fit into the 4th column anymore.
+        VERIFY_ARE_EQUAL(2u, widthDetector.FitIntoColumns(text, 4, columns));
+        VERIFY_ARE_EQUAL(3u, columns);
+
+        VERIFY_ARE_EQUAL(0u, widthDetector.FitIntoColumns(text, 0, columns));
+        VERIFY_ARE_EQUAL(0u, columns);
+
+        // Unpaired surrogates are measured like U+FFFD, which is ambiguous.
+        widthDetector.SetFallbackMethod([](const std::wstring_view& glyph) { return glyph == L"\xFFFD"; });
+        VERIFY_ARE_EQUAL(text.size(), widthDetector.FitIntoColumns(text, 100, columns));
+        VERIFY_ARE_EQUAL(8u, columns);
+    }
+
+    TEST_METHOD(CanSegmentGraphemeClusters)
+    {
+        struct Test
+        {
+            const wchar_t* description;
+            std::wstring_view text;
+            std::vector<size_t> boundaries;
+            std::vector<size_t> widths;
+        };
+        const std::array tests{
+            Test{ L"GB3, GB4, GB5: CR LF", L"a\r\n\u0301", { 0, 1, 3, 4 }, { 1, 1, 1 } },
+            Test{ L"GB6, GB7, GB8: Hangul syllables", L"\u1100\u1161\u11A8\uAC00\u11A8", { 0, 3, 5 }, { 2, 2 } },
+            Test{ L"GB9: combining marks", L"e\u0301\u0302x", { 0, 3, 4 }, { 1, 1 } },
+            Test{ L"GB9a: spacing marks", L"\u0915\u093F", { 0, 2 }, { 1 } },
+            Test{ L"GB9b: prepended concatenation marks", L"\u0600\u0661", { 0, 2 }, { 1 } },
+            Test{ L"GB11: emoji ZWJ sequences", L"\U0001F469\U0001F3FD\u200D\U0001F4BB\u200D\U0001F469", { 0, 10 }, { 2 } },
+            Test{ L"GB11: ZWJ only joins pictographs", L"a\u200D\U0001F4BB", { 0, 2, 4 }, { 1, 2 } },
+            Test{ L"GB12, GB13: regional indicator pairs", L"\U0001F1E9\U0001F1EA\U0001F1E9", { 0, 4, 6 }, { 2, 2 } },
+            Test{ L"An emoji presentation selector makes emoji wide", L"\u2764\uFE0F\u2764", { 0, 2, 3 }, { 2, 1 } },
+        };
+
+        CodepointWidthDetector widthDetector;
+
+        for (const auto& t : tests)
+        {
+            Log::Comment(t.description);
+
+            std::vector<size_t> boundaries{ 0 };
+            std::vector<size_t> widths;
+            for (size_t offset = 0; offset < t.text.size();)
+            {
+                size_t width = 0;
+                offset = widthDetector.GraphemeNext(t.text, offset, width);
+                boundaries.emplace_back(offset);
+                widths.emplace_back(width);
+            }
+            VERIFY_IS_TRUE(t.boundaries == boundaries);
+            VERIFY_IS_TRUE(t.widths == widths);
+
+            // GraphemePrev must find the same boundaries, even if the offset isn't one.
+            for (size_t offset = 1; offset <= t.text.size(); ++offset)
+            {
+                const auto expected = *(std::lower_bound(boundaries.begin(), boundaries.end(), offset) - 1);
+                VERIFY_ARE_EQUAL(expected, widthDetector.GraphemePrev(t.text, offset));
+            }
+        }
+    }
+
     static bool FallbackMethod(const std::wstring_view glyph)
     {
         if (glyph.size() < 1)
@@ -11,6 +11,7 @@
 #include "screenInfo.hpp"
 #include "input.h"
 #include "getset.h"
+#include "ApiRoutines.h"
 #include "_stream.h" // For WriteCharsLegacy
 #include "output.h" // For ScrollRegion
 
@@ -264,6 +265,10 @@ class ScreenBufferTests
     TEST_METHOD(DelayedWrapReset);
 
     TEST_METHOD(EraseColorMode);
+
+    TEST_METHOD(WriteCharInfosDoubleWidth);
+    TEST_METHOD(ConsoleOutputRoundTrip);
+    TEST_METHOD(ConsoleOutputFrameBenchmark);
 };
 
 void ScreenBufferTests::SingleAlternateBufferCreationTest()
@@ -8404,3 +8409,131 @@ void ScreenBufferTests::EraseColorMode()
     VERIFY_ARE_EQUAL(expectedEraseAttr, cellData->TextAttr());
     VERIFY_ARE_EQUAL(L" ", cellData->Chars());
 }
+
+void ScreenBufferTests::WriteCharInfosDoubleWidth()
+{
+    auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+    const auto width = textBuffer.GetSize().Width();
+
+    static constexpr auto leading = WORD{ FOREGROUND_GREEN | COMMON_LVB_LEADING_BYTE };
+    static constexpr auto trailing = WORD{ FOREGROUND_GREEN | COMMON_LVB_TRAILING_BYTE };
+
+    Log::Comment(L"Simple cells and a double-width pair must keep their text, width and attributes");
+    {
+        const CHAR_INFO charInfos[]{
+            { { L'A' }, FOREGROUND_RED | BACKGROUND_BLUE },
+            { { L'\x3042' }, leading },
+            { { L'\x3042' }, trailing },
+            { { L'B' }, FOREGROUND_BLUE },
+        };
+        VERIFY_ARE_EQUAL(4u, textBuffer.WriteCharInfos(charInfos, { 0, 0 }, false));
+
+        const auto& row = textBuffer.GetRowByOffset(0);
+        VERIFY_ARE_EQUAL(L"A", row.GlyphAt(0));
+        VERIFY_ARE_EQUAL(L"\x3042", row.GlyphAt(1));
+        VERIFY_ARE_EQUAL(DbcsAttribute::Leading, row.DbcsAttrAt(1));
+        VERIFY_ARE_EQUAL(DbcsAttribute::Trailing, row.DbcsAttrAt(2));
+        VERIFY_ARE_EQUAL(L"B", row.GlyphAt(3));
+        VERIFY_ARE_EQUAL(WORD{ FOREGROUND_RED | BACKGROUND_BLUE }, row.GetAttrByColumn(0).GetLegacyAttributes());
+        VERIFY_ARE_EQUAL(WORD{ FOREGROUND_GREEN }, row.GetAttrByColumn(2).GetLegacyAttributes());
+        VERIFY_ARE_EQUAL(WORD{ FOREGROUND_BLUE }, row.GetAttrByColumn(3).GetLegacyAttributes());
+    }
+
+    Log::Comment(L"A leading half in the last column must be padded and continue on the next row");
+    {
+        const CHAR_INFO charInfos[]{
+            { { L'\x3042' }, leading },
+            { { L'\x3042' }, trailing },
+        };
+        textBuffer.WriteCharInfos(charInfos, { width - 1, 1 });
+
+        VERIFY_IS_TRUE(textBuffer.GetRowByOffset(1).WasDoubleBytePadded());
+        const auto& next = textBuffer.GetRowByOffset(2);
+        VERIFY_ARE_EQUAL(L"\x3042", next.GlyphAt(0));
+        VERIFY_ARE_EQUAL(DbcsAttribute::Leading, next.DbcsAttrAt(0));
+        VERIFY_ARE_EQUAL(DbcsAttribute::Trailing, next.DbcsAttrAt(1));
+    }
+}
+
+void ScreenBufferTests::ConsoleOutputRoundTrip()
+{
+    auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    auto& si = gci.GetActiveOutputBuffer();
+    ApiRoutines routines;
+
+    const auto rect = Viewport::FromDimensions({ 0, 0 }, { 40, 5 });
+    std::vector<CHAR_INFO> written(rect.Width() * rect.Height());
+    for (size_t i = 0; i < written.size(); ++i)
+    {
+        // Vary the attributes every few cells, so that the attribute runs don't line up with the rows.
+        written[i].Char.UnicodeChar = gsl::narrow_cast<wchar_t>(L'!' + i % 94);
+        written[i].Attributes = gsl::narrow_cast<WORD>((i / 7) % 256);
+    }
+
+    auto input = written;
+    Viewport writtenRect;
+    VERIFY_SUCCEEDED(routines.WriteConsoleOutputWImpl(si, input, rect, writtenRect));
+    VERIFY_ARE_EQUAL(rect, writtenRect);
+
+    std::vector<CHAR_INFO> read(written.size());
+    Viewport readRect;
+    VERIFY_SUCCEEDED(routines.ReadConsoleOutputWImpl(si, read, rect, readRect));
+    VERIFY_ARE_EQUAL(rect, readRect);
+
+    for (size_t i = 0; i < written.size(); ++i)
+    {
+        VERIFY_ARE_EQUAL(written[i].Char.UnicodeChar, read[i].Char.UnicodeChar);
+        VERIFY_ARE_EQUAL(written[i].Attributes, read[i].Attributes);
+    }
+}
+
+// This is less of a test and more of a benchmark for applications that draw
+// their entire UI with WriteConsoleOutput and read it back with ReadConsoleOutput.
+void ScreenBufferTests::ConsoleOutputFrameBenchmark()
+{
+    auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    auto& si = gci.GetActiveOutputBuffer();
+    ApiRoutines routines;
+
+    static constexpr auto iterations = 101;
+    const auto rect = Viewport::FromDimensions(si.GetViewport().Dimensions());
+    const auto cells = gsl::narrow_cast<size_t>(rect.Width() * rect.Height());
+
+    std::vector<CHAR_INFO> frame(cells);
+    std::vector<CHAR_INFO> input(cells);
+    std::vector<CHAR_INFO> output(cells);
+    std::vector<std::chrono::microseconds> writeTimes;
+    std::vector<std::chrono::microseconds> readTimes;
+
+    for (auto n = 0; n < iterations; ++n)
+    {
+        for (size_t i = 0; i < cells; ++i)
+        {
+            frame[i].Char.UnicodeChar = gsl::narrow_cast<wchar_t>(L' ' + (i + n) % 95);
+            frame[i].Attributes = gsl::narrow_cast<WORD>(((i + n) / 16) % 256);
+        }
+        input = frame;
+
+        Viewport writtenRect;
+        Viewport readRect;
+
+        const auto beg = std::chrono::steady_clock::now();
+        VERIFY_SUCCEEDED(routines.WriteConsoleOutputWImpl(si, input, rect, writtenRect));
+        const auto mid = std::chrono::steady_clock::now();
+        VERIFY_SUCCEEDED(routines.ReadConsoleOutputWImpl(si, output, rect, readRect));
+        const auto end = std::chrono::steady_clock::now();
+
+        writeTimes.push_back(std::chrono::duration_cast<std::chrono::microseconds>(mid - beg));
+        readTimes.push_back(std::chrono::duration_cast<std::chrono::microseconds>(end - mid));
+    }
+
+    VERIFY_ARE_EQUAL(frame.back().Char.UnicodeChar, output.back().Char.UnicodeChar);
+    VERIFY_ARE_EQUAL(frame.back().Attributes, output.back().Attributes);
+
+    const auto median = [](std::vector<std::chrono::microseconds>& times) {
+        std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+        return times[times.size() / 2].count();
+    };
+    Log::Comment(NoThrowString().Format(L"%dx%d frame: WriteConsoleOutputW %lldus, ReadConsoleOutputW %lldus (median of %d)", rect.Width(), rect.Height(), median(writeTimes), median(readTimes), iterations));
+}
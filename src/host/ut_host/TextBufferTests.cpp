@@ -3,6 +3,7 @@
 
 #include "precomp.h"
 
+#include <isa_availability.h>
 #include <til/hash.h>
 
 #include "WexTestClass.h"
@@ -26,6 +27,8 @@ using namespace WEX::Common;
 using namespace WEX::Logging;
 using namespace WEX::TestExecution;
 
+extern "C" int __isa_available;
+
 class TextBufferTests
 {
     DummyRenderer _renderer;
@@ -161,6 +164,21 @@ class TextBufferTests
 
     TEST_METHOD(HyperlinkTrim);
     TEST_METHOD(NoHyperlinkTrim);
+
+    TEST_METHOD(ColdScrollbackRoundTrip);
+    TEST_METHOD(SearchTextIndex);
+    TEST_METHOD(SearchTextParallel);
+    TEST_METHOD(SearchTextFrozenScrollback);
+    TEST_METHOD(RowContentHash);
+    TEST_METHOD(ResizeTraditionalSameWidth);
+    TEST_METHOD(PruneHyperlinks);
+    TEST_METHOD(CopyRect);
+    TEST_METHOD(ScrollMarkQueries);
+    TEST_METHOD(RowAttributeRuns);
+    TEST_METHOD(CountAsciiAllIsaLevels);
+    TEST_METHOD(GenRTFParallel);
+    TEST_METHOD(ColdRowBlockInternsAttributes);
+    TEST_METHOD(GraphemeClusters);
 };
 
 void TextBufferTests::TestBufferCreate()
@@ -2063,6 +2081,12 @@ void TextBufferTests::TestRowReplaceText()
             { L"", 4, 0, 5 },
             L" efg c" complex L"ab",
         },
+        Test{
+            L"Grapheme clusters are written into a single cell, or 2 if they're wide",
+            { L"e\u0301\U0001F469\u200D\U0001F4BBx", 0, til::CoordTypeMax },
+            { L"", 4, 0, 4 },
+            L"e\u0301\U0001F469\u200D\U0001F4BBx c" complex L"ab",
+        },
     };
 
     for (const auto& t : tests)
@@ -2852,3 +2876,650 @@ void TextBufferTests::NoHyperlinkTrim()
     VERIFY_ARE_EQUAL(_buffer->GetHyperlinkUriFromId(id), url);
     VERIFY_ARE_EQUAL(_buffer->_hyperlinkCustomIdMap[finalCustomId], id);
 }
+
+// This tests that rows which are moved into the cold scrollback tier
+// are restored with identical text, attributes and flags.
+void TextBufferTests::ColdScrollbackRoundTrip()
+{
+    // The buffer needs to be large enough for the cold scrollback tier to kick in.
+    const til::size bufferSize{ 40, 2000 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+    const auto height = bufferSize.height;
+
+    // Every third line contains a wide glyph and a surrogate pair, which forces the char-offsets to be stored.
+    const auto textForLine = [](int i) {
+        return i % 3 == 0 ? fmt::format(L"Line {} \u732B \xD83D\xDD25", i) : fmt::format(L"Line {}", i);
+    };
+    const auto attrForLine = [](int i) {
+        return TextAttribute{ gsl::narrow_cast<WORD>(i % 16) };
+    };
+
+    // Write a line at the bottom and scroll it up, until the buffer has been filled 3 times.
+    for (auto i = 0; i < 3 * height; ++i)
+    {
+        const auto text = textForLine(i);
+        RowWriteState state{ .text = text };
+        _buffer->Write(height - 1, attrForLine(i), state);
+        _buffer->SetWrapForced(height - 1, i % 2 == 0);
+        _buffer->IncrementCircularBuffer();
+    }
+
+    VERIFY_IS_GREATER_THAN(_buffer->_frozenChunkCount, size_t{ 0 });
+
+    for (auto y = 0; y < height - 1; ++y)
+    {
+        // After the last iteration above, the last line was scrolled up to height-2.
+        const auto i = 2 * height + 1 + y;
+        const auto& row = _buffer->GetRowByOffset(y);
+
+        VERIFY_ARE_EQUAL(textForLine(i), std::wstring{ row.GetText(0, row.GetLastNonSpaceColumn()) });
+        VERIFY_IS_TRUE(row.GetAttrByColumn(0) == attrForLine(i));
+        VERIFY_IS_TRUE(row.GetAttrByColumn(bufferSize.width - 1) == TextAttribute{});
+        VERIFY_ARE_EQUAL(i % 2 == 0, row.WasWrapForced());
+    }
+
+    // Reading all rows should have restored all of them.
+    VERIFY_ARE_EQUAL(size_t{ 0 }, _buffer->_frozenChunkCount);
+}
+
+void TextBufferTests::SearchTextIndex()
+{
+    const til::size bufferSize{ 20, 50 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+    const auto height = bufferSize.height;
+
+    const auto write = [&](til::CoordType y, std::wstring_view text) {
+        _buffer->GetMutableRowByOffset(y).Reset(attr);
+        RowWriteState state{ .text = text };
+        _buffer->Write(y, attr, state);
+    };
+    const auto verifyResults = [&](std::wstring_view needle, bool caseInsensitive, const std::vector<til::point_span>& expected) {
+        const auto actual = _buffer->SearchText(needle, caseInsensitive);
+        VERIFY_ARE_EQUAL(expected.size(), actual.size());
+        for (size_t i = 0; i < std::min(expected.size(), actual.size()); ++i)
+        {
+            VERIFY_ARE_EQUAL(expected[i].start, actual[i].start);
+            VERIFY_ARE_EQUAL(expected[i].end, actual[i].end);
+        }
+    };
+
+    write(3, L"hello world");
+    write(7, L"HELLO WORLD");
+    // This one spans 2 rows.
+    write(10, L"                hell");
+    write(11, L"o world");
+    write(height - 1, L"the end");
+
+    verifyResults(L"hello world", false, { { { 0, 3 }, { 10, 3 } } });
+    verifyResults(L"Hello World", true, { { { 0, 3 }, { 10, 3 } }, { { 0, 7 }, { 10, 7 } }, { { 16, 10 }, { 6, 11 } } });
+    verifyResults(L"the end", false, { { { 0, height - 1 }, { 6, height - 1 } } });
+    verifyResults(L"missing", false, {});
+
+    // Modifying a row must be picked up by the next search, including
+    // when it affects a match that starts in the preceding row.
+    write(7, L"goodbye");
+    write(11, L"o there");
+    verifyResults(L"hello world", true, { { { 0, 3 }, { 10, 3 } } });
+    verifyResults(L"hello there", false, { { { 16, 10 }, { 6, 11 } } });
+
+    // Recycling rows at the top of the buffer must be picked up as well.
+    // This scrolls the first "hello world" out and recycles its row at the bottom.
+    for (auto i = 0; i < 5; ++i)
+    {
+        _buffer->IncrementCircularBuffer();
+    }
+    write(height - 1, L"hello world");
+    verifyResults(L"hello world", false, { { { 0, height - 1 }, { 10, height - 1 } } });
+    verifyResults(L"hello there", false, { { { 16, 5 }, { 6, 6 } } });
+    verifyResults(L"the end", false, { { { 0, height - 6 }, { 6, height - 6 } } });
+
+    // Needles that are too short to have a trigram are searched for without the index.
+    verifyResults(L"Wo", true, { { { 6, height - 1 }, { 7, height - 1 } } });
+}
+
+void TextBufferTests::SearchTextParallel()
+{
+    // Tall enough to be split into 3 chunks of 4096 rows which are searched in parallel.
+    const til::size bufferSize{ 20, 10000 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+    const auto height = bufferSize.height;
+
+    const auto write = [&](til::CoordType y, std::wstring_view text) {
+        _buffer->GetMutableRowByOffset(y).Reset(attr);
+        RowWriteState state{ .text = text };
+        _buffer->Write(y, attr, state);
+    };
+
+    std::vector<til::point_span> expected;
+    for (til::CoordType y = 0; y < height; y += 100)
+    {
+        write(y, L"     ab");
+        expected.push_back({ { 5, y }, { 6, y } });
+
+        // This match spans the boundary between the first and second chunk.
+        // It must be found by the first one and only be reported once.
+        if (y == 4000)
+        {
+            write(4095, L"                   a");
+            write(4096, L"b");
+            expected.push_back({ { 19, 4095 }, { 0, 4096 } });
+        }
+    }
+    write(height - 1, L"AB");
+    expected.push_back({ { 0, height - 1 }, { 1, height - 1 } });
+
+    const auto actual = _buffer->SearchText(L"ab", true);
+    VERIFY_ARE_EQUAL(expected.size(), actual.size());
+    for (size_t i = 0; i < std::min(expected.size(), actual.size()); ++i)
+    {
+        VERIFY_ARE_EQUAL(expected[i].start, actual[i].start);
+        VERIFY_ARE_EQUAL(expected[i].end, actual[i].end);
+    }
+
+    // Needles with possibly overlapping matches are searched serially: "aa" in "aaa" is only found once.
+    write(5000, L"aaa");
+    const auto overlapping = _buffer->SearchText(L"aa", false);
+    VERIFY_ARE_EQUAL(size_t{ 1 }, overlapping.size());
+    VERIFY_ARE_EQUAL(til::point(0, 5000), overlapping[0].start);
+}
+
+// Searching must read frozen rows in place, instead of thawing the entire cold scrollback.
+void TextBufferTests::SearchTextFrozenScrollback()
+{
+    const til::size bufferSize{ 20, 10000 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+    const auto height = bufferSize.height;
+    const auto lines = height + 500;
+
+    std::vector<til::point_span> expected;
+    for (auto i = 0; i < lines; ++i)
+    {
+        if (i % 100 == 0)
+        {
+            static constexpr std::wstring_view text{ L"     abc" };
+            RowWriteState state{ .text = text };
+            _buffer->Write(height - 1, attr, state);
+
+            // The line ends up at this row once all lines have been written.
+            const auto y = height - 1 - (lines - i);
+            if (y >= 0)
+            {
+                expected.push_back({ { 5, y }, { 6, y } });
+            }
+        }
+        _buffer->IncrementCircularBuffer();
+    }
+
+    const auto frozen = _buffer->_frozenChunkCount;
+    VERIFY_IS_GREATER_THAN(frozen, size_t{ 0 });
+
+    const auto verifyResults = [&](std::wstring_view needle, til::CoordType endOffset) {
+        const auto actual = _buffer->SearchText(needle, false);
+        VERIFY_ARE_EQUAL(expected.size(), actual.size());
+        for (size_t i = 0; i < std::min(expected.size(), actual.size()); ++i)
+        {
+            VERIFY_ARE_EQUAL(expected[i].start, actual[i].start);
+            VERIFY_ARE_EQUAL(til::point(expected[i].end.x + endOffset, expected[i].end.y), actual[i].end);
+        }
+    };
+
+    Log::Comment(L"Without a trigram, the entire buffer is searched in parallel");
+    verifyResults(L"ab", 0);
+    VERIFY_ARE_EQUAL(frozen, _buffer->_frozenChunkCount);
+
+    Log::Comment(L"With a trigram, the search index is built and the candidates are searched");
+    verifyResults(L"abc", 1);
+    VERIFY_ARE_EQUAL(frozen, _buffer->_frozenChunkCount);
+}
+
+void TextBufferTests::RowContentHash()
+{
+    // The Renderer repaints rows from its cache as long as their ContentHash() didn't change.
+    const til::size bufferSize{ 20, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    const auto write = [&](til::CoordType y, std::wstring_view text, const TextAttribute& a) {
+        _buffer->GetMutableRowByOffset(y).Reset(attr);
+        RowWriteState state{ .text = text };
+        _buffer->Write(y, a, state);
+    };
+    const auto hash = [&](til::CoordType y) {
+        return _buffer->GetRowByOffset(y).ContentHash();
+    };
+
+    write(0, L"hello", attr);
+    write(1, L"hello", attr);
+    VERIFY_ARE_EQUAL(hash(0), hash(1));
+
+    // Text, attributes and glyph widths all need to be reflected in the hash.
+    write(1, L"hellO", attr);
+    VERIFY_ARE_NOT_EQUAL(hash(0), hash(1));
+
+    write(1, L"hello", TextAttribute{ 0x1f });
+    VERIFY_ARE_NOT_EQUAL(hash(0), hash(1));
+
+    write(0, L"\u732B", attr);
+    write(1, L"\u732B", attr);
+    VERIFY_ARE_EQUAL(hash(0), hash(1));
+    write(1, L"\u732B\u732B", attr);
+    VERIFY_ARE_NOT_EQUAL(hash(0), hash(1));
+
+    _buffer->GetMutableRowByOffset(0).SetWrapForced(true);
+    write(1, L"\u732B", attr);
+    VERIFY_ARE_NOT_EQUAL(hash(0), hash(1));
+}
+
+void TextBufferTests::ResizeTraditionalSameWidth()
+{
+    // If the kept rows start at a page boundary, ResizeTraditional() moves their pages into the resized buffer
+    // instead of copying them. Either way, the kept rows must be preserved and all others must be blank.
+    const til::size bufferSize{ 20, 300 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const TextAttribute newAttr{ 0x1f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    for (til::CoordType y = 0; y < bufferSize.height; ++y)
+    {
+        RowWriteState state{ .text = fmt::format(L"Line {}", y) };
+        _buffer->Write(y, attr, state);
+    }
+
+    const auto verify = [&](til::CoordType firstLine, til::CoordType keptRows) {
+        const auto height = _buffer->TotalRowCount();
+        for (til::CoordType y = 0; y < height; ++y)
+        {
+            const auto& row = _buffer->GetRowByOffset(y);
+            if (y < keptRows)
+            {
+                const auto expected = fmt::format(L"Line {}", firstLine + y);
+                VERIFY_ARE_EQUAL(std::wstring_view{ expected }, row.GetText().substr(0, gsl::narrow_cast<size_t>(row.MeasureRight())));
+                VERIFY_ARE_EQUAL(attr, row.GetAttrByColumn(0));
+            }
+            else
+            {
+                VERIFY_ARE_EQUAL(0, row.MeasureRight());
+                VERIFY_ARE_EQUAL(newAttr, row.GetAttrByColumn(0));
+            }
+        }
+    };
+
+    _buffer->SetCurrentAttributes(newAttr);
+
+    // Shrinking with the cursor at the top keeps the first rows, which start at a page boundary.
+    _buffer->ResizeTraditional({ 20, 200 });
+    verify(0, 200);
+
+    // Growing keeps all rows and the new ones are blank, including the ones in the last kept page.
+    _buffer->ResizeTraditional({ 20, 400 });
+    verify(0, 200);
+
+    // The cursor is below the new height, so the kept rows don't start at a page boundary.
+    _buffer->GetCursor().SetPosition({ 0, 150 });
+    _buffer->ResizeTraditional({ 20, 100 });
+    verify(51, 100);
+}
+
+void TextBufferTests::PruneHyperlinks()
+{
+    // A hyperlink is removed from the map once the last row that refers to it scrolls out of the buffer.
+    const til::size bufferSize{ 20, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    const auto addHyperlink = [&](std::wstring_view uri) {
+        const auto id = _buffer->GetHyperlinkId(uri, {});
+        _buffer->AddHyperlinkToMap(uri, id);
+        return id;
+    };
+    const auto write = [&](til::CoordType y, std::optional<uint16_t> id) {
+        auto a = attr;
+        if (id)
+        {
+            a.SetHyperlinkId(*id);
+        }
+        _buffer->GetMutableRowByOffset(y).Reset(attr);
+        RowWriteState state{ .text = L"link" };
+        _buffer->Write(y, a, state);
+    };
+
+    const auto id1 = addHyperlink(L"https://example.com/1");
+    const auto id2 = addHyperlink(L"https://example.com/2");
+    write(0, id1);
+    write(1, id2);
+    write(2, id1);
+
+    // id1 is still referenced by the row that's now at y=1.
+    _buffer->IncrementCircularBuffer();
+    VERIFY_ARE_EQUAL(L"https://example.com/1", _buffer->GetHyperlinkUriFromId(id1));
+
+    // The row with id2 was the only one referring to it.
+    _buffer->IncrementCircularBuffer();
+    VERIFY_ARE_EQUAL(L"https://example.com/1", _buffer->GetHyperlinkUriFromId(id1));
+    VERIFY_THROWS(_buffer->GetHyperlinkUriFromId(id2), std::out_of_range);
+
+    // Overwriting a row removes its references, just like recycling it does.
+    write(1, id1);
+    write(1, std::nullopt);
+    _buffer->IncrementCircularBuffer();
+    VERIFY_THROWS(_buffer->GetHyperlinkUriFromId(id1), std::out_of_range);
+}
+
+void TextBufferTests::CopyRect()
+{
+    const til::size bufferSize{ 10, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const TextAttribute otherAttr{ 0x1f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    const auto write = [&](til::CoordType y, std::wstring_view text, const TextAttribute& a) {
+        RowWriteState state{ .text = text };
+        _buffer->Write(y, a, state);
+    };
+    const auto text = [&](til::CoordType y) {
+        return _buffer->GetRowByOffset(y).GetText();
+    };
+
+    write(0, L"0123456789", otherAttr);
+    write(1, L"abcdefghij", attr);
+    write(2, L"AB\u732BCDEFGH", attr);
+    write(3, L"\u732B\u732Bxyzuvw", attr);
+
+    // Overlapping rows are copied bottom-up if the target is further down. Writing over
+    // the trailing half of the wide glyph in row 2 turns its leading half into whitespace.
+    _buffer->CopyRect({ 2, 0, 6, 2 }, { 3, 1 });
+    VERIFY_ARE_EQUAL(std::wstring_view{ L"0123456789" }, text(0));
+    VERIFY_ARE_EQUAL(std::wstring_view{ L"abc2345hij" }, text(1));
+    VERIFY_ARE_EQUAL(std::wstring_view{ L"AB cdefFGH" }, text(2));
+    VERIFY_ARE_EQUAL(attr, _buffer->GetRowByOffset(1).GetAttrByColumn(2));
+    VERIFY_ARE_EQUAL(otherAttr, _buffer->GetRowByOffset(1).GetAttrByColumn(3));
+    VERIFY_ARE_EQUAL(otherAttr, _buffer->GetRowByOffset(1).GetAttrByColumn(6));
+    VERIFY_ARE_EQUAL(attr, _buffer->GetRowByOffset(1).GetAttrByColumn(7));
+
+    // Moving a segment within a single row.
+    _buffer->CopyRect({ 0, 0, 5, 1 }, { 1, 0 });
+    VERIFY_ARE_EQUAL(std::wstring_view{ L"0012346789" }, text(0));
+
+    // A source starting with the trailing half of a wide glyph is copied as whitespace.
+    _buffer->CopyRect({ 1, 3, 4, 4 }, { 5, 3 });
+    VERIFY_ARE_EQUAL(std::wstring_view{ L"\u732B\u732Bx \u732Bvw" }, text(3));
+}
+
+void TextBufferTests::ScrollMarkQueries()
+{
+    const til::size bufferSize{ 20, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    const auto mark = [](til::CoordType y) {
+        ScrollMark m;
+        m.start = m.end = { 0, y };
+        return m;
+    };
+    const auto rows = [](const std::vector<ScrollMark>& marks) {
+        std::vector<til::CoordType> ys;
+        for (const auto& m : marks)
+        {
+            ys.emplace_back(m.start.y);
+        }
+        return ys;
+    };
+
+    // Marks are sorted by position, no matter if they're prompts or added by the user.
+    _buffer->StartPromptMark(mark(2));
+    _buffer->StartPromptMark(mark(8));
+    _buffer->AddMark(mark(5));
+    VERIFY_IS_TRUE((std::vector<til::CoordType>{ 2, 5, 8 }) == rows(_buffer->GetMarks()));
+    VERIFY_ARE_EQUAL(8, _buffer->GetCurrentMark()->start.y);
+
+    // Scrolling moves all of them and trims the ones that left the buffer.
+    _buffer->ScrollMarks(-3);
+    VERIFY_IS_TRUE((std::vector<til::CoordType>{ 2, 5 }) == rows(_buffer->GetMarks()));
+    VERIFY_ARE_EQUAL(5, _buffer->GetCurrentMark()->start.y);
+
+    // The active prompt is still the same mark, even though it's at a different index now.
+    _buffer->SetCurrentCommandEnd({ 4, 5 });
+    VERIFY_ARE_EQUAL((til::point{ 4, 5 }), *_buffer->GetCurrentMark()->commandEnd);
+    VERIFY_ARE_EQUAL((til::point{ 4, 5 }), *_buffer->GetMarks().back().commandEnd);
+
+    VERIFY_ARE_EQUAL(2, _buffer->GetPreviousMark(5)->start.y);
+    VERIFY_ARE_EQUAL(5, _buffer->GetNextMark(2)->start.y);
+    VERIFY_IS_FALSE(_buffer->GetNextMark(5).has_value());
+    VERIFY_IS_FALSE(_buffer->GetPreviousMark(2).has_value());
+    VERIFY_IS_TRUE((std::vector<til::CoordType>{ 5 }) == rows(_buffer->GetMarksInRange(3, 10)));
+
+    _buffer->ClearMarksInRange({ 0, 5 }, { 0, 5 });
+    VERIFY_IS_TRUE((std::vector<til::CoordType>{ 2 }) == rows(_buffer->GetMarks()));
+    VERIFY_IS_FALSE(_buffer->GetCurrentMark().has_value());
+
+    // A mark spanning multiple rows is cleared if it ends in the range.
+    auto tall = mark(6);
+    tall.end = { 3, 8 };
+    _buffer->AddMark(tall);
+    _buffer->ClearMarksInRange({ 0, 8 }, { 10, 8 });
+    VERIFY_IS_TRUE((std::vector<til::CoordType>{ 2 }) == rows(_buffer->GetMarks()));
+
+    for (auto i = 0; i < 3; ++i)
+    {
+        _buffer->ScrollMarks(-1);
+    }
+    VERIFY_IS_FALSE(_buffer->HasMarks());
+}
+
+void TextBufferTests::RowAttributeRuns()
+{
+    const til::size bufferSize{ 10, 1 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const TextAttribute otherAttr{ 0x1f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    auto& row = _buffer->GetMutableRowByOffset(0);
+    RowWriteState state{ .text = L"abcdefghij" };
+    row.ReplaceText(state);
+    row.ReplaceAttributes(3, 6, otherAttr);
+
+    // The runs are clipped to the given columns.
+    std::vector<std::tuple<til::CoordType, til::CoordType, TextAttribute>> runs;
+    row.ForEachAttributeRun(2, 8, [&](auto beg, auto end, const TextAttribute& a) {
+        runs.emplace_back(beg, end, a);
+    });
+    VERIFY_ARE_EQUAL(size_t{ 3 }, runs.size());
+    VERIFY_IS_TRUE((std::tuple{ 2, 3, attr }) == runs[0]);
+    VERIFY_IS_TRUE((std::tuple{ 3, 6, otherAttr }) == runs[1]);
+    VERIFY_IS_TRUE((std::tuple{ 6, 8, attr }) == runs[2]);
+
+    // The transformation is applied once per run and equal runs are joined afterwards.
+    auto calls = 0;
+    row.TransformAttributes(0, 10, [&](const TextAttribute&) {
+        ++calls;
+        return otherAttr;
+    });
+    VERIFY_ARE_EQUAL(3, calls);
+    VERIFY_ARE_EQUAL(size_t{ 1 }, row.Attributes().runs().size());
+    VERIFY_ARE_EQUAL(otherAttr, row.GetAttrByColumn(0));
+
+    // Clearing cells only affects the text.
+    row.ClearCells(2, 5);
+    VERIFY_ARE_EQUAL(std::wstring_view{ L"ab   fghij" }, row.GetText());
+    VERIFY_ARE_EQUAL(otherAttr, row.GetAttrByColumn(3));
+}
+
+void TextBufferTests::CountAsciiAllIsaLevels()
+{
+    // ROW::CountAscii() has SSE2, AVX2 and AVX-512 loops which are picked based on __isa_available
+    // and it falls back to a plain loop for the remainder. We lower __isa_available to test all of them.
+    const auto native = __isa_available;
+    const auto restoreIsa = wil::scope_exit([&]() { __isa_available = native; });
+
+    for (const auto level : { __ISA_AVAILABLE_SSE2, __ISA_AVAILABLE_AVX2, __ISA_AVAILABLE_AVX512 })
+    {
+        if (level > native)
+        {
+            continue;
+        }
+
+        __isa_available = level;
+
+        for (const auto nonAscii : { L'\x80', L'\xff', L'\x732B' })
+        {
+            for (size_t length = 0; length <= 80; ++length)
+            {
+                // position == length tests text without any non-ASCII characters.
+                for (size_t position = 0; position <= length; ++position)
+                {
+                    std::wstring text(length, L'\x7f');
+                    if (position < length)
+                    {
+                        text[position] = nonAscii;
+                    }
+
+                    if (ROW::CountAscii(text) != position)
+                    {
+                        VERIFY_FAIL(NoThrowString().Format(L"level=%d nonAscii=%x length=%zu position=%zu", level, nonAscii, length, position));
+                    }
+                }
+            }
+        }
+
+        // FitTextIntoColumns() and ROW::ReplaceText() use it for their ASCII fast-path.
+        til::CoordType columns = 0;
+        VERIFY_ARE_EQUAL(size_t{ 40 }, TextBuffer::FitTextIntoColumns(std::wstring(40, L'a'), 80, columns));
+        VERIFY_ARE_EQUAL(40, columns);
+        VERIFY_ARE_EQUAL(size_t{ 40 }, TextBuffer::FitTextIntoColumns(std::wstring(40, L'a') + L"\x732B", 41, columns));
+        VERIFY_ARE_EQUAL(41, columns);
+    }
+}
+
+void TextBufferTests::GenRTFParallel()
+{
+    // Tall enough to be formatted in parallel, in chunks of 1024 rows.
+    const til::size bufferSize{ 7, 3000 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    std::array<TextAttribute, 3> attrs{ attr, attr, attr };
+    attrs[0].SetForeground(RGB(255, 0, 0));
+    attrs[1].SetForeground(RGB(0, 255, 0));
+    attrs[2].SetForeground(RGB(0, 0, 255));
+
+    for (til::CoordType y = 0; y < bufferSize.height; ++y)
+    {
+        const auto& a = til::at(attrs, y % 3);
+        const auto text = fmt::format(L"{:07}", y);
+        _buffer->GetMutableRowByOffset(y).Reset(a);
+        RowWriteState state{ .text = text };
+        _buffer->Write(y, a, state);
+    }
+
+    // The colors must be resolved once per unique attribute and not once per run.
+    size_t calls = 0;
+    const auto getAttributeColors = [&](const TextAttribute& a) {
+        ++calls;
+        const auto fg = a.GetForeground().GetRGB();
+        return std::tuple<COLORREF, COLORREF, COLORREF>{ fg, RGB(0, 0, 0), fg };
+    };
+
+    const auto req = TextBuffer::CopyRequest{ *_buffer, { 0, 0 }, { 6, bufferSize.height - 1 }, false, true, true, false };
+    const auto rtf = _buffer->GenRTF(req, 12, L"Consolas", RGB(0, 0, 0), false, getAttributeColors);
+    VERIFY_ARE_EQUAL(size_t{ 3 }, calls);
+
+    // The background color is added to the color table first (index 1), followed by each foreground color.
+    std::string expected = "{\\rtf1\\ansi\\ansicpg1252\\deff0\\nouicompat{\\fonttbl{\\f0\\fmodern\\fcharset0 Consolas;}}";
+    expected += "{\\colortbl ;\\red0\\green0\\blue0;\\red255\\green0\\blue0;\\red0\\green255\\blue0;\\red0\\green0\\blue255;}";
+    expected += "\\viewkind4\\uc1\\pard\\slmult1\\f0\\fs24\\chshdng0\\chcbpat1";
+    for (til::CoordType y = 0; y < bufferSize.height; ++y)
+    {
+        fmt::format_to(std::back_inserter(expected), "{{\\cf{}\\chshdng0\\chcbpat1 {:07}}}", y % 3 + 2, y);
+        if (y != bufferSize.height - 1)
+        {
+            expected += "\\line";
+        }
+    }
+    expected += "}";
+
+    VERIFY_ARE_EQUAL(expected, rtf);
+}
+
+void TextBufferTests::ColdRowBlockInternsAttributes()
+{
+    const til::size bufferSize{ 16, 2 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, false, _renderer);
+
+    TextAttributeTable table;
+    TextAttribute red = attr;
+    red.SetForeground(RGB(255, 0, 0));
+    VERIFY_ARE_EQUAL(0u, table.Intern(attr));
+    VERIFY_ARE_EQUAL(1u, table.Intern(red));
+    VERIFY_ARE_EQUAL(0u, table.Intern(attr));
+    VERIFY_IS_TRUE(table.Get(1) == red);
+
+    // Shrinking releases the lookup table, but interning must still return the existing handles.
+    table.Shrink();
+    VERIFY_ARE_EQUAL(1u, table.Intern(red));
+    VERIFY_ARE_EQUAL(size_t{ 2 }, table.Size());
+
+    // Every column gets a different attribute, like the output of a 24-bit color gradient.
+    auto& row = _buffer->GetMutableRowByOffset(0);
+    RowWriteState state{ .text = L"0123456789abcdef" };
+    row.ReplaceText(state);
+    for (til::CoordType x = 0; x < bufferSize.width; ++x)
+    {
+        auto a = attr;
+        a.SetForeground(RGB(x * 16, 0, 255 - x * 16));
+        a.SetHyperlinkId(x % 2 ? 0 : gsl::narrow_cast<uint16_t>(x + 1));
+        row.ReplaceAttributes(x, x + 1, a);
+    }
+
+    ColdRowBlock block;
+    block.Append(row);
+    block.Append(row);
+    block.Shrink();
+    VERIFY_ARE_EQUAL(size_t{ 2 }, block.size());
+    VERIFY_IS_TRUE((std::vector<uint16_t>{ 1, 3, 5, 7, 9, 11, 13, 15 }) == block.GetHyperlinks(1));
+
+    auto& restored = _buffer->GetMutableRowByOffset(1);
+    block.Restore(1, restored);
+    VERIFY_ARE_EQUAL(row.GetText(), restored.GetText());
+    VERIFY_IS_TRUE(row.Attributes() == restored.Attributes());
+}
+
+void TextBufferTests::GraphemeClusters()
+{
+    // An "e" with a combining acute accent, a family ZWJ sequence, the German flag and a lone regional indicator.
+    static constexpr std::wstring_view text{ L"e\u0301\U0001F468\u200D\U0001F469\u200D\U0001F467\U0001F1E9\U0001F1EA\U0001F1E9" };
+    static constexpr std::array<size_t, 5> boundaries{ 0, 2, 10, 14, 16 };
+
+    for (size_t i = 1; i < boundaries.size(); ++i)
+    {
+        VERIFY_ARE_EQUAL(til::at(boundaries, i), TextBuffer::GraphemeNext(text, til::at(boundaries, i - 1)));
+        VERIFY_ARE_EQUAL(til::at(boundaries, i - 1), TextBuffer::GraphemePrev(text, til::at(boundaries, i)));
+    }
+
+    // The accented "e" is 1 column wide and all the others are 2.
+    til::CoordType columns = 0;
+    VERIFY_ARE_EQUAL(text.size(), TextBuffer::FitTextIntoColumns(text, 80, columns));
+    VERIFY_ARE_EQUAL(7, columns);
+    VERIFY_ARE_EQUAL(size_t{ 2 }, TextBuffer::FitTextIntoColumns(text, 2, columns));
+    VERIFY_ARE_EQUAL(2, columns);
+
+    // The ASCII fast-path must leave the last ASCII character to the slow-path if it's followed by a combining mark.
+    VERIFY_ARE_EQUAL(size_t{ 4 }, TextBuffer::FitTextIntoColumns(L"abc\u0301d", 3, columns));
+    VERIFY_ARE_EQUAL(3, columns);
+}
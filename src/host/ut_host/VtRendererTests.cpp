@@ -83,6 +83,9 @@ class Microsoft::Console::Render::VtRendererTest
 
     TEST_METHOD(TestWrapping);
 
+    TEST_METHOD(TestShadowFrameSkipsUnchangedCells);
+    TEST_METHOD(TestShadowFrameByteCount);
+
     TEST_METHOD(TestResize);
 
     TEST_METHOD(TestCursorVisibility);
@@ -1588,6 +1591,136 @@ void VtRendererTest::TestWrapping()
     });
 }
 
+void VtRendererTest::TestShadowFrameSkipsUnchangedCells()
+{
+    auto hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
+    auto engine = std::make_unique<Xterm256Engine>(std::move(hFile), SetUpViewport());
+    auto pfn = std::bind(&VtRendererTest::WriteCallback, this, std::placeholders::_1, std::placeholders::_2);
+    engine->SetTestCallback(pfn);
+
+    VerifyFirstPaint(*engine);
+
+    const auto paintLine = [&](const wchar_t* line) {
+        std::vector<Cluster> clusters;
+        for (size_t i = 0; i < wcslen(line); i++)
+        {
+            clusters.emplace_back(std::wstring_view{ &line[i], 1 }, 1);
+        }
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ clusters.data(), clusters.size() }, { 0, 0 }, false, false));
+    };
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(L"Painting a line for the first time writes all of it.");
+        qExpectedInput.push_back("\x1b[H");
+        VERIFY_SUCCEEDED(engine->_MoveCursor({ 0, 0 }));
+        qExpectedInput.push_back("asdfghjkl");
+        paintLine(L"asdfghjkl");
+    });
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(L"Painting the same line again writes nothing.");
+        qExpectedInput.push_back(EMPTY_CALLBACK_SENTINEL);
+        paintLine(L"asdfghjkl");
+        WriteCallback(EMPTY_CALLBACK_SENTINEL, 1);
+    });
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(L"Only the changed cell gets written.");
+        qExpectedInput.push_back("\x1b[1;5H");
+        qExpectedInput.push_back("G");
+        paintLine(L"asdfGhjkl");
+    });
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(L"Changes far apart are written separately and the cursor skips the gap.");
+        qExpectedInput.push_back("\x1b[1;2H");
+        qExpectedInput.push_back("X");
+        qExpectedInput.push_back("\x1b[6C");
+        qExpectedInput.push_back("Y");
+        paintLine(L"aXdfGhjkY");
+    });
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(L"Changes close together are written together, since that's shorter than a CUF.");
+        qExpectedInput.push_back("\x1b[H");
+        qExpectedInput.push_back("QXdQ");
+        paintLine(L"QXdQGhjkY");
+    });
+
+    VERIFY_SUCCEEDED(engine->InvalidateAll());
+    TestPaint(*engine, [&]() {
+        Log::Comment(L"Invalidating everything writes everything again.");
+        qExpectedInput.push_back("\x1b[H");
+        qExpectedInput.push_back("QXdQGhjkY");
+        paintLine(L"QXdQGhjkY");
+    });
+
+    VerifyExpectedInputsDrained();
+}
+
+void VtRendererTest::TestShadowFrameByteCount()
+{
+    const auto view = SetUpViewport();
+    const auto width = view.Width();
+    const auto height = view.Height();
+    auto hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
+    auto engine = std::make_unique<Xterm256Engine>(std::move(hFile), view);
+
+    size_t bytes = 0;
+    engine->SetTestCallback([&](const char* const, const size_t cch) {
+        bytes += cch;
+        return true;
+    });
+
+    // This imitates a TUI that redraws its entire screen on every update.
+    std::vector<std::wstring> rows;
+    for (til::CoordType y = 0; y < height; ++y)
+    {
+        rows.emplace_back(gsl::narrow_cast<size_t>(width), static_cast<wchar_t>(L'a' + y % 26));
+    }
+
+    const auto paintFrame = [&]() {
+        bytes = 0;
+        TestPaint(*engine, [&]() {
+            for (til::CoordType y = 0; y < height; ++y)
+            {
+                const auto& row = til::at(rows, y);
+                std::vector<Cluster> clusters;
+                for (size_t i = 0; i < row.size(); i++)
+                {
+                    clusters.emplace_back(std::wstring_view{ &row[i], 1 }, 1);
+                }
+                VERIFY_SUCCEEDED(engine->PaintBufferLine({ clusters.data(), clusters.size() }, { 0, y }, false, false));
+            }
+        });
+        Log::Comment(NoThrowString().Format(L"Frame took %zu bytes", bytes));
+        return bytes;
+    };
+
+    const auto cellCount = gsl::narrow_cast<size_t>(width * height);
+    const auto fullFrameBytes = paintFrame();
+    VERIFY_IS_GREATER_THAN_OR_EQUAL(fullFrameBytes, cellCount);
+
+    Log::Comment(L"An unchanged frame costs nothing.");
+    VERIFY_ARE_EQUAL(0u, paintFrame());
+
+    Log::Comment(L"A frame with a single changed cell costs a cursor movement and the cell.");
+    rows[10][40] = L'#';
+    VERIFY_IS_LESS_THAN_OR_EQUAL(paintFrame(), 16u);
+
+    Log::Comment(L"Changing a few cells in every row costs a fraction of a full frame.");
+    for (auto& row : rows)
+    {
+        row[5] = L'1';
+        row[50] = L'2';
+    }
+    VERIFY_IS_LESS_THAN(paintFrame() * 5, fullFrameBytes);
+
+    Log::Comment(L"After invalidating everything, the full frame is written again.");
+    VERIFY_SUCCEEDED(engine->InvalidateAll());
+    VERIFY_IS_GREATER_THAN_OR_EQUAL(paintFrame(), cellCount);
+}
+
 void VtRendererTest::TestResize()
 {
     auto view = SetUpViewport();
@@ -14,6 +14,11 @@ could overcome disadvantages of syscalls. Test results can be read up
 in PR #4093 and the test algorithms are available in src\tools\U8U16Test.
 Based on the results the decision was made to keep using the platform
 functions MultiByteToWideChar and WideCharToMultiByte.
+Since then, ASCII is converted with SSE2/AVX2 16-32 characters at a time
+and valid non-ASCII sequences are converted inline, which is a lot faster
+than the platform functions for the short strings a terminal deals with.
+Invalid sequences are still passed to the platform functions, so that
+they're replaced with U+FFFD just like before.
 
 Author(s):
 - Steffen Illhardt (german-one), Leonard Hecker (lhecker) 2020-2021
@@ -21,6 +26,12 @@ Author(s):
 
 #pragma once
 
+#if defined(TIL_SSE_INTRINSICS)
+#include <immintrin.h>
+#include <isa_availability.h>
+extern "C" int __isa_available;
+#endif
+
 namespace til // Terminal Implementation Library. Also: "Today I Learned"
 {
     // state structure for maintenance of UTF-8 partials
@@ -47,6 +58,241 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
         }
     };
 
+    namespace details
+    {
+#pragma warning(push)
+#pragma warning(disable : 26429 26481 26490) // use not_null, pointer arithmetic, reinterpret_cast
+
+        // Widens the leading ASCII characters of `in` into `out` and returns their count.
+        inline size_t u8u16_ascii(const uint8_t* in, size_t len, wchar_t* out) noexcept
+        {
+            size_t i = 0;
+
+#if defined(TIL_SSE_INTRINSICS)
+            // __isa_available is initialized once by the CRT during startup.
+            // The AVX2 loop handles the bulk of the text and the SSE2 and plain loops handle the rest.
+            if (__isa_available >= __ISA_AVAILABLE_AVX2)
+            {
+                for (; i + 32 <= len; i += 32)
+                {
+                    const auto bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+                    if (_mm256_movemask_epi8(bytes))
+                    {
+                        break;
+                    }
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes)));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1)));
+                }
+            }
+
+            for (; i + 16 <= len; i += 16)
+            {
+                const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                if (_mm_movemask_epi8(bytes))
+                {
+                    break;
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi8(bytes, _mm_setzero_si128()));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(bytes, _mm_setzero_si128()));
+            }
+#endif
+
+#pragma loop(no_vector)
+            for (; i < len && in[i] < 0x80; ++i)
+            {
+                out[i] = static_cast<wchar_t>(in[i]);
+            }
+
+            return i;
+        }
+
+        // Narrows the leading ASCII characters of `in` into `out` and returns their count.
+        inline size_t u16u8_ascii(const wchar_t* in, size_t len, char* out) noexcept
+        {
+            size_t i = 0;
+
+#if defined(TIL_SSE_INTRINSICS)
+            if (__isa_available >= __ISA_AVAILABLE_AVX2)
+            {
+                const auto nonAscii = _mm256_set1_epi16(static_cast<short>(0xff80));
+
+                for (; i + 32 <= len; i += 32)
+                {
+                    const auto lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+                    const auto hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 16));
+                    if (!_mm256_testz_si256(_mm256_or_si256(lo, hi), nonAscii))
+                    {
+                        break;
+                    }
+                    // _mm256_packus_epi16 packs each 128-bit lane on its own, which results in lo[0:8], hi[0:8], lo[8:16], hi[8:16].
+                    const auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0b11'01'10'00);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+                }
+            }
+
+            {
+                const auto nonAscii = _mm_set1_epi16(static_cast<short>(0xff80));
+
+                for (; i + 16 <= len; i += 16)
+                {
+                    const auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                    const auto hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+                    const auto ascii = _mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(lo, hi), nonAscii), _mm_setzero_si128());
+                    if (_mm_movemask_epi8(ascii) != 0xffff)
+                    {
+                        break;
+                    }
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(lo, hi));
+                }
+            }
+#endif
+
+#pragma loop(no_vector)
+            for (; i < len && in[i] < 0x80; ++i)
+            {
+                out[i] = static_cast<char>(in[i]);
+            }
+
+            return i;
+        }
+
+        // Converts UTF-8 into UTF-16. `out` must have room for `len` characters.
+        // Returns the number of characters written to `out`, or 0 if MultiByteToWideChar failed.
+        inline size_t u8u16(const char* in, size_t len, wchar_t* out) noexcept
+        {
+            const auto end = reinterpret_cast<const uint8_t*>(in) + len;
+            auto it = reinterpret_cast<const uint8_t*>(in);
+            auto dst = out;
+
+            while (it != end)
+            {
+                const auto ascii = u8u16_ascii(it, gsl::narrow_cast<size_t>(end - it), dst);
+                it += ascii;
+                dst += ascii;
+
+                while (it != end && *it >= 0x80)
+                {
+                    // The validation follows "Table 3-7. Well-Formed UTF-8 Byte Sequences" of the Unicode standard.
+                    const auto remaining = end - it;
+                    const auto b0 = it[0];
+                    const auto isTrail = [&](ptrdiff_t i) noexcept {
+                        return (it[i] & 0b11'000000) == 0b10'000000;
+                    };
+
+                    if (b0 >= 0xC2 && b0 <= 0xDF && remaining >= 2 && isTrail(1))
+                    {
+                        *dst++ = static_cast<wchar_t>((b0 & 0x1fu) << 6 | (it[1] & 0x3fu));
+                        it += 2;
+                        continue;
+                    }
+                    if (b0 >= 0xE0 && b0 <= 0xEF && remaining >= 3 && isTrail(1) && isTrail(2))
+                    {
+                        const auto cp = (b0 & 0x0fu) << 12 | (it[1] & 0x3fu) << 6 | (it[2] & 0x3fu);
+                        // Overlong encodings and surrogates are invalid.
+                        if (cp >= 0x800 && (cp < 0xD800 || cp > 0xDFFF))
+                        {
+                            *dst++ = static_cast<wchar_t>(cp);
+                            it += 3;
+                            continue;
+                        }
+                    }
+                    if (b0 >= 0xF0 && b0 <= 0xF4 && remaining >= 4 && isTrail(1) && isTrail(2) && isTrail(3))
+                    {
+                        const auto cp = (b0 & 0x07u) << 18 | (it[1] & 0x3fu) << 12 | (it[2] & 0x3fu) << 6 | (it[3] & 0x3fu);
+                        // Overlong encodings and code points past U+10FFFF are invalid.
+                        if (cp >= 0x10000 && cp <= 0x10FFFF)
+                        {
+                            dst[0] = static_cast<wchar_t>(0xD7C0 + (cp >> 10));
+                            dst[1] = static_cast<wchar_t>(0xDC00 | (cp & 0x3ff));
+                            dst += 2;
+                            it += 4;
+                            continue;
+                        }
+                    }
+
+                    // Invalid and incomplete sequences are left to MultiByteToWideChar, which replaces them with U+FFFD.
+                    // ASCII is never part of a multi-byte sequence, which makes the next ASCII character a safe place to stop.
+                    auto next = it + 1;
+                    while (next != end && *next >= 0x80)
+                    {
+                        ++next;
+                    }
+
+                    const auto count = gsl::narrow_cast<int>(next - it);
+                    const auto written = MultiByteToWideChar(CP_UTF8, 0UL, reinterpret_cast<const char*>(it), count, dst, count);
+                    if (!written)
+                    {
+                        return 0;
+                    }
+
+                    dst += written;
+                    it = next;
+                }
+            }
+
+            return gsl::narrow_cast<size_t>(dst - out);
+        }
+
+        // Converts UTF-16 into UTF-8. `out` must have room for `len * 3` characters.
+        // Returns the number of characters written to `out`, or 0 if WideCharToMultiByte failed.
+        inline size_t u16u8(const wchar_t* in, size_t len, char* out) noexcept
+        {
+            const auto end = in + len;
+            auto it = in;
+            auto dst = reinterpret_cast<uint8_t*>(out);
+
+            while (it != end)
+            {
+                const auto ascii = u16u8_ascii(it, gsl::narrow_cast<size_t>(end - it), reinterpret_cast<char*>(dst));
+                it += ascii;
+                dst += ascii;
+
+                for (; it != end && *it >= 0x80; ++it)
+                {
+                    const auto c = static_cast<uint32_t>(*it);
+
+                    if (c < 0x800)
+                    {
+                        dst[0] = static_cast<uint8_t>(0xC0 | c >> 6);
+                        dst[1] = static_cast<uint8_t>(0x80 | (c & 0x3f));
+                        dst += 2;
+                    }
+                    else if (c < 0xD800 || c > 0xDFFF)
+                    {
+                        dst[0] = static_cast<uint8_t>(0xE0 | c >> 12);
+                        dst[1] = static_cast<uint8_t>(0x80 | (c >> 6 & 0x3f));
+                        dst[2] = static_cast<uint8_t>(0x80 | (c & 0x3f));
+                        dst += 3;
+                    }
+                    else if (c <= 0xDBFF && end - it >= 2 && it[1] >= 0xDC00 && it[1] <= 0xDFFF)
+                    {
+                        const auto cp = 0x10000 + ((c - 0xD800) << 10) + (static_cast<uint32_t>(it[1]) - 0xDC00);
+                        dst[0] = static_cast<uint8_t>(0xF0 | cp >> 18);
+                        dst[1] = static_cast<uint8_t>(0x80 | (cp >> 12 & 0x3f));
+                        dst[2] = static_cast<uint8_t>(0x80 | (cp >> 6 & 0x3f));
+                        dst[3] = static_cast<uint8_t>(0x80 | (cp & 0x3f));
+                        dst += 4;
+                        ++it;
+                    }
+                    else
+                    {
+                        // Unpaired surrogates are left to WideCharToMultiByte, which replaces them with U+FFFD.
+                        const auto written = WideCharToMultiByte(CP_UTF8, 0UL, it, 1, reinterpret_cast<char*>(dst), 3, nullptr, nullptr);
+                        if (!written)
+                        {
+                            return 0;
+                        }
+                        dst += written;
+                    }
+                }
+            }
+
+            return gsl::narrow_cast<size_t>(dst - reinterpret_cast<uint8_t*>(out));
+        }
+
+#pragma warning(pop)
+    }
+
     // Routine Description:
     // - Takes a UTF-8 string and performs the conversion to UTF-16. NOTE: The function relies on getting complete UTF-8 characters at the string boundaries.
     // Arguments:
@@ -69,9 +315,9 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             int lengthRequired{};
             // The worst ratio of UTF-8 code units to UTF-16 code units is 1 to 1 if UTF-8 consists of ASCII only.
             RETURN_HR_IF(E_ABORT, !base::MakeCheckedNum(in.length()).AssignIfValid(&lengthRequired));
-            out.resize(in.length()); // avoid to call MultiByteToWideChar twice only to get the required size
-            const int lengthOut = MultiByteToWideChar(CP_UTF8, 0ul, in.data(), lengthRequired, out.data(), lengthRequired);
-            out.resize(gsl::narrow_cast<size_t>(lengthOut));
+            out.resize(in.length()); // avoid to convert twice only to get the required size
+            const auto lengthOut = details::u8u16(in.data(), in.length(), out.data());
+            out.resize(lengthOut);
 
             return lengthOut == 0 ? E_UNEXPECTED : S_OK;
         }
@@ -120,10 +366,9 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
                     return S_OK;
                 }
 
-                len16 = MultiByteToWideChar(CP_UTF8, 0UL, &state.partials[0], gsl::narrow_cast<int>(state.have), out.data(), capa16);
+                len16 = gsl::narrow_cast<int>(details::u8u16(&state.partials[0], state.have, out.data()));
                 RETURN_HR_IF(E_UNEXPECTED, !len16);
 
-                capa16 -= len16;
                 len8 -= copyable;
                 cursor8 += copyable;
                 // state.want is already zero at this point
@@ -158,7 +403,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
 
             if (len8)
             {
-                const auto convLen{ MultiByteToWideChar(CP_UTF8, 0UL, cursor8, len8, out.data() + len16, capa16) };
+                const auto convLen{ gsl::narrow_cast<int>(details::u8u16(cursor8, gsl::narrow_cast<size_t>(len8), out.data() + len16)) };
                 RETURN_HR_IF(E_UNEXPECTED, !convLen);
 
                 len16 += convLen;
@@ -196,9 +441,9 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             // Code Points >U+FFFF: 2 UTF-16 code units --> 4 UTF-8 code units.
             // Thus, the worst ratio of UTF-16 code units to UTF-8 code units is 1 to 3.
             RETURN_HR_IF(E_ABORT, !base::MakeCheckedNum(in.length()).AssignIfValid(&lengthIn) || !base::CheckMul(lengthIn, 3).AssignIfValid(&lengthRequired));
-            out.resize(gsl::narrow_cast<size_t>(lengthRequired)); // avoid to call WideCharToMultiByte twice only to get the required size
-            const int lengthOut = WideCharToMultiByte(CP_UTF8, 0ul, in.data(), lengthIn, out.data(), lengthRequired, nullptr, nullptr);
-            out.resize(gsl::narrow_cast<size_t>(lengthOut));
+            out.resize(gsl::narrow_cast<size_t>(lengthRequired)); // avoid to convert twice only to get the required size
+            const auto lengthOut = details::u16u8(in.data(), in.length(), out.data());
+            out.resize(lengthOut);
 
             return lengthOut == 0 ? E_UNEXPECTED : S_OK;
         }
@@ -238,11 +483,10 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             if (state.partials[0])
             {
                 state.partials[1] = *cursor16;
-                len8 = WideCharToMultiByte(CP_UTF8, 0UL, &state.partials[0], 2, out.data(), capa8, nullptr, nullptr);
+                len8 = gsl::narrow_cast<int>(details::u16u8(&state.partials[0], 2, out.data()));
                 RETURN_HR_IF(E_UNEXPECTED, !len8);
 
                 state.reset();
-                capa8 -= len8;
                 --len16;
                 ++cursor16;
             }
@@ -259,7 +503,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
 
             if (len16)
             {
-                const auto convLen{ WideCharToMultiByte(CP_UTF8, 0UL, cursor16, len16, out.data() + len8, capa8, nullptr, nullptr) };
+                const auto convLen{ gsl::narrow_cast<int>(details::u16u8(cursor16, gsl::narrow_cast<size_t>(len16), out.data() + len8)) };
                 RETURN_HR_IF(E_UNEXPECTED, !convLen);
 
                 len8 += convLen;
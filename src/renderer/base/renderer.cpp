@@ -240,6 +240,10 @@ void Renderer::TriggerRedraw(const Viewport& region)
             LOG_IF_FAILED(pEngine->Invalidate(&srUpdateRegion));
         }
 
+        // Changes to the text would be caught by the ROW's ContentHash(), but changes to the patterns
+        // (URLs) aren't part of the buffer. They're only announced through this function.
+        _InvalidateRowCache(srUpdateRegion.top, srUpdateRegion.bottom);
+
         NotifyPaintFrame();
     }
 }
@@ -311,6 +315,8 @@ void Renderer::TriggerRedrawAll(const bool backgroundChanged, const bool frameCh
         LOG_IF_FAILED(pEngine->InvalidateAll());
     }
 
+    _InvalidateRowCache(0, til::CoordTypeMax);
+
     NotifyPaintFrame();
 
     if (backgroundChanged && _pfnBackgroundColorChanged)
@@ -419,6 +425,7 @@ bool Renderer::_CheckViewportAndScroll()
     }
 
     _ScrollPreviousSelection(coordDelta);
+    _ScrollRowCache(coordDelta);
     return true;
 }
 
@@ -454,6 +461,7 @@ void Renderer::TriggerScroll(const til::point* const pcoordDelta)
     }
 
     _ScrollPreviousSelection(*pcoordDelta);
+    _ScrollRowCache(*pcoordDelta);
 
     NotifyPaintFrame();
 }
@@ -720,6 +728,8 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
 
         // Retrieve the text buffer so we can read information out of it.
         const auto& buffer = _pData->GetTextBuffer();
+        const auto globalInvert = _renderSettings.GetRenderMode(RenderSettings::Mode::ScreenReversed);
+        const auto gridLines = _pData->IsGridLineDrawingAllowed();
 
         // Now walk through each row of text that we need to redraw.
         for (auto row = redraw.Top(); row < redraw.BottomExclusive(); row++)
@@ -740,21 +750,53 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
             // of the backing buffer to fill in line 1 of the screen.
             const auto screenPosition = bufferLine.Origin() - til::point{ 0, view.Top() };
 
-            // Retrieve the cell information iterator limited to just this line we want to redraw.
-            auto it = buffer.GetCellDataAt(bufferLine.Origin(), bufferLine);
+            const auto& bufferRow = buffer.GetRowByOffset(bufferLine.Origin().y);
 
             // Calculate if two things are true:
             // 1. this row wrapped
             // 2. We're painting the last col of the row.
             // In that case, set lineWrapped=true for the _PaintBufferOutputHelper call.
-            const auto lineWrapped = (buffer.GetRowByOffset(bufferLine.Origin().y).WasWrapForced()) &&
+            const auto lineWrapped = bufferRow.WasWrapForced() &&
                                      (bufferLine.RightExclusive() == buffer.GetSize().Width());
 
             // Prepare the appropriate line transform for the current row and viewport offset.
             LOG_IF_FAILED(pEngine->PrepareLineTransform(lineRendition, screenPosition.y, view.Left()));
 
+            if (static_cast<size_t>(screenPosition.y) >= _rowCache.size())
+            {
+                _rowCache.resize(static_cast<size_t>(screenPosition.y) + 1);
+            }
+
+            // Rows that only got invalidated because the cursor blinked, the selection
+            // changed or the viewport scrolled can be painted just like they were last time.
+            auto& cache = til::at(_rowCache, screenPosition.y);
+            const auto hash = bufferRow.ContentHash();
+            if (cache.valid &&
+                cache.hash == hash &&
+                cache.left == bufferLine.Left() &&
+                cache.right == bufferLine.RightExclusive() &&
+                cache.lineWrapped == lineWrapped &&
+                cache.globalInvert == globalInvert &&
+                cache.gridLines == gridLines &&
+                cache.lastSoftFontChar == _lastSoftFontChar)
+            {
+                _PaintCachedBufferOutput(pEngine, cache, bufferRow.GetText(), screenPosition, lineWrapped);
+                continue;
+            }
+
+            cache.hash = hash;
+            cache.left = bufferLine.Left();
+            cache.right = bufferLine.RightExclusive();
+            cache.lineWrapped = lineWrapped;
+            cache.globalInvert = globalInvert;
+            cache.gridLines = gridLines;
+            cache.lastSoftFontChar = _lastSoftFontChar;
+
+            // Retrieve the cell information iterator limited to just this line we want to redraw.
+            auto it = buffer.GetCellDataAt(bufferLine.Origin(), bufferLine);
+
             // Ask the helper to paint through this specific line.
-            _PaintBufferOutputHelper(pEngine, it, screenPosition, lineWrapped);
+            _PaintBufferOutputHelper(pEngine, it, screenPosition, lineWrapped, &cache, bufferRow.GetText());
         }
     }
 }
@@ -765,13 +807,26 @@ static bool _IsAllSpaces(const std::wstring_view v)
     return v.find_first_not_of(L' ') == decltype(v)::npos;
 }
 
+// If `cache` is given, the runs are recorded into it, so that _PaintCachedBufferOutput() can repeat this
+// call for the next frame. `rowText` must then be the ROW::GetText() of the row that `it` iterates over.
 void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
                                         TextBufferCellIterator it,
                                         const til::point target,
-                                        const bool lineWrapped)
+                                        const bool lineWrapped,
+                                        CachedRow* cache,
+                                        std::wstring_view rowText)
 {
     auto globalInvert{ _renderSettings.GetRenderMode(RenderSettings::Mode::ScreenReversed) };
 
+    if (cache)
+    {
+        cache->valid = false;
+        cache->hasPatterns = false;
+        cache->runs.clear();
+        cache->clusters.clear();
+        cache->gridLineAttrs.clear();
+    }
+
     // If we have valid data, let's figure out how to draw it.
     if (it)
     {
@@ -803,8 +858,11 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
             // Hold onto the current pattern id as well
             const auto currentPatternId = patternIds;
 
+            // ...and whether this run uses the soft font, which is also updated by the inner loop.
+            const auto currentUsingSoftFont = usingSoftFont;
+
             // Update the drawing brushes with our color and font usage.
-            THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, currentRunColor, usingSoftFont, false));
+            THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, currentRunColor, currentUsingSoftFont, false));
 
             // Advance the point by however many columns we've just outputted and reset the accumulator.
             screenPoint.x += cols;
@@ -880,6 +938,36 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
             // Do the painting.
             THROW_IF_FAILED(pEngine->PaintBufferLine({ _clusterBuffer.data(), _clusterBuffer.size() }, screenPoint, trimLeft, lineWrapped));
 
+            if (cache)
+            {
+                for (const auto& cluster : _clusterBuffer)
+                {
+                    const auto text = cluster.GetText();
+                    const auto offset = text.data() - rowText.data();
+                    // The iterator should only ever return glyphs from the ROW's text. If it doesn't, we can't cache this row.
+                    if (offset < 0 || static_cast<size_t>(offset) + text.size() > rowText.size())
+                    {
+                        cache = nullptr;
+                        break;
+                    }
+                    cache->clusters.push_back({ gsl::narrow_cast<uint16_t>(offset), gsl::narrow_cast<uint16_t>(text.size()), cluster.GetColumns() });
+                }
+            }
+            if (cache)
+            {
+                cache->hasPatterns |= !currentPatternId.empty();
+                cache->runs.push_back({
+                    .attr = currentRunColor,
+                    .x = screenPoint.x,
+                    .gridLineX = currentRunTargetStart.x,
+                    .cols = cols,
+                    .clustersEnd = cache->clusters.size(),
+                    .usingSoftFont = currentUsingSoftFont,
+                    .trimLeft = trimLeft,
+                    .containsWideCharacter = containsWideCharacter,
+                });
+            }
+
             // If we're allowed to do grid drawing, draw that now too (since it will be coupled with the color data)
             // We're only allowed to draw the grid lines under certain circumstances.
             if (_pData->IsGridLineDrawingAllowed())
@@ -905,6 +993,11 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
                     {
                         auto lines = lineIt->TextAttr();
                         _PaintBufferOutputGridLineHelper(pEngine, lines, 1, lineTarget);
+
+                        if (cache)
+                        {
+                            cache->gridLineAttrs.push_back(lines);
+                        }
                     }
                 }
                 else
@@ -913,6 +1006,117 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
                     _PaintBufferOutputGridLineHelper(pEngine, currentRunColor, cols, screenPoint);
                 }
             }
+
+            if (cache)
+            {
+                cache->runs.back().gridLineAttrsEnd = cache->gridLineAttrs.size();
+            }
+        }
+    }
+
+    if (cache)
+    {
+        cache->valid = true;
+    }
+}
+
+// Routine Description:
+// - Repeats the calls a previous _PaintBufferOutputHelper() made, as recorded in `cache`.
+// Arguments:
+// - cache - The runs recorded by _PaintBufferOutputHelper() for this row.
+// - rowText - The ROW::GetText() of the row. Its ContentHash() must still match the recorded one.
+// - target - The position of the row on the screen. It may have moved since it was recorded.
+// - lineWrapped - Whether the row wrapped and we're painting its last column.
+// Return Value:
+// - <none>
+void Renderer::_PaintCachedBufferOutput(_In_ IRenderEngine* const pEngine,
+                                        const CachedRow& cache,
+                                        const std::wstring_view& rowText,
+                                        const til::point target,
+                                        const bool lineWrapped)
+{
+    size_t clustersBeg = 0;
+    size_t gridLineAttrsBeg = 0;
+
+    for (const auto& run : cache.runs)
+    {
+        THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, run.attr, run.usingSoftFont, false));
+
+        _clusterBuffer.clear();
+        for (auto i = clustersBeg; i < run.clustersEnd; ++i)
+        {
+            const auto& cluster = til::at(cache.clusters, i);
+            _clusterBuffer.emplace_back(rowText.substr(cluster.offset, cluster.length), cluster.columns);
+        }
+        clustersBeg = run.clustersEnd;
+
+        const til::point screenPoint{ run.x, target.y };
+        THROW_IF_FAILED(pEngine->PaintBufferLine({ _clusterBuffer.data(), _clusterBuffer.size() }, screenPoint, run.trimLeft, lineWrapped));
+
+        if (cache.gridLines)
+        {
+            if (run.containsWideCharacter)
+            {
+                til::point lineTarget{ run.gridLineX, target.y };
+                for (auto i = gridLineAttrsBeg; i < run.gridLineAttrsEnd; ++i, ++lineTarget.x)
+                {
+                    _PaintBufferOutputGridLineHelper(pEngine, til::at(cache.gridLineAttrs, i), 1, lineTarget);
+                }
+            }
+            else
+            {
+                _PaintBufferOutputGridLineHelper(pEngine, run.attr, run.cols, screenPoint);
+            }
+        }
+        gridLineAttrsBeg = run.gridLineAttrsEnd;
+    }
+}
+
+// Routine Description:
+// - Discards the cached runs of the viewport rows [top,bottom).
+void Renderer::_InvalidateRowCache(til::CoordType top, til::CoordType bottom) noexcept
+{
+    const auto size = gsl::narrow_cast<til::CoordType>(_rowCache.size());
+    top = std::clamp(top, 0, size);
+    bottom = std::clamp(bottom, top, size);
+
+    for (auto y = top; y < bottom; ++y)
+    {
+        til::at(_rowCache, y).valid = false;
+    }
+}
+
+// Routine Description:
+// - Moves the cached runs along with the rows they belong to, when the viewport scrolls by `delta`.
+void Renderer::_ScrollRowCache(const til::point delta)
+{
+    const auto size = gsl::narrow_cast<til::CoordType>(_rowCache.size());
+
+    // Horizontal scrolling changes which columns of each row are visible.
+    if (delta.x != 0 || delta.y <= -size || delta.y >= size)
+    {
+        _InvalidateRowCache(0, size);
+        return;
+    }
+
+    if (delta.y < 0)
+    {
+        // The contents move up: The row at y now shows what was at y - delta.y.
+        std::rotate(_rowCache.begin(), _rowCache.begin() - delta.y, _rowCache.end());
+        _InvalidateRowCache(size + delta.y, size);
+    }
+    else if (delta.y > 0)
+    {
+        std::rotate(_rowCache.begin(), _rowCache.end() - delta.y, _rowCache.end());
+        _InvalidateRowCache(0, delta.y);
+    }
+
+    // The patterns are stored relative to the viewport and don't move along with the text.
+    for (auto& row : _rowCache)
+    {
+        if (row.hasPatterns)
+        {
+            row.valid = false;
         }
     }
 }
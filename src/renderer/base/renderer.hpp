@@ -93,6 +93,50 @@ namespace Microsoft::Console::Render
         void UpdateLastHoveredInterval(const std::optional<interval_tree::IntervalTree<til::point, size_t>::interval>& newInterval);
 
     private:
+        // A cluster in a CachedRow, stored as an offset into ROW::GetText(), because the ROW
+        // that's visible at a given position of the viewport changes as the buffer scrolls.
+        struct CachedCluster
+        {
+            uint16_t offset = 0;
+            uint16_t length = 0;
+            til::CoordType columns = 0;
+        };
+
+        // The arguments of the calls _PaintBufferOutputHelper() made for a single run of text.
+        struct CachedRun
+        {
+            TextAttribute attr;
+            til::CoordType x = 0;
+            til::CoordType gridLineX = 0;
+            til::CoordType cols = 0;
+            // The end of this run's clusters in CachedRow::clusters.
+            size_t clustersEnd = 0;
+            // The end of this run's per-column attributes in CachedRow::gridLineAttrs.
+            size_t gridLineAttrsEnd = 0;
+            bool usingSoftFont = false;
+            bool trimLeft = false;
+            bool containsWideCharacter = false;
+        };
+
+        // What _PaintBufferOutputHelper() computed for a row of the viewport during the last frame. As long as
+        // the ROW's ContentHash() and the other inputs are the same, the row can be painted again from here,
+        // without walking through its cells. Changes to the patterns (URLs) are picked up via TriggerRedraw().
+        struct CachedRow
+        {
+            std::vector<CachedRun> runs;
+            std::vector<CachedCluster> clusters;
+            std::vector<TextAttribute> gridLineAttrs;
+            size_t hash = 0;
+            size_t lastSoftFontChar = 0;
+            til::CoordType left = 0;
+            til::CoordType right = 0;
+            bool lineWrapped = false;
+            bool globalInvert = false;
+            bool gridLines = false;
+            bool hasPatterns = false;
+            bool valid = false;
+        };
+
         static GridLineSet s_GetGridlines(const TextAttribute& textAttribute) noexcept;
         static bool s_IsSoftFontChar(const std::wstring_view& v, const size_t firstSoftFontChar, const size_t lastSoftFontChar);
 
@@ -100,7 +144,10 @@ namespace Microsoft::Console::Render
         bool _CheckViewportAndScroll();
         [[nodiscard]] HRESULT _PaintBackground(_In_ IRenderEngine* const pEngine);
         void _PaintBufferOutput(_In_ IRenderEngine* const pEngine);
-        void _PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine, TextBufferCellIterator it, const til::point target, const bool lineWrapped);
+        void _PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine, TextBufferCellIterator it, const til::point target, const bool lineWrapped, CachedRow* cache = nullptr, std::wstring_view rowText = {});
+        void _PaintCachedBufferOutput(_In_ IRenderEngine* const pEngine, const CachedRow& cache, const std::wstring_view& rowText, const til::point target, const bool lineWrapped);
+        void _InvalidateRowCache(til::CoordType top, til::CoordType bottom) noexcept;
+        void _ScrollRowCache(const til::point delta);
         void _PaintBufferOutputGridLineHelper(_In_ IRenderEngine* const pEngine, const TextAttribute textAttribute, const size_t cchLine, const til::point coordTarget);
         bool _isHoveredHyperlink(const TextAttribute& textAttribute) const noexcept;
         void _PaintSelection(_In_ IRenderEngine* const pEngine);
@@ -127,6 +174,8 @@ namespace Microsoft::Console::Render
         std::optional<interval_tree::IntervalTree<til::point, size_t>::interval> _hoveredInterval;
         Microsoft::Console::Types::Viewport _viewport;
         std::vector<Cluster> _clusterBuffer;
+        // Indexed by the row's position in the viewport.
+        std::vector<CachedRow> _rowCache;
         std::vector<til::rect> _previousSelection;
         std::vector<til::rect> _previousSearchSelection;
         std::function<void()> _pfnBackgroundColorChanged;
@@ -398,6 +398,9 @@ try
         RETURN_IF_FAILED(_InsertLine(absDy));
     }
 
+    // The terminal moved its rows, so move ours too.
+    _ScrollShadowFrame(dy);
+
     // Restore our wrap state.
     _wrappedRow = oldWrappedRow;
     _delayedEolWrap = oldDelayedEolWrap;
@@ -523,6 +526,8 @@ CATCH_RETURN();
 // - S_OK or suitable HRESULT error from either conversion or writing pipe.
 [[nodiscard]] HRESULT XtermEngine::WriteTerminalW(const std::wstring_view wstr) noexcept
 {
+    // We don't know what this sequence does to the terminal's contents.
+    _InvalidateShadowFrame();
     RETURN_IF_FAILED(_fUseAsciiOnly ?
                          VtEngine::_WriteTerminalAscii(wstr) :
                          VtEngine::_WriteTerminalUtf8(wstr));
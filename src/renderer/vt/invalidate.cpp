@@ -92,6 +92,9 @@ try
 {
     _trace.TraceInvalidateAll(_lastViewport.ToOrigin().ToExclusive());
     _invalidMap.set_all();
+    // Redrawing everything is also how we get back in sync with a terminal
+    // that changed on its own (for instance if the user cleared its buffer).
+    _InvalidateShadowFrame();
     return S_OK;
 }
 CATCH_RETURN();
@@ -450,9 +450,15 @@ using namespace Microsoft::Console::Types;
 // Routine Description:
 // - Draws one line of the buffer to the screen. Writes the characters to the
 //      pipe, encoded in UTF-8.
+// - Clusters that the terminal already displays with the current attributes
+//      (according to our shadow frame) are skipped, similar to ncurses'
+//      doupdate(). Applications like TUIs often rewrite their entire screen,
+//      even if only a few cells changed, and this avoids sending all of it.
 // Arguments:
 // - clusters - text and column widths to be written
 // - coord - character coordinate target to render within viewport
+// - lineWrapped: true if this run we're painting is the end of a line that
+//   wrapped.
 // Return Value:
 // - S_OK or suitable HRESULT error from writing pipe.
 [[nodiscard]] HRESULT VtEngine::_PaintUtf8BufferLine(const std::span<const Cluster> clusters,
@@ -464,6 +470,79 @@ using namespace Microsoft::Console::Types;
         return S_OK;
     }
 
+    if (!_ShadowFrameEnabled())
+    {
+        _InvalidateShadowFrame();
+        return _PaintUtf8Span(clusters, coord, lineWrapped);
+    }
+
+    // The clusters that need to be written are grouped into spans. We join
+    // two spans if the unchanged gap between them is narrower than a CUF
+    // sequence, because rewriting those few cells is cheaper than skipping them.
+    //
+    // The last cell of a wrapped line is always written, since writing it is
+    // what puts the terminal into the delayed EOL wrap state. Similarly, if the
+    // previous line just wrapped, the first cell of this one needs to be
+    // written to actually wrap the line in the terminal.
+    const auto size = clusters.size();
+    const auto continuesWrappedRow = coord.x == 0 && _wrappedRow.has_value() && *_wrappedRow == coord.y - 1;
+    auto x = coord.x;
+    size_t spanBeg = 0;
+    size_t spanEnd = 0;
+    til::CoordType spanBegX = 0;
+    til::CoordType spanEndX = 0;
+    auto haveSpan = false;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        const auto& cluster = til::at(clusters, i);
+        const auto columns = cluster.GetColumns();
+        const auto mustWrite = (i == 0 && continuesWrappedRow) ||
+                               (i == size - 1 && lineWrapped) ||
+                               !_IsInShadowFrame(cluster, { x, coord.y });
+
+        if (mustWrite)
+        {
+            if (haveSpan && x - spanEndX >= CURSOR_FORWARD_STRING_LENGTH)
+            {
+                RETURN_IF_FAILED(_PaintUtf8Span(clusters.subspan(spanBeg, spanEnd - spanBeg), { spanBegX, coord.y }, false));
+                haveSpan = false;
+            }
+            if (!haveSpan)
+            {
+                spanBeg = i;
+                spanBegX = x;
+                haveSpan = true;
+            }
+            spanEnd = i + 1;
+            spanEndX = x + columns;
+        }
+
+        x += columns;
+    }
+
+    if (haveSpan)
+    {
+        RETURN_IF_FAILED(_PaintUtf8Span(clusters.subspan(spanBeg, spanEnd - spanBeg), { spanBegX, coord.y }, lineWrapped && spanEnd == size));
+    }
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Writes a run of clusters to the pipe, encoded in UTF-8, without consulting
+//      the shadow frame. Afterwards the shadow frame contains these clusters.
+// Arguments:
+// - clusters - text and column widths to be written
+// - coord - character coordinate target to render within viewport
+// - lineWrapped: true if this run we're painting is the end of a line that
+//   wrapped.
+// Return Value:
+// - S_OK or suitable HRESULT error from writing pipe.
+[[nodiscard]] HRESULT VtEngine::_PaintUtf8Span(const std::span<const Cluster> clusters,
+                                               const til::point coord,
+                                               const bool lineWrapped) noexcept
+{
     _bufferLine.clear();
     _bufferLine.reserve(clusters.size());
     til::CoordType totalWidth = 0;
@@ -670,6 +749,15 @@ using namespace Microsoft::Console::Types;
         _newBottomLineBG = std::nullopt;
     }
 
+    // If we didn't write the trailing spaces, the terminal shows blank cells
+    // there instead. That looks the same as our spaces, unless they have
+    // visual attributes like underline. In that case we don't know what's there.
+    const auto knownColumns = removeSpaces && _lastTextAttributes.HasAnyVisualAttributes() ? columnsActual : totalWidth;
+    if (_ShadowFrameEnabled())
+    {
+        _StoreInShadowFrame(clusters, coord, knownColumns);
+    }
+
     return S_OK;
 }
 
@@ -686,3 +774,155 @@ using namespace Microsoft::Console::Types;
 {
     return S_OK;
 }
+
+// Method Description:
+// - Returns whether _PaintUtf8BufferLine may skip cells based on the shadow frame.
+//   In passthrough mode the application writes to the terminal directly, and
+//   line renditions change how many cells a row has, so we can't use it then.
+bool VtEngine::_ShadowFrameEnabled() const noexcept
+{
+    return !_passthrough && !_usingLineRenditions;
+}
+
+// Method Description:
+// - Forgets everything we know about the terminal's contents. The next
+//      frame will write all invalidated cells again.
+void VtEngine::_InvalidateShadowFrame() noexcept
+{
+    _shadowFrame.clear();
+}
+
+// Method Description:
+// - Moves the rows of the shadow frame by the given number of rows, just like
+//      ScrollFrame did with the terminal. The revealed rows are unknown.
+// Arguments:
+// - delta - The number of rows to move down by (up, if negative).
+void VtEngine::_ScrollShadowFrame(const til::CoordType delta) noexcept
+{
+    const auto height = gsl::narrow_cast<til::CoordType>(_shadowFrame.size());
+    const auto distance = std::abs(delta);
+
+    if (distance >= height)
+    {
+        _InvalidateShadowFrame();
+        return;
+    }
+
+    const auto beg = _shadowFrame.begin();
+    const auto end = _shadowFrame.end();
+    auto revealed = beg;
+
+    if (delta < 0)
+    {
+        // The top rows scrolled out of the viewport and new ones appeared at the bottom.
+        std::rotate(beg, beg + distance, end);
+        revealed = end - distance;
+    }
+    else
+    {
+        // Rows were inserted at the top and the bottom rows were pushed out.
+        std::rotate(beg, end - distance, end);
+    }
+
+    for (auto it = revealed; it != revealed + distance; ++it)
+    {
+        for (auto& cell : *it)
+        {
+            cell.valid = false;
+        }
+    }
+}
+
+// Method Description:
+// - Returns true if the terminal already displays the given cluster with the
+//      current attributes at the given position, according to the shadow frame.
+// Arguments:
+// - cluster - The text and width of the cell.
+// - coord - The position of its first column within the viewport.
+bool VtEngine::_IsInShadowFrame(const Cluster& cluster, const til::point coord) const noexcept
+{
+    const auto columns = cluster.GetColumns();
+    if (coord.y < 0 || coord.y >= gsl::narrow_cast<til::CoordType>(_shadowFrame.size()) || columns <= 0)
+    {
+        return false;
+    }
+
+    const auto& row = til::at(_shadowFrame, coord.y);
+    if (coord.x < 0 || coord.x + columns > gsl::narrow_cast<til::CoordType>(row.size()))
+    {
+        return false;
+    }
+
+    for (auto x = coord.x; x < coord.x + columns; ++x)
+    {
+        const auto& cell = til::at(row, x);
+        const auto expected = x == coord.x ? cluster.GetText() : std::wstring_view{};
+        if (!cell.valid || cell.text != expected || cell.attributes != _lastTextAttributes)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Method Description:
+// - Records that the terminal now displays the given clusters with the current
+//      attributes. Columns past `knownColumns` were touched, but we don't know
+//      what they look like now.
+// Arguments:
+// - clusters - The text and widths of the cells that were written.
+// - coord - The position of the first cluster within the viewport.
+// - knownColumns - The number of columns whose contents are known.
+void VtEngine::_StoreInShadowFrame(const std::span<const Cluster> clusters, const til::point coord, const til::CoordType knownColumns) noexcept
+try
+{
+    const auto size = _lastViewport.Dimensions();
+    if (coord.y < 0 || coord.y >= size.height)
+    {
+        return;
+    }
+
+    if (_shadowFrame.empty() || _shadowFrame.size() != gsl::narrow_cast<size_t>(size.height) || _shadowFrame.front().size() != gsl::narrow_cast<size_t>(size.width))
+    {
+        _shadowFrame.assign(gsl::narrow_cast<size_t>(size.height), std::vector<ShadowCell>(gsl::narrow_cast<size_t>(size.width)));
+    }
+
+    auto& row = til::at(_shadowFrame, coord.y);
+    const auto width = size.width;
+    const auto knownEnd = coord.x + knownColumns;
+    auto x = coord.x;
+
+    // Overwriting either half of a wide glyph erases all of it, but terminals
+    // differ in what they show in its place. So we treat the other half as unknown.
+    if (x > 0 && x < width && til::at(row, x).valid && til::at(row, x).text.empty())
+    {
+        til::at(row, x - 1).valid = false;
+    }
+
+    for (const auto& cluster : clusters)
+    {
+        const auto columns = cluster.GetColumns();
+        for (auto i = 0; i < columns && x < width; ++i, ++x)
+        {
+            if (x < 0)
+            {
+                continue;
+            }
+            auto& cell = til::at(row, x);
+            cell.valid = x + columns - i <= knownEnd;
+            cell.text = i == 0 ? cluster.GetText() : std::wstring_view{};
+            cell.attributes = _lastTextAttributes;
+        }
+    }
+
+    if (x > 0 && x < width && til::at(row, x).valid && til::at(row, x).text.empty())
+    {
+        til::at(row, x).valid = false;
+    }
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    _InvalidateShadowFrame();
+}
@@ -174,6 +174,8 @@ void VtEngine::Cork(bool corked) noexcept
 // - Wrapper for _Write.
 [[nodiscard]] HRESULT VtEngine::WriteTerminalUtf8(const std::string_view str) noexcept
 {
+    // We don't know what this does to the terminal's contents.
+    _InvalidateShadowFrame();
     return _Write(str);
 }
 
@@ -282,6 +284,9 @@ void VtEngine::Cork(bool corked) noexcept
 
     if (oldSize != newSize)
     {
+        // The terminal may reflow its contents on resize.
+        _InvalidateShadowFrame();
+
         // Don't emit a resize event if we've requested it be suppressed
         if (!_suppressResizeRepaint)
         {
@@ -539,6 +544,7 @@ HRESULT VtEngine::RequestWin32Input() noexcept
 
 HRESULT VtEngine::SwitchScreenBuffer(const bool useAltBuffer) noexcept
 {
+    _InvalidateShadowFrame();
     RETURN_IF_FAILED(_SwitchScreenBuffer(useAltBuffer));
     _Flush();
     return S_OK;
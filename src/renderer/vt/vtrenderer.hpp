@@ -42,6 +42,8 @@ namespace Microsoft::Console::Render
     public:
         // See _PaintUtf8BufferLine for explanation of this value.
         static const size_t ERASE_CHARACTER_STRING_LENGTH = 8;
+        // See _PaintUtf8BufferLine for explanation of this value.
+        static const til::CoordType CURSOR_FORWARD_STRING_LENGTH = 4;
         static const til::point INVALID_COORDS;
 
         VtEngine(_In_ wil::unique_hfile hPipe,
@@ -141,6 +143,18 @@ namespace Microsoft::Console::Render
         bool _corked{ false };
         std::optional<TextColor> _newBottomLineBG{ std::nullopt };
 
+        // A copy of what we believe the terminal displays, one vector per viewport row.
+        // _PaintUtf8BufferLine compares new runs against it and only writes the cells that changed.
+        // It only contains the cells we painted ourselves and is discarded whenever
+        // the terminal may have changed in a way we can't follow.
+        struct ShadowCell
+        {
+            std::wstring text; // Empty for the trailing half of a wide glyph.
+            TextAttribute attributes;
+            bool valid = false;
+        };
+        std::vector<std::vector<ShadowCell>> _shadowFrame;
+
         [[nodiscard]] HRESULT _WriteFill(const size_t n, const char c) noexcept;
         [[nodiscard]] HRESULT _Write(std::string_view const str) noexcept;
         void _Flush() noexcept;
@@ -222,9 +236,19 @@ namespace Microsoft::Console::Render
                                                    const til::point coord,
                                                    const bool lineWrapped) noexcept;
 
+        [[nodiscard]] HRESULT _PaintUtf8Span(const std::span<const Cluster> clusters,
+                                             const til::point coord,
+                                             const bool lineWrapped) noexcept;
+
         [[nodiscard]] HRESULT _PaintAsciiBufferLine(const std::span<const Cluster> clusters,
                                                     const til::point coord) noexcept;
 
+        bool _ShadowFrameEnabled() const noexcept;
+        void _InvalidateShadowFrame() noexcept;
+        void _ScrollShadowFrame(const til::CoordType delta) noexcept;
+        bool _IsInShadowFrame(const Cluster& cluster, const til::point coord) const noexcept;
+        void _StoreInShadowFrame(const std::span<const Cluster> clusters, const til::point coord, const til::CoordType knownColumns) noexcept;
+
         [[nodiscard]] HRESULT _WriteTerminalUtf8(const std::wstring_view str) noexcept;
         [[nodiscard]] HRESULT _WriteTerminalAscii(const std::wstring_view str) noexcept;
         [[nodiscard]] HRESULT _WriteTerminalDrcs(const std::wstring_view str) noexcept;
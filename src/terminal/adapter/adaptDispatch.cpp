@@ -609,21 +609,10 @@ void AdaptDispatch::_ScrollRectVertically(TextBuffer& textBuffer, const til::rec
         }
         else
         {
-            // Otherwise we have to move the content up or down by copying the
-            // requested buffer range one cell at a time.
-            const auto srcOrigin = til::point{ scrollRect.left, top };
-            const auto dstOrigin = til::point{ scrollRect.left, top + actualDelta };
-            const auto srcView = Viewport::FromDimensions(srcOrigin, width, height);
-            const auto dstView = Viewport::FromDimensions(dstOrigin, width, height);
-            const auto walkDirection = Viewport::DetermineWalkDirection(srcView, dstView);
-            auto srcPos = srcView.GetWalkOrigin(walkDirection);
-            auto dstPos = dstView.GetWalkOrigin(walkDirection);
-            do
-            {
-                const auto current = OutputCell(*textBuffer.GetCellDataAt(srcPos));
-                textBuffer.WriteLine(OutputCellIterator({ &current, 1 }), dstPos);
-                srcView.WalkInBounds(srcPos, walkDirection);
-            } while (dstView.WalkInBounds(dstPos, walkDirection));
+            // Otherwise we have to move the content up or down by copying
+            // the requested column range of each row.
+            const auto srcRect = til::rect{ scrollRect.left, top, scrollRect.right, top + height };
+            textBuffer.CopyRect(srcRect, { scrollRect.left, top + actualDelta });
         }
     }
 
@@ -657,22 +646,10 @@ void AdaptDispatch::_ScrollRectHorizontally(TextBuffer& textBuffer, const til::r
         const auto height = scrollRect.height();
         const auto actualDelta = delta > 0 ? absoluteDelta : -absoluteDelta;
 
-        const auto source = Viewport::FromDimensions({ left, top }, width, height);
-        const auto target = Viewport::Offset(source, { actualDelta, 0 });
-        const auto walkDirection = Viewport::DetermineWalkDirection(source, target);
-        auto sourcePos = source.GetWalkOrigin(walkDirection);
-        auto targetPos = target.GetWalkOrigin(walkDirection);
-        // Note that we read two cells from the source before we start writing
-        // to the target, so a two-cell DBCS character can't accidentally delete
-        // itself when moving one cell horizontally.
-        auto next = OutputCell(*textBuffer.GetCellDataAt(sourcePos));
-        do
-        {
-            const auto current = next;
-            source.WalkInBounds(sourcePos, walkDirection);
-            next = OutputCell(*textBuffer.GetCellDataAt(sourcePos));
-            textBuffer.WriteLine(OutputCellIterator({ &current, 1 }), targetPos);
-        } while (target.WalkInBounds(targetPos, walkDirection));
+        // CopyRect() copies each row through a temporary, so a two-cell DBCS
+        // character can't accidentally delete itself when moving one cell.
+        const auto source = til::rect{ left, top, left + width, top + height };
+        textBuffer.CopyRect(source, { left + actualDelta, top });
     }
 
     // Columns revealed by the scroll are filled with standard erase attributes.
@@ -884,17 +861,16 @@ void AdaptDispatch::_SelectiveEraseRect(TextBuffer& textBuffer, const til::rect&
         for (auto row = eraseRect.top; row < eraseRect.bottom; row++)
         {
             auto& rowBuffer = textBuffer.GetMutableRowByOffset(row);
-            for (auto col = eraseRect.left; col < eraseRect.right; col++)
-            {
+            rowBuffer.ForEachAttributeRun(eraseRect.left, eraseRect.right, [&](const auto beg, const auto end, const TextAttribute& attr) {
                 // Only unprotected cells are affected.
-                if (!rowBuffer.GetAttrByColumn(col).IsProtected())
+                if (!attr.IsProtected())
                 {
                     // The text is cleared but the attributes are left as is.
-                    rowBuffer.ClearCell(col);
-                    textBuffer.TriggerRedraw(Viewport::FromCoord({ col, row }));
+                    rowBuffer.ClearCells(beg, end);
                 }
-            }
+            });
         }
+        textBuffer.TriggerRedraw(Viewport::FromExclusive(eraseRect));
         _api.NotifyAccessibilityChange(eraseRect);
     }
 }
@@ -985,10 +961,9 @@ void AdaptDispatch::_ChangeRectAttributes(TextBuffer& textBuffer, const til::rec
     {
         for (auto row = changeRect.top; row < changeRect.bottom; row++)
         {
+            // The changes are applied once per run of attributes, not once per cell.
             auto& rowBuffer = textBuffer.GetMutableRowByOffset(row);
-            for (auto col = changeRect.left; col < changeRect.right; col++)
-            {
-                auto attr = rowBuffer.GetAttrByColumn(col);
+            rowBuffer.TransformAttributes(changeRect.left, changeRect.right, [&](TextAttribute attr) {
                 auto characterAttributes = attr.GetCharacterAttributes();
                 characterAttributes &= changeOps.andAttrMask;
                 characterAttributes ^= changeOps.xorAttrMask;
@@ -1005,8 +980,8 @@ void AdaptDispatch::_ChangeRectAttributes(TextBuffer& textBuffer, const til::rec
                 {
                     attr.SetUnderlineColor(*changeOps.underlineColor);
                 }
-                rowBuffer.ReplaceAttributes(col, col + 1, attr);
-            }
+                return attr;
+            });
         }
         textBuffer.TriggerRedraw(Viewport::FromExclusive(changeRect));
         _api.NotifyAccessibilityChange(changeRect);
@@ -1230,28 +1205,22 @@ bool AdaptDispatch::CopyRectangularArea(const VTInt top, const VTInt left, const
     {
         // If the source is bigger than the available space at the destination
         // it needs to be clipped, so we only care about the destination size.
-        const auto srcView = Viewport::FromDimensions(srcRect.origin(), dstRect.size());
-        const auto dstView = Viewport::FromDimensions(dstRect.origin(), dstRect.size());
-        const auto walkDirection = Viewport::DetermineWalkDirection(srcView, dstView);
-        auto srcPos = srcView.GetWalkOrigin(walkDirection);
-        auto dstPos = dstView.GetWalkOrigin(walkDirection);
-        // Note that we read two cells from the source before we start writing
-        // to the target, so a two-cell DBCS character can't accidentally delete
-        // itself when moving one cell horizontally.
-        auto next = OutputCell(*textBuffer.GetCellDataAt(srcPos));
-        do
+        const auto width = dstRect.width();
+        const auto height = dstRect.height();
+        // The rows are copied one at a time, because the part of a double width
+        // source row that is offscreen mustn't be copied to the destination.
+        // Like CopyRect() we walk bottom-up if the destination is further down.
+        const auto bottomUp = dstRect.top > srcRect.top;
+        for (til::CoordType i = 0; i < height; ++i)
         {
-            const auto current = next;
-            const auto currentSrcPos = srcPos;
-            srcView.WalkInBounds(srcPos, walkDirection);
-            next = OutputCell(*textBuffer.GetCellDataAt(srcPos));
-            // If the source position is offscreen (which can occur on double
-            // width lines), then we shouldn't copy anything to the destination.
-            if (currentSrcPos.x < textBuffer.GetLineWidth(currentSrcPos.y))
+            const auto dy = bottomUp ? height - 1 - i : i;
+            const auto srcY = srcRect.top + dy;
+            const auto srcRight = std::min(srcRect.left + width, textBuffer.GetLineWidth(srcY));
+            if (srcRight > srcRect.left)
             {
-                textBuffer.WriteLine(OutputCellIterator({ &current, 1 }), dstPos);
+                textBuffer.CopyRect({ srcRect.left, srcY, srcRight, srcY + 1 }, { dstRect.left, dstRect.top + dy });
             }
-        } while (dstView.WalkInBounds(dstPos, walkDirection));
+        }
         _api.NotifyAccessibilityChange(dstRect);
     }
 
@@ -1382,33 +1351,45 @@ bool AdaptDispatch::RequestChecksumRectangularArea(const VTInt id, const VTInt p
 
             const auto& textBuffer = _api.GetTextBuffer();
             const auto eraseRect = _CalculateRectArea(top, left, bottom, right, textBuffer.GetSize().Dimensions());
+            // The checksum is a sum over all cells, so instead of visiting each cell
+            // we can sum up each glyph and each run of attributes once per row,
+            // and multiply that with the number of cells they cover.
             for (auto row = eraseRect.top; row < eraseRect.bottom; row++)
             {
-                for (auto col = eraseRect.left; col < eraseRect.right; col++)
+                const auto& rowBuffer = textBuffer.GetRowByOffset(row);
+
+                for (auto col = eraseRect.left; col < eraseRect.right;)
                 {
                     // The algorithm we're using here should match the DEC terminals
                     // for the ASCII and Latin-1 range. Their other character sets
                     // predate Unicode, though, so we'd need a custom mapping table
                     // to lookup the correct checksums. Considering this is only for
                     // testing at the moment, that doesn't seem worth the effort.
-                    const auto cell = textBuffer.GetCellDataAt({ col, row });
-                    for (auto ch : cell->Chars())
+                    uint16_t glyphSum = 0;
+                    for (auto ch : rowBuffer.GlyphAt(col))
                     {
                         // That said, I've made a special allowance for U+2426,
                         // since that is widely used in a lot of character sets.
-                        checksum -= (ch == L'\u2426' ? 0x1B : ch);
+                        glyphSum += (ch == L'\u2426' ? 0x1B : ch);
                     }
 
+                    // Wide glyphs are counted once for each of their cells.
+                    const auto next = std::min(rowBuffer.NavigateToNext(col), eraseRect.right);
+                    checksum -= gsl::narrow_cast<uint16_t>(glyphSum * (next - col));
+                    col = next;
+                }
+
+                rowBuffer.ForEachAttributeRun(eraseRect.left, eraseRect.right, [&](const auto beg, const auto end, const TextAttribute& attr) {
                     // Since we're attempting to match the DEC checksum algorithm,
                     // the only attributes affecting the checksum are the ones that
                     // were supported by DEC terminals.
-                    const auto attr = cell->TextAttr();
-                    checksum -= attr.IsProtected() ? 0x04 : 0;
-                    checksum -= attr.IsInvisible() ? 0x08 : 0;
-                    checksum -= attr.IsUnderlined() ? 0x10 : 0;
-                    checksum -= attr.IsReverseVideo() ? 0x20 : 0;
-                    checksum -= attr.IsBlinking() ? 0x40 : 0;
-                    checksum -= attr.IsIntense() ? 0x80 : 0;
+                    uint16_t attrSum = 0;
+                    attrSum += attr.IsProtected() ? 0x04 : 0;
+                    attrSum += attr.IsInvisible() ? 0x08 : 0;
+                    attrSum += attr.IsUnderlined() ? 0x10 : 0;
+                    attrSum += attr.IsReverseVideo() ? 0x20 : 0;
+                    attrSum += attr.IsBlinking() ? 0x40 : 0;
+                    attrSum += attr.IsIntense() ? 0x80 : 0;
 
                     // For the same reason, we only care about the eight basic ANSI
                     // colors, although technically we also report the 8-16 index
@@ -1418,9 +1399,11 @@ bool AdaptDispatch::RequestChecksumRectangularArea(const VTInt id, const VTInt p
                     };
                     const auto fgIndex = colorIndex(attr.GetForeground(), defaultFgIndex);
                     const auto bgIndex = colorIndex(attr.GetBackground(), defaultBgIndex);
-                    checksum -= gsl::narrow_cast<uint16_t>(fgIndex << 4);
-                    checksum -= gsl::narrow_cast<uint16_t>(bgIndex);
-                }
+                    attrSum += gsl::narrow_cast<uint16_t>(fgIndex << 4);
+                    attrSum += gsl::narrow_cast<uint16_t>(bgIndex);
+
+                    checksum -= gsl::narrow_cast<uint16_t>(attrSum * (end - beg));
+                });
             }
         }
     }
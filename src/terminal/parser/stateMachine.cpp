@@ -5,10 +5,14 @@
 
 #include "stateMachine.hpp"
 
+#include <isa_availability.h>
+
 #include "ascii.hpp"
 
 using namespace Microsoft::Console::VirtualTerminal;
 
+extern "C" int __isa_available;
+
 //Takes ownership of the pEngine.
 StateMachine::StateMachine(std::unique_ptr<IStateMachineEngine> engine, const bool isEngineForInput) :
     _engine(std::move(engine)),
@@ -1991,6 +1995,54 @@ static size_t findActionableFromGround(const wchar_t* data, size_t count) noexce
 
     auto it = data;
 
+    // __isa_available is initialized once by the CRT during startup. The wider loops handle the bulk of
+    // the input and leave the remaining <32 or <16 characters to the SSE2 loop and the plain loop.
+    if (__isa_available >= __ISA_AVAILABLE_AVX512)
+    {
+        for (const auto end = data + (count & ~size_t{ 31 }); it < end; it += 32)
+        {
+            const auto wch = _mm512_loadu_si512(it);
+
+            // AVX-512BW has proper unsigned comparisons, so this is a straightforward translation.
+            const auto a = _mm512_cmple_epu16_mask(wch, _mm512_set1_epi16(0x1f));
+            const auto b = _mm512_cmple_epu16_mask(_mm512_sub_epi16(wch, _mm512_set1_epi16(0x7f)), _mm512_set1_epi16(0x20));
+            const auto mask = static_cast<unsigned long>(a | b);
+
+            if (mask)
+            {
+                unsigned long offset;
+                _BitScanForward(&offset, mask);
+                it += offset;
+                return it - data;
+            }
+        }
+    }
+    else if (__isa_available >= __ISA_AVAILABLE_AVX2)
+    {
+        for (const auto end = data + (count & ~size_t{ 15 }); it < end; it += 16)
+        {
+            const auto wch = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            const auto z = _mm256_setzero_si256();
+
+            // See the SSE2 loop below.
+            auto a = _mm256_subs_epu16(wch, _mm256_set1_epi16(0x1f));
+            auto b = _mm256_subs_epu16(_mm256_add_epi16(wch, _mm256_set1_epi16(static_cast<short>(0xff81))), _mm256_set1_epi16(0x20));
+            a = _mm256_cmpeq_epi16(a, z);
+            b = _mm256_cmpeq_epi16(b, z);
+
+            const auto c = _mm256_or_si256(a, b);
+            const auto mask = static_cast<unsigned long>(_mm256_movemask_epi8(c));
+
+            if (mask)
+            {
+                unsigned long offset;
+                _BitScanForward(&offset, mask);
+                it += offset / 2;
+                return it - data;
+            }
+        }
+    }
+
     for (const auto end = data + (count & ~size_t{ 7 }); it < end; it += 8)
     {
         const auto wch = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
@@ -2065,6 +2117,86 @@ exitWithMask:
 #endif
 }
 
+// The UTF-8 equivalent of findActionableFromGround: Returns a pointer to the first byte in [it,end) that is a
+// C0 control character, DEL, or 0xC2, which is the lead byte of all C1 control characters (U+0080 to U+009F).
+static const char* findActionableCandidateUtf8(const char* it, const char* end) noexcept
+{
+#if defined(TIL_SSE_INTRINSICS)
+
+    if (__isa_available >= __ISA_AVAILABLE_AVX2)
+    {
+        for (; end - it >= 32; it += 32)
+        {
+            const auto ch = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            const auto a = _mm256_cmpeq_epi8(_mm256_subs_epu8(ch, _mm256_set1_epi8(0x1f)), _mm256_setzero_si256());
+            const auto b = _mm256_cmpeq_epi8(ch, _mm256_set1_epi8(0x7f));
+            const auto c = _mm256_cmpeq_epi8(ch, _mm256_set1_epi8(static_cast<char>(0xc2)));
+            const auto mask = static_cast<unsigned long>(_mm256_movemask_epi8(_mm256_or_si256(a, _mm256_or_si256(b, c))));
+
+            if (mask)
+            {
+                unsigned long offset;
+                _BitScanForward(&offset, mask);
+                return it + offset;
+            }
+        }
+    }
+
+    for (; end - it >= 16; it += 16)
+    {
+        const auto ch = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+        const auto a = _mm_cmpeq_epi8(_mm_subs_epu8(ch, _mm_set1_epi8(0x1f)), _mm_setzero_si128());
+        const auto b = _mm_cmpeq_epi8(ch, _mm_set1_epi8(0x7f));
+        const auto c = _mm_cmpeq_epi8(ch, _mm_set1_epi8(static_cast<char>(0xc2)));
+        const auto mask = static_cast<unsigned long>(_mm_movemask_epi8(_mm_or_si128(a, _mm_or_si128(b, c))));
+
+        if (mask)
+        {
+            unsigned long offset;
+            _BitScanForward(&offset, mask);
+            return it + offset;
+        }
+    }
+
+#endif
+
+#pragma loop(no_vector)
+    for (; it < end; ++it)
+    {
+        const auto ch = static_cast<uint8_t>(*it);
+        if (ch <= 0x1f || ch == 0x7f || ch == 0xc2)
+        {
+            break;
+        }
+    }
+
+    return it;
+}
+
+// Returns the number of bytes at the start of the given UTF-8 string that
+// can be printed as-is, because they don't contain any control characters.
+static size_t findActionableFromGroundUtf8(const char* data, size_t count) noexcept
+{
+    const auto end = data + count;
+    auto it = data;
+
+    for (;;)
+    {
+        it = findActionableCandidateUtf8(it, end);
+
+        // U+0080 to U+009F are encoded as C2 80 to C2 9F. If the C2 is the last byte we
+        // can't know yet, so we let ProcessStringUtf8 deal with it the slow way.
+        if (it == end || static_cast<uint8_t>(*it) != 0xc2 || it + 1 == end || static_cast<uint8_t>(it[1]) <= 0x9f)
+        {
+            break;
+        }
+
+        it += 2;
+    }
+
+    return it - data;
+}
+
 #pragma warning(pop)
 
 // Routine Description:
@@ -2185,6 +2317,72 @@ void StateMachine::ProcessString(const std::wstring_view string)
     }
 }
 
+// Routine Description:
+// - Same as ProcessString(), but for UTF-8 text, like the output ConPTY produces.
+//   In the ground state, the UTF-8 is scanned for actionable characters as-is and the
+//   printable runs in between are decoded in a single pass and printed right away.
+//   Everything else is decoded piece by piece and passed to ProcessString().
+// Arguments:
+// - string - UTF-8 text. Code points may be split up across calls.
+// Return Value:
+// - <none>
+void StateMachine::ProcessStringUtf8(const std::string_view string)
+{
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+
+    const auto end = string.data() + string.size();
+    auto it = string.data();
+
+    while (it != end)
+    {
+        // We can only skip the decoding for the actionable characters if there's no partial code point pending.
+        if (_state == VTStates::Ground && !_utf8State.have)
+        {
+            const auto printable = findActionableFromGroundUtf8(it, end - it);
+
+            if (printable)
+            {
+                THROW_IF_FAILED(til::u8u16({ it, printable }, _utf8Buffer, _utf8State));
+                it += printable;
+
+                if (!_utf8Buffer.empty())
+                {
+                    _currentString = _utf8Buffer;
+                    _runOffset = 0;
+                    _runSize = _utf8Buffer.size();
+                    _ActionPrintString(_CurrentRun());
+                    _runSize = 0;
+                }
+
+                if (it == end)
+                {
+                    break;
+                }
+            }
+
+            // C0 control characters other than ESC don't leave the ground state and are
+            // very common in bulk output (CR, LF), so we process them without decoding.
+            if (const auto ch = static_cast<uint8_t>(*it); ch <= 0x7f && ch != AsciiChars::ESC)
+            {
+                const auto wch = static_cast<wchar_t>(ch);
+                ProcessString({ &wch, 1 });
+                ++it;
+                continue;
+            }
+        }
+
+        // Everything else is decoded up to the next actionable character. This way each piece contains
+        // at most the start of a single sequence, followed by the text after it (if the sequence ends).
+        const auto next = it + 1 + findActionableFromGroundUtf8(it + 1, end - it - 1);
+        THROW_IF_FAILED(til::u8u16({ it, gsl::narrow_cast<size_t>(next - it) }, _utf8Buffer, _utf8State));
+        ProcessString(_utf8Buffer);
+        it = next;
+    }
+
+#pragma warning(pop)
+}
+
 // Routine Description:
 // - Determines whether the character being processed is the last in the
 //   current output fragment, or there are more still to come. Other parts
@@ -64,6 +64,7 @@ namespace Microsoft::Console::VirtualTerminal
 
         void ProcessCharacter(const wchar_t wch);
         void ProcessString(const std::wstring_view string);
+        void ProcessStringUtf8(const std::string_view string);
         bool IsProcessingLastCharacter() const noexcept;
 
         void OnCsiComplete(const std::function<void()> callback);
@@ -213,6 +214,10 @@ namespace Microsoft::Console::VirtualTerminal
 
         std::optional<std::wstring> _cachedSequence;
 
+        // Used by ProcessStringUtf8() to decode its input.
+        til::u8state _utf8State;
+        std::wstring _utf8Buffer;
+
         // This is tracked per state machine instance so that separate calls to Process*
         //   can start and finish a sequence.
         bool _processingLastCharacter;
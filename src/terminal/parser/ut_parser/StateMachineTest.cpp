@@ -7,6 +7,10 @@
 
 #include "stateMachine.hpp"
 
+#include <isa_availability.h>
+
+extern "C" int __isa_available;
+
 using namespace WEX::Common;
 using namespace WEX::Logging;
 using namespace WEX::TestExecution;
@@ -159,6 +163,8 @@ class Microsoft::Console::VirtualTerminal::StateMachineTest
     TEST_METHOD(PassThroughUnhandled);
     TEST_METHOD(RunStorageBeforeEscape);
     TEST_METHOD(BulkTextPrint);
+    TEST_METHOD(BulkTextPrintAllIsaLevels);
+    TEST_METHOD(ProcessStringUtf8MatchesUtf16);
     TEST_METHOD(PassThroughUnhandledSplitAcrossWrites);
 
     TEST_METHOD(DcsDataStringsReceivedByHandler);
@@ -236,6 +242,88 @@ void StateMachineTest::BulkTextPrint()
     VERIFY_ARE_EQUAL(String(L"12345 Hello World"), String(engine.printed.c_str()));
 }
 
+void StateMachineTest::BulkTextPrintAllIsaLevels()
+{
+    // The ground state scanner has SSE2, AVX2 and AVX-512 loops which are picked based on __isa_available
+    // and it falls back to a plain loop for the remainder. We lower __isa_available to test all of them.
+    const auto native = __isa_available;
+    const auto restoreIsa = wil::scope_exit([&]() { __isa_available = native; });
+
+    for (const auto level : { __ISA_AVAILABLE_SSE2, __ISA_AVAILABLE_AVX2, __ISA_AVAILABLE_AVX512 })
+    {
+        if (level > native)
+        {
+            continue;
+        }
+
+        __isa_available = level;
+
+        // 0x07 (C0), 0x7f (DEL) and 0x9f (C1) are inside the ranges findActionableFromGround looks for,
+        // while 0x20, 0x7e and 0xa0 right next to them are printable.
+        for (const auto actionable : { L'\x07', L'\x7f', L'\x9f' })
+        {
+            for (size_t length = 1; length <= 80; ++length)
+            {
+                for (size_t position = 0; position < length; ++position)
+                {
+                    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+                    auto& engine{ *enginePtr.get() };
+                    StateMachine machine{ std::move(enginePtr) };
+
+                    std::wstring text;
+                    for (size_t i = 0; i < length; ++i)
+                    {
+                        static constexpr wchar_t printable[]{ L' ', L'a', L'~', L'\xa0', L'\x732B' };
+                        text.push_back(printable[i % std::size(printable)]);
+                    }
+                    text[position] = actionable;
+
+                    machine.ProcessString(text);
+
+                    auto expected = text;
+                    expected.erase(position, 1);
+                    if (engine.printed != expected)
+                    {
+                        VERIFY_FAIL(NoThrowString().Format(L"level=%d actionable=%x length=%zu position=%zu", level, actionable, length, position));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void StateMachineTest::ProcessStringUtf8MatchesUtf16()
+{
+    // Printable text with 1 to 4 byte long code points, an SGR sequence, C0 controls,
+    // a NBSP (C2 A0, which is printable) and a C1 CSI (C2 9B, which is ignored by default).
+    const std::string_view input{ "abc\x1b[31mdef\r\n\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80\xc2\xa0x\xc2\x9b"
+                                  "1m\x1b[1;2Hend\x7f\x07" };
+
+    auto referencePtr{ std::make_unique<TestStateMachineEngine>() };
+    auto& reference{ *referencePtr.get() };
+    StateMachine referenceMachine{ std::move(referencePtr) };
+    referenceMachine.ProcessString(til::u8u16(input));
+
+    // Code points and sequences may be split up arbitrarily across writes.
+    for (size_t split = 0; split <= input.size(); ++split)
+    {
+        auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+        auto& engine{ *enginePtr.get() };
+        StateMachine machine{ std::move(enginePtr) };
+
+        machine.ProcessStringUtf8(input.substr(0, split));
+        machine.ProcessStringUtf8(input.substr(split));
+
+        Log::Comment(NoThrowString().Format(L"split=%zu", split));
+        VERIFY_ARE_EQUAL(reference.printed, engine.printed);
+        VERIFY_ARE_EQUAL(reference.executed, engine.executed);
+        VERIFY_ARE_EQUAL(reference.csiId, engine.csiId);
+        VERIFY_IS_TRUE(reference.csiParams == engine.csiParams);
+    }
+
+    VERIFY_ARE_EQUAL(L"abcdef\u00e4\u20ac\U0001F600\u00a0x1mend", reference.printed);
+}
+
 void StateMachineTest::PassThroughUnhandledSplitAcrossWrites()
 {
     auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
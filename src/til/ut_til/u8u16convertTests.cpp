@@ -4,10 +4,14 @@
 #include "precomp.h"
 #include "WexTestClass.h"
 
+#include <isa_availability.h>
+
 using namespace WEX::Common;
 using namespace WEX::Logging;
 using namespace WEX::TestExecution;
 
+extern "C" int __isa_available;
+
 class Utf8Utf16ConvertTests
 {
     TEST_CLASS(Utf8Utf16ConvertTests);
@@ -17,6 +21,7 @@ class Utf8Utf16ConvertTests
     TEST_METHOD(TestU8ToU16Partials);
     TEST_METHOD(TestU16ToU8Partials);
     TEST_METHOD(TestU8ToU16OneByOne);
+    TEST_METHOD(TestMatchesPlatformFunctions);
 };
 
 void Utf8Utf16ConvertTests::TestU8ToU16()
@@ -191,3 +196,75 @@ void Utf8Utf16ConvertTests::TestU8ToU16OneByOne()
     VERIFY_SUCCEEDED(til::u8u16(u8String1_4, u16Out1, state));
     VERIFY_ARE_EQUAL(u16StringComp1, u16Out1);
 }
+
+void Utf8Utf16ConvertTests::TestMatchesPlatformFunctions()
+{
+    // til::u8u16/u16u8 convert ASCII with SSE2 or AVX2, picked based on __isa_available, and valid
+    // sequences inline. Everything else is passed to the platform functions. The results must be identical.
+    const auto native = __isa_available;
+    const auto restoreIsa = wil::scope_exit([&]() { __isa_available = native; });
+
+    const std::string_view u8Fragments[]{
+        "Lorem ipsum dolor sit amet, consectetur adipiscing elit",
+        "\xC3\xB6", // LATIN SMALL LETTER O WITH DIAERESIS
+        "\xE2\x82\xAC", // EURO SIGN
+        "\xF0\xA4\xBD\x9C", // CJK UNIFIED IDEOGRAPH-24F5C
+        "\xC0\x80", // overlong NUL
+        "\xE0\x80\xAF", // overlong SOLIDUS
+        "\xED\xA0\x80", // encoded surrogate
+        "\xF4\x90\x80\x80", // past U+10FFFF
+        "\xE2\x82", // truncated
+        "\xBF", // lone trail byte
+        "\xFF",
+    };
+    const std::wstring_view u16Fragments[]{
+        L"Lorem ipsum dolor sit amet, consectetur adipiscing elit",
+        L"\x00F6\x20AC",
+        L"\xD853\xDF5C",
+        L"\xD853", // unpaired high surrogate
+        L"\xDF5C", // unpaired low surrogate
+    };
+
+    for (const auto level : { __ISA_AVAILABLE_SSE2, __ISA_AVAILABLE_AVX2 })
+    {
+        if (level > native)
+        {
+            continue;
+        }
+
+        __isa_available = level;
+
+        for (const auto& a : u8Fragments)
+        {
+            for (const auto& b : u8Fragments)
+            {
+                // The long ASCII fragment is repeated to cover both the vectorized and the plain loops.
+                std::string u8;
+                u8.append(a).append(b).append(a).append(a).append(b);
+
+                std::wstring expected(u8.size(), L'\0');
+                expected.resize(MultiByteToWideChar(CP_UTF8, 0, u8.data(), gsl::narrow<int>(u8.size()), expected.data(), gsl::narrow<int>(expected.size())));
+
+                std::wstring actual;
+                VERIFY_SUCCEEDED(til::u8u16(u8, actual));
+                VERIFY_ARE_EQUAL(expected, actual);
+            }
+        }
+
+        for (const auto& a : u16Fragments)
+        {
+            for (const auto& b : u16Fragments)
+            {
+                std::wstring u16;
+                u16.append(a).append(b).append(a).append(a).append(b);
+
+                std::string expected(u16.size() * 3, '\0');
+                expected.resize(WideCharToMultiByte(CP_UTF8, 0, u16.data(), gsl::narrow<int>(u16.size()), expected.data(), gsl::narrow<int>(expected.size()), nullptr, nullptr));
+
+                std::string actual;
+                VERIFY_SUCCEEDED(til::u16u8(u16, actual));
+                VERIFY_ARE_EQUAL(expected, actual);
+            }
+        }
+    }
+}
@@ -0,0 +1,258 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// Measures the throughput of the vectorized text scanners for each instruction set the CPU supports:
+// * StateMachine::ProcessString(), which skips over printable text with findActionableFromGround()
+// * StateMachine::ProcessStringUtf8(), which does the same directly on the UTF-8 input
+// * TextBuffer::FitTextIntoColumns() and ROW::ReplaceText(), which have an ASCII fast-path
+//   and segment the remaining text into grapheme clusters
+//
+// All of them dispatch based on the CRT's __isa_available, so we simply lower it to emulate older CPUs.
+
+#include "precomp.h"
+
+#include <chrono>
+#include <isa_availability.h>
+
+#include "../../buffer/out/textBuffer.hpp"
+#include "../../terminal/adapter/termDispatch.hpp"
+#include "../../terminal/parser/OutputStateMachineEngine.hpp"
+#include "../../terminal/parser/stateMachine.hpp"
+
+using namespace Microsoft::Console::VirtualTerminal;
+
+extern "C" int __isa_available;
+
+namespace
+{
+    class NullDispatch final : public TermDispatch
+    {
+    public:
+        void Print(const wchar_t) override
+        {
+        }
+        void PrintString(const std::wstring_view) override
+        {
+        }
+    };
+
+    struct Corpus
+    {
+        Corpus(const wchar_t* name, std::wstring text) :
+            name{ name }, text{ std::move(text) }, utf8{ til::u16u8(this->text) }
+        {
+        }
+
+        const wchar_t* name;
+        std::wstring text;
+        std::string utf8;
+    };
+
+    struct IsaLevel
+    {
+        const wchar_t* name;
+        int level;
+    };
+
+    // In wchar_t. Large enough to not fit into the L2 cache, just like a real `cat` of a large file.
+    constexpr size_t corpusSize = 16 * 1024 * 1024;
+    constexpr uint16_t columns = 120;
+    constexpr int iterations = 5;
+
+    std::wstring generate(auto&& appendLine)
+    {
+        std::wstring text;
+        text.reserve(corpusSize + 1024);
+        for (size_t i = 0; text.size() < corpusSize; ++i)
+        {
+            appendLine(text, i);
+        }
+        return text;
+    }
+
+    // `cat` of a server log: Long, plain ASCII lines.
+    std::wstring generateLog()
+    {
+        return generate([](std::wstring& text, size_t i) {
+            fmt::format_to(
+                std::back_inserter(text),
+                FMT_COMPILE(L"2024-03-{:02}T{:02}:{:02}:{:02}.{:03}Z INFO  [worker-{}] GET /api/v1/items/{} -> 200 OK in {}ms\r\n"),
+                i / 86400 % 28 + 1,
+                i / 3600 % 24,
+                i / 60 % 60,
+                i % 60,
+                i * 7 % 1000,
+                i % 8,
+                i * 2654435761 % 100000,
+                i % 97);
+        });
+    }
+
+    // `ls --color`: Short runs of text, interrupted by SGR sequences every few characters.
+    std::wstring generateLs()
+    {
+        static constexpr std::wstring_view colors[]{ L"01;34", L"01;32", L"0", L"01;36", L"0", L"0" };
+        static constexpr std::wstring_view names[]{ L"src", L"build.sh", L"README.md", L"lib", L"main.cpp", L"CMakeLists.txt" };
+
+        return generate([](std::wstring& text, size_t i) {
+            for (size_t j = 0; j < 6; ++j)
+            {
+                const auto k = (i + j) % std::size(names);
+                fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[0m\x1b[{}m{}\x1b[0m  "), colors[k], names[k]);
+            }
+            text.append(L"\r\n");
+        });
+    }
+
+    // Compiler output: Medium length lines with some color and the occasional non-ASCII quotation mark.
+    std::wstring generateCompilerOutput()
+    {
+        return generate([](std::wstring& text, size_t i) {
+            const auto quote = i % 4 == 0;
+            fmt::format_to(
+                std::back_inserter(text),
+                FMT_COMPILE(L"\x1b[1msrc/module{}/file{}.cpp:{}:{}: \x1b[35mwarning:\x1b[0m conversion from {}double{} to {}float{} may change value [-Wfloat-conversion]\r\n"),
+                i % 13,
+                i % 101,
+                i % 2000 + 1,
+                i % 80 + 1,
+                quote ? L"\u2018" : L"'",
+                quote ? L"\u2019" : L"'",
+                quote ? L"\u2018" : L"'",
+                quote ? L"\u2019" : L"'");
+        });
+    }
+
+    // Decomposed Vietnamese and Hindi: Most grapheme clusters consist of a letter and 1-2 combining marks.
+    std::wstring generateCombining()
+    {
+        static constexpr std::wstring_view words[]{ L"Tie\u0302\u0301ng", L"Vie\u0323\u0302t", L"\u0939\u093F\u0928\u094D\u0926\u0940", L"\u0928\u092E\u0938\u094D\u0924\u0947" };
+
+        return generate([](std::wstring& text, size_t i) {
+            for (size_t j = 0; j < 12; ++j)
+            {
+                text.append(words[(i + j) % std::size(words)]);
+                text.push_back(L' ');
+            }
+            text.append(L"\r\n");
+        });
+    }
+
+    // Chat logs: Emoji with modifiers, flags and ZWJ sequences, which are made up of many code points per cluster.
+    std::wstring generateEmoji()
+    {
+        static constexpr std::wstring_view clusters[]{
+            L"\U0001F600",
+            L"\U0001F44D\U0001F3FD",
+            L"\U0001F469\u200D\U0001F4BB",
+            L"\U0001F468\u200D\U0001F469\u200D\U0001F467\u200D\U0001F466",
+            L"\U0001F1E9\U0001F1EA",
+            L"\u2764\uFE0F",
+        };
+
+        return generate([](std::wstring& text, size_t i) {
+            fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"<user{}> sounds good "), i % 16);
+            for (size_t j = 0; j < 12; ++j)
+            {
+                text.append(clusters[(i + j * 3) % std::size(clusters)]);
+            }
+            text.append(L"\r\n");
+        });
+    }
+
+    // Returns the best throughput out of a couple iterations in MB/s.
+    template<typename T>
+    double measure(const std::basic_string<T>& text, auto&& func)
+    {
+        using clock = std::chrono::steady_clock;
+        auto best = clock::duration::max();
+
+        for (auto i = 0; i < iterations; ++i)
+        {
+            const auto beg = clock::now();
+            func(text);
+            best = std::min(best, clock::now() - beg);
+        }
+
+        const auto seconds = std::chrono::duration<double>(best).count();
+        return static_cast<double>(text.size() * sizeof(T)) / seconds / 1e6;
+    }
+
+    void benchParser(const std::wstring& text)
+    {
+        StateMachine machine{ std::make_unique<OutputStateMachineEngine>(std::make_unique<NullDispatch>()) };
+        machine.ProcessString(text);
+    }
+
+    void benchParserUtf8(const std::string& text)
+    {
+        StateMachine machine{ std::make_unique<OutputStateMachineEngine>(std::make_unique<NullDispatch>()) };
+        machine.ProcessStringUtf8(text);
+    }
+
+    void benchFitTextIntoColumns(const std::wstring& text)
+    {
+        std::wstring_view remaining{ text };
+        while (!remaining.empty())
+        {
+            til::CoordType used = 0;
+            const auto consumed = TextBuffer::FitTextIntoColumns(remaining, columns, used);
+            remaining = remaining.substr(std::max<size_t>(consumed, 1));
+        }
+    }
+
+    void benchReplaceText(const std::wstring& text)
+    {
+        std::vector<wchar_t> chars(ROW::CalculateCharsBufferSize(columns) / sizeof(wchar_t));
+        std::vector<uint16_t> charOffsets(ROW::CalculateCharOffsetsBufferSize(columns) / sizeof(uint16_t));
+        ROW row{ chars.data(), charOffsets.data(), columns, {} };
+
+        RowWriteState state{ .text = text };
+        while (!state.text.empty())
+        {
+            row.ReplaceText(state);
+        }
+    }
+}
+
+int wmain(int, wchar_t**)
+{
+    const auto native = __isa_available;
+    const IsaLevel levels[]{
+        { L"SSE2", __ISA_AVAILABLE_SSE2 },
+        { L"AVX2", __ISA_AVAILABLE_AVX2 },
+        { L"AVX-512", __ISA_AVAILABLE_AVX512 },
+    };
+    const Corpus corpora[]{
+        { L"log", generateLog() },
+        { L"ls --color", generateLs() },
+        { L"compiler", generateCompilerOutput() },
+        { L"combining", generateCombining() },
+        { L"emoji", generateEmoji() },
+    };
+
+    wprintf(L"%-10s %-12s %14s %18s %20s %14s\r\n", L"ISA", L"corpus", L"ProcessString", L"ProcessStringUtf8", L"FitTextIntoColumns", L"ReplaceText");
+
+    for (const auto& isa : levels)
+    {
+        if (isa.level > native)
+        {
+            wprintf(L"%-10s (not supported by this CPU)\r\n", isa.name);
+            continue;
+        }
+
+        __isa_available = isa.level;
+
+        for (const auto& corpus : corpora)
+        {
+            const auto parser = measure(corpus.text, benchParser);
+            const auto parserUtf8 = measure(corpus.utf8, benchParserUtf8);
+            const auto fit = measure(corpus.text, benchFitTextIntoColumns);
+            const auto replace = measure(corpus.text, benchReplaceText);
+            wprintf(L"%-10s %-12s %9.0f MB/s %13.0f MB/s %15.0f MB/s %9.0f MB/s\r\n", isa.name, corpus.name, parser, parserUtf8, fit, replace);
+        }
+    }
+
+    __isa_available = native;
+    return 0;
+}
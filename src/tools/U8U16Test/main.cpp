@@ -13,6 +13,9 @@
 
 #include "U8U16Test.hpp"
 
+// For til::u8u16 and til::u16u8.
+#include "LibraryIncludes.h"
+
 typedef NTSTATUS(WINAPI* t_RtlUTF8ToUnicodeN)(PWSTR, ULONG, PULONG, PCCH, ULONG);
 typedef NTSTATUS(WINAPI* t_RtlUnicodeToUTF8N)(PCHAR, ULONG, PULONG, PCWSTR, ULONG);
 NTSTATUS(WINAPI* p_RtlUTF8ToUnicodeN)
@@ -442,6 +445,73 @@ void CompNaturalLang_Chunks(const std::string& fileName)
     std::cout << " u16u8_ptr           length " << lenTotalU16U8 << " elapsed " << durTotalU16U8 << std::endl;
 }
 
+// Reports the throughput of the platform functions and of til::u8u16/u16u8 in MB of UTF-8 per second.
+// Besides converting the whole text at once, the text is converted in chunks of 4 KiB, which is
+// about what ConPTY reads and the VT renderer writes at a time. Those use the partials handling.
+void Throughput_NaturalLang(const std::string& fileName)
+{
+    std::string head{ __func__ };
+    head += " - " + fileName;
+    PrintHeader(head.c_str());
+    std::ostringstream u8Ss{};
+    std::ostringstream buf{};
+    buf << std::ifstream{ fileName }.rdbuf();
+    std::fill_n(std::ostream_iterator<const char*>{ u8Ss }, 30000u, buf.str().c_str());
+    const std::string u8Str = u8Ss.str();
+    const std::wstring u16Str = til::u8u16(u8Str);
+
+    constexpr size_t chunkSize{ 4096u };
+    const double megabytes = static_cast<double>(u8Str.length()) / 1e6;
+    const auto report = [&](const char* name, double duration) {
+        std::cout << " " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(0) << std::setw(8) << megabytes / duration << " MB/s" << std::endl;
+    };
+
+    {
+        std::wstring u16Out(u8Str.length(), L'\0');
+        GetDuration();
+        MultiByteToWideChar(CP_UTF8, 0, u8Str.data(), static_cast<int>(u8Str.length()), u16Out.data(), static_cast<int>(u16Out.length()));
+        report("MultiByteToWideChar", GetDuration());
+    }
+    {
+        std::wstring u16Out{};
+        GetDuration();
+        THROW_IF_FAILED(til::u8u16(u8Str, u16Out));
+        report("til::u8u16", GetDuration());
+    }
+    {
+        std::wstring u16Out{};
+        til::u8state state{};
+        GetDuration();
+        for (size_t idx = 0u; idx < u8Str.length(); idx += chunkSize)
+        {
+            THROW_IF_FAILED(til::u8u16(std::string_view{ u8Str }.substr(idx, chunkSize), u16Out, state));
+        }
+        report("til::u8u16 (4 KiB chunks)", GetDuration());
+    }
+    {
+        std::string u8Out(u16Str.length() * 3, '\0');
+        GetDuration();
+        WideCharToMultiByte(CP_UTF8, 0, u16Str.data(), static_cast<int>(u16Str.length()), u8Out.data(), static_cast<int>(u8Out.length()), nullptr, nullptr);
+        report("WideCharToMultiByte", GetDuration());
+    }
+    {
+        std::string u8Out{};
+        GetDuration();
+        THROW_IF_FAILED(til::u16u8(u16Str, u8Out));
+        report("til::u16u8", GetDuration());
+    }
+    {
+        std::string u8Out{};
+        til::u16state state{};
+        GetDuration();
+        for (size_t idx = 0u; idx < u16Str.length(); idx += chunkSize)
+        {
+            THROW_IF_FAILED(til::u16u8(std::wstring_view{ u16Str }.substr(idx, chunkSize), u8Out, state));
+        }
+        report("til::u16u8 (4 KiB chunks)", GetDuration());
+    }
+}
+
 int main()
 {
     // UTF-16 string length
@@ -519,6 +589,13 @@ int main()
     CompNaturalLang_Chunks("ru.txt");
     CompNaturalLang_Chunks("zh.txt");
 
+    std::cout << "\n\n### Throughput ###" << std::endl;
+
+    Throughput_NaturalLang("en.txt");
+    Throughput_NaturalLang("fr.txt");
+    Throughput_NaturalLang("ru.txt");
+    Throughput_NaturalLang("zh.txt");
+
     FreeLibrary(ntdll);
     return 0;
 }
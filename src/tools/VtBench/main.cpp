@@ -0,0 +1,566 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// Measures the throughput of the VT parser and the text buffer without a window, a PTY or a renderer.
+// The StateMachine, OutputStateMachineEngine, AdaptDispatch and TextBuffer are hooked up to a minimal
+// ITerminalApi implementation and a DummyRenderer. The input is fed in 4KB pieces, like ConptyConnection does.
+//
+// Without arguments it runs a set of built-in, synthetic workloads. Otherwise each argument is
+// the path to a recorded VT stream (for instance the output of `script`), which is replayed as-is.
+//
+// For each workload it reports the best of a couple iterations in:
+// * MB/s: UTF-8 input bytes per second
+// * rows/s: rows of output per second (line feeds for recordings, rows covered by each operation for "rect ops")
+// * allocs/MB: calls to operator new per MB of input
+
+#include "precomp.h"
+
+#include <chrono>
+#include <fstream>
+
+#include "../../renderer/inc/DummyRenderer.hpp"
+#include "../../terminal/adapter/adaptDispatch.hpp"
+#include "../../terminal/parser/OutputStateMachineEngine.hpp"
+#include "../../terminal/parser/stateMachine.hpp"
+
+using namespace Microsoft::Console::VirtualTerminal;
+
+namespace
+{
+    std::atomic<size_t> allocationCount;
+}
+
+// Every allocation in the process goes through these, which lets us count them.
+void* operator new(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (const auto p = malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+namespace
+{
+    constexpr til::CoordType columns = 120;
+    constexpr til::CoordType rows = 30;
+    constexpr til::CoordType scrollback = 9001;
+    constexpr til::size defaultViewportSize{ columns, rows };
+    // In wchar_t, before the conversion to UTF-8. Large enough to not fit into the L2 cache, like a real `cat` of a large file.
+    constexpr size_t corpusSize = 16 * 1024 * 1024;
+    constexpr size_t chunkSize = 4096;
+    constexpr int iterations = 5;
+
+    // The bare minimum to run AdaptDispatch: A text buffer and a viewport at the bottom of it.
+    class HeadlessTerminal final : public ITerminalApi
+    {
+    public:
+        explicit HeadlessTerminal(const til::size viewportSize) :
+            _textBuffer{ til::size{ viewportSize.width, viewportSize.height + scrollback }, TextAttribute{}, 0, false, _renderer },
+            _viewportSize{ viewportSize }
+        {
+            auto dispatch = std::make_unique<AdaptDispatch>(*this, _renderer, _renderer._renderSettings, _terminalInput);
+            auto engine = std::make_unique<OutputStateMachineEngine>(std::move(dispatch));
+            _stateMachine = std::make_unique<StateMachine>(std::move(engine));
+        }
+
+        void ProcessStringUtf8(const std::string_view string)
+        {
+            _stateMachine->ProcessStringUtf8(string);
+        }
+
+        void ReturnResponse(const std::wstring_view) override
+        {
+        }
+
+        StateMachine& GetStateMachine() override
+        {
+            return *_stateMachine;
+        }
+
+        TextBuffer& GetTextBuffer() override
+        {
+            return _textBuffer;
+        }
+
+        til::rect GetViewport() const override
+        {
+            return { 0, _viewportTop, _viewportSize.width, _viewportTop + _viewportSize.height };
+        }
+
+        void SetViewportPosition(const til::point position) override
+        {
+            _viewportTop = position.y;
+        }
+
+        bool IsVtInputEnabled() const override
+        {
+            return false;
+        }
+
+        void SetTextAttributes(const TextAttribute& attrs) override
+        {
+            _textBuffer.SetCurrentAttributes(attrs);
+        }
+
+        void SetSystemMode(const Mode mode, const bool enabled) override
+        {
+            _systemMode.set(mode, enabled);
+        }
+
+        bool GetSystemMode(const Mode mode) const override
+        {
+            return _systemMode.test(mode);
+        }
+
+        void WarningBell() override
+        {
+        }
+
+        void SetWindowTitle(const std::wstring_view) override
+        {
+        }
+
+        void UseAlternateScreenBuffer(const TextAttribute&) override
+        {
+        }
+
+        void UseMainScreenBuffer() override
+        {
+        }
+
+        CursorType GetUserDefaultCursorStyle() const override
+        {
+            return CursorType::Legacy;
+        }
+
+        void ShowWindow(bool) override
+        {
+        }
+
+        void SetConsoleOutputCP(const unsigned int) override
+        {
+        }
+
+        unsigned int GetConsoleOutputCP() const override
+        {
+            return CP_UTF8;
+        }
+
+        void CopyToClipboard(const std::wstring_view) override
+        {
+        }
+
+        void SetTaskbarProgress(const DispatchTypes::TaskbarState, const size_t) override
+        {
+        }
+
+        void SetWorkingDirectory(const std::wstring_view) override
+        {
+        }
+
+        void PlayMidiNote(const int, const int, const std::chrono::microseconds) override
+        {
+        }
+
+        bool ResizeWindow(const til::CoordType, const til::CoordType) override
+        {
+            return false;
+        }
+
+        bool IsConsolePty() const override
+        {
+            return false;
+        }
+
+        void NotifyAccessibilityChange(const til::rect&) override
+        {
+        }
+
+        void NotifyBufferRotation(const int) override
+        {
+        }
+
+        void MarkPrompt(const ScrollMark&) override
+        {
+        }
+
+        void MarkCommandStart() override
+        {
+        }
+
+        void MarkOutputStart() override
+        {
+        }
+
+        void MarkCommandFinish(std::optional<unsigned int>) override
+        {
+        }
+
+        void InvokeCompletions(std::wstring_view, unsigned int) override
+        {
+        }
+
+    private:
+        DummyRenderer _renderer;
+        TerminalInput _terminalInput;
+        TextBuffer _textBuffer;
+        std::unique_ptr<StateMachine> _stateMachine;
+        til::enumset<Mode> _systemMode{ Mode::AutoWrap };
+        til::size _viewportSize;
+        til::CoordType _viewportTop = 0;
+    };
+
+    struct Corpus
+    {
+        std::wstring name;
+        std::string utf8;
+        size_t rows = 0;
+        til::size viewportSize = defaultViewportSize;
+    };
+
+    // Calls appendLines until the text is large enough. It returns the number of rows of output it appended.
+    Corpus generate(const wchar_t* name, auto&& appendLines)
+    {
+        std::wstring text;
+        size_t rowCount = 0;
+        text.reserve(corpusSize + 64 * 1024);
+        for (size_t i = 0; text.size() < corpusSize; ++i)
+        {
+            rowCount += appendLines(text, i);
+        }
+        return { name, til::u16u8(text), rowCount };
+    }
+
+    // `cat` of a server log: Long, plain ASCII lines.
+    Corpus generateAscii()
+    {
+        return generate(L"ascii", [](std::wstring& text, size_t i) {
+            fmt::format_to(
+                std::back_inserter(text),
+                FMT_COMPILE(L"2024-03-{:02}T{:02}:{:02}:{:02}.{:03}Z INFO  [worker-{}] GET /api/v1/items/{} -> 200 OK in {}ms\r\n"),
+                i / 86400 % 28 + 1,
+                i / 3600 % 24,
+                i / 60 % 60,
+                i % 60,
+                i * 7 % 1000,
+                i % 8,
+                i * 2654435761 % 100000,
+                i % 97);
+            return 1;
+        });
+    }
+
+    // Syntax highlighted source code: A few characters of text between each 16-color, 256-color and RGB SGR sequence.
+    Corpus generateSgr()
+    {
+        static constexpr std::wstring_view words[]{ L"const", L"auto", L"value", L"=", L"std::min(", L"width,", L"height);", L"// clamp" };
+
+        return generate(L"sgr", [](std::wstring& text, size_t i) {
+            for (size_t j = 0; j < 8; ++j)
+            {
+                const auto k = i * 8 + j;
+                switch (k % 3)
+                {
+                case 0:
+                    fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[{}m"), 30 + k % 8);
+                    break;
+                case 1:
+                    fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[38;5;{}m"), k % 256);
+                    break;
+                default:
+                    fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[1;38;2;{};{};{}m"), k * 31 % 256, k * 71 % 256, k * 113 % 256);
+                    break;
+                }
+                text.append(words[k % std::size(words)]);
+                text.append(L"\x1b[m ");
+            }
+            text.append(L"\r\n");
+            return 1;
+        });
+    }
+
+    // CJK text: Lines of wide glyphs, which take the slower, non-ASCII paths for measuring and writing text.
+    Corpus generateCjk()
+    {
+        return generate(L"cjk", [](std::wstring& text, size_t i) {
+            for (size_t j = 0; j < 50; ++j)
+            {
+                text.push_back(static_cast<wchar_t>(0x4E00 + (i * 50 + j) * 7919 % 0x5000));
+                if (j % 10 == 9)
+                {
+                    text.append(L", ");
+                }
+            }
+            text.append(L"\r\n");
+            return 1;
+        });
+    }
+
+    // Chat logs: Emoji with modifiers, flags and ZWJ sequences, which are made up of many code points per cluster.
+    Corpus generateEmoji()
+    {
+        static constexpr std::wstring_view clusters[]{
+            L"\U0001F600",
+            L"\U0001F44D\U0001F3FD",
+            L"\U0001F469\u200D\U0001F4BB",
+            L"\U0001F468\u200D\U0001F469\u200D\U0001F467\u200D\U0001F466",
+            L"\U0001F3F3\uFE0F\u200D\U0001F308",
+            L"\U0001F1E9\U0001F1EA",
+            L"\u2764\uFE0F",
+        };
+
+        return generate(L"emoji", [](std::wstring& text, size_t i) {
+            fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"<user{}> sounds good "), i % 16);
+            for (size_t j = 0; j < 12; ++j)
+            {
+                text.append(clusters[(i + j * 3) % std::size(clusters)]);
+            }
+            text.append(L"\r\n");
+            return 1;
+        });
+    }
+
+    // Full screen applications like htop or vim: Every frame repaints the entire viewport with absolute cursor positioning.
+    Corpus generateTui()
+    {
+        return generate(L"tui", [](std::wstring& text, size_t frame) {
+            text.append(L"\x1b[?25l\x1b[H");
+            for (til::CoordType y = 1; y <= rows; ++y)
+            {
+                const auto cpu = (frame * 37 + y * 11) % 100;
+                fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[{};1H\x1b[{}m{:>6} root      20   0 {:>8} {:>6} S \x1b[1m{:>5}.{}\x1b[22m"), y, y == 1 ? 7 : 0, 1000 + y, frame * 4096 % 999999, y * 1337 % 99999, cpu, frame % 10);
+                fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"  {:02}:{:02}.{:02} /usr/bin/process-{}\x1b[K\x1b[m"), frame / 6000 % 60, frame / 100 % 60, frame % 100, y);
+            }
+            fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[{};1H\x1b[?25h"), rows);
+            return gsl::narrow_cast<size_t>(rows);
+        });
+    }
+
+    // Pagers and log viewers with a status bar: Scrolling inside DECSTBM margins, up and down.
+    Corpus generateScrollRegion()
+    {
+        return generate(L"scroll region", [](std::wstring& text, size_t i) {
+            // Set the margins to all but the first and last 2 rows, and scroll them 20 rows up and 5 rows down.
+            fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[3;{}r\x1b[{};1H"), rows - 2, rows - 2);
+            for (size_t j = 0; j < 20; ++j)
+            {
+                fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\n\r\x1b[32m{:>6}\x1b[m  scrolling line {} of the region"), i * 20 + j, j);
+            }
+            text.append(L"\x1b[3;1H");
+            for (size_t j = 0; j < 5; ++j)
+            {
+                text.append(L"\x1bM\x1b[7mreverse scroll\x1b[m");
+            }
+            fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[r\x1b[{};1H\x1b[7m status: {} \x1b[K\x1b[m"), rows, i);
+            return size_t{ 25 };
+        });
+    }
+
+    // `ls --hyperlink` or compiler output with clickable paths: A new OSC 8 hyperlink on each of 100k lines, which
+    // all scroll out of the buffer eventually. Each time they do, the buffer checks if the hyperlink is still in use.
+    Corpus generateHyperlinks()
+    {
+        static constexpr size_t lineCount = 100000;
+        std::wstring text;
+
+        for (size_t i = 0; i < lineCount; ++i)
+        {
+            fmt::format_to(
+                std::back_inserter(text),
+                FMT_COMPILE(L"\x1b]8;;file:///C:/src/module{0}/file{1}.cpp\x1b\\src/module{0}/file{1}.cpp\x1b]8;;\x1b\\:{2}:{3}: warning: unused variable 'x'\r\n"),
+                i % 13,
+                i,
+                i % 2000 + 1,
+                i % 80 + 1);
+        }
+
+        return { L"hyperlinks", til::u16u8(text), lineCount };
+    }
+
+    // Split panes in tmux or vim: Scrolling a 200x60 region inside DECSTBM and DECSLRM margins, up and down.
+    // Since the margins don't span the full width, the rows can't simply be rotated. Each scroll copies a row segment per row.
+    Corpus generateMarginScroll()
+    {
+        static constexpr til::CoordType left = 11;
+        static constexpr til::CoordType right = left + 199;
+        static constexpr til::CoordType top = 3;
+        static constexpr til::CoordType bottom = top + 59;
+
+        auto corpus = generate(L"margin scroll", [](std::wstring& text, size_t i) {
+            if (i == 0)
+            {
+                fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[?69h\x1b[{};{}r\x1b[{};{}s"), top, bottom, left, right);
+            }
+            fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[{};{}H"), bottom, left);
+            for (size_t j = 0; j < 20; ++j)
+            {
+                fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\n\r\x1b[32m{:>6}\x1b[m {:\u2500<192}"), i * 20 + j, L"");
+            }
+            fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[{};{}H"), top, left);
+            for (size_t j = 0; j < 5; ++j)
+            {
+                text.append(L"\x1bM\x1b[7mreverse scroll\x1b[m");
+            }
+            return size_t{ 25 };
+        });
+
+        corpus.viewportSize = { right + 10, bottom + 2 };
+        return corpus;
+    }
+
+    // vttest and esctest style rectangular area operations: DECCARA, DECRARA, DECSERA and DECRQCRA on a 300x100 rectangle
+    // filled with text whose attributes change every 10 columns. Every other run is protected, so DECSERA only erases half of it.
+    Corpus generateRectOps()
+    {
+        static constexpr til::CoordType width = 300;
+        static constexpr til::CoordType height = 100;
+        static constexpr size_t operationCount = 1000;
+        std::wstring text;
+
+        for (til::CoordType y = 0; y < height; ++y)
+        {
+            fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[{};1H"), y + 1);
+            for (til::CoordType x = 0; x < width; x += 10)
+            {
+                const auto run = x / 10 + y;
+                fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[{}m\x1b[{}\"q{:>10}"), 31 + run % 7, run % 2, x + y);
+            }
+        }
+
+        // DECSACE: Make DECCARA and DECRARA rectangular instead of stream-like.
+        text.append(L"\x1b[m\x1b[0\"q\x1b[2*x");
+        for (size_t i = 0; i < operationCount; ++i)
+        {
+            fmt::format_to(
+                std::back_inserter(text),
+                FMT_COMPILE(L"\x1b[1;1;{0};{1};1;4$r\x1b[1;1;{0};{1};4$t\x1b[1;1;{0};{1}${{\x1b[{2};1;1;1;{0};{1}*y"),
+                height,
+                width,
+                i);
+        }
+
+        return { L"rect ops", til::u16u8(text), operationCount * 4 * height, { width, height } };
+    }
+
+    Corpus loadRecording(const wchar_t* path)
+    {
+        std::ifstream file{ path, std::ios::binary };
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND), !file);
+
+        Corpus corpus{ path, std::string{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} } };
+        corpus.rows = static_cast<size_t>(std::count(corpus.utf8.begin(), corpus.utf8.end(), '\n'));
+        return corpus;
+    }
+
+    struct Result
+    {
+        double seconds = 0;
+        size_t allocations = 0;
+    };
+
+    // Returns the fastest out of a couple iterations and the number of allocations it made.
+    Result measure(const std::string& text, const til::size viewportSize)
+    {
+        using clock = std::chrono::steady_clock;
+        Result best{ .seconds = std::numeric_limits<double>::infinity() };
+
+        for (auto i = 0; i < iterations; ++i)
+        {
+            HeadlessTerminal terminal{ viewportSize };
+            std::string_view remaining{ text };
+
+            const auto allocationsBeg = allocationCount.load(std::memory_order_relaxed);
+            const auto beg = clock::now();
+
+            while (!remaining.empty())
+            {
+                const auto chunk = remaining.substr(0, chunkSize);
+                terminal.ProcessStringUtf8(chunk);
+                remaining = remaining.substr(chunk.size());
+            }
+
+            const auto seconds = std::chrono::duration<double>(clock::now() - beg).count();
+            const auto allocations = allocationCount.load(std::memory_order_relaxed) - allocationsBeg;
+
+            if (seconds < best.seconds)
+            {
+                best = { seconds, allocations };
+            }
+        }
+
+        return best;
+    }
+}
+
+int wmain(int argc, wchar_t** argv)
+try
+{
+    std::vector<Corpus> corpora;
+
+    if (argc > 1)
+    {
+        for (auto i = 1; i < argc; ++i)
+        {
+            corpora.emplace_back(loadRecording(argv[i]));
+        }
+    }
+    else
+    {
+        corpora.emplace_back(generateAscii());
+        corpora.emplace_back(generateSgr());
+        corpora.emplace_back(generateCjk());
+        corpora.emplace_back(generateEmoji());
+        corpora.emplace_back(generateTui());
+        corpora.emplace_back(generateScrollRegion());
+        corpora.emplace_back(generateHyperlinks());
+        corpora.emplace_back(generateMarginScroll());
+        corpora.emplace_back(generateRectOps());
+    }
+
+    wprintf(L"%-16s %10s %14s %12s\r\n", L"workload", L"MB/s", L"rows/s", L"allocs/MB");
+
+    for (const auto& corpus : corpora)
+    {
+        const auto result = measure(corpus.utf8, corpus.viewportSize);
+        const auto megabytes = static_cast<double>(corpus.utf8.size()) / 1e6;
+        wprintf(L"%-16s %10.1f %14.0f %12.1f\r\n",
+                corpus.name.c_str(),
+                megabytes / result.seconds,
+                static_cast<double>(corpus.rows) / result.seconds,
+                static_cast<double>(result.allocations) / megabytes);
+    }
+
+    return 0;
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return 1;
+}
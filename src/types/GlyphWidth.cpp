@@ -25,6 +25,30 @@ bool IsGlyphFullWidth(const wchar_t wch) noexcept
     return wch < 0x80 ? false : IsGlyphFullWidth({ &wch, 1 });
 }
 
+// Function Description:
+// - returns the end of the grapheme cluster that starts at offset and its width.
+//      See CodepointWidthDetector::GraphemeNext
+size_t GraphemeClusterNext(const std::wstring_view& text, const size_t offset, size_t& width) noexcept
+{
+    return widthDetector.GraphemeNext(text, offset, width);
+}
+
+// Function Description:
+// - returns the start of the grapheme cluster that precedes offset.
+//      See CodepointWidthDetector::GraphemePrev
+size_t GraphemeClusterPrev(const std::wstring_view& text, const size_t offset) noexcept
+{
+    return widthDetector.GraphemePrev(text, offset);
+}
+
+// Function Description:
+// - measures as many glyphs at the start of the text as fit into the given
+//      number of columns. See CodepointWidthDetector::FitIntoColumns
+size_t FitGlyphsIntoColumns(const std::wstring_view& text, const size_t columnLimit, size_t& columns) noexcept
+{
+    return widthDetector.FitIntoColumns(text, columnLimit, columns);
+}
+
 // Function Description:
 // - Sets a function that should be used by the global CodepointWidthDetector
 //      as the fallback mechanism for determining a particular glyph's width,
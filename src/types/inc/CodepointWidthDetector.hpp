@@ -21,6 +21,9 @@ class CodepointWidthDetector final
 public:
     CodepointWidth GetWidth(const std::wstring_view& glyph) noexcept;
     bool IsWide(const std::wstring_view& glyph) noexcept;
+    size_t GraphemeNext(const std::wstring_view& text, size_t offset, size_t& width) noexcept;
+    size_t GraphemePrev(const std::wstring_view& text, size_t offset) noexcept;
+    size_t FitIntoColumns(const std::wstring_view& text, size_t columnLimit, size_t& columns) noexcept;
     void SetFallbackMethod(std::function<bool(const std::wstring_view&)> pfnFallback) noexcept;
     void NotifyFontChanged() noexcept;
 
@@ -29,7 +32,7 @@ public:
 #endif
 
 private:
-    uint8_t _lookupGlyphWidth(char32_t codepoint, const std::wstring_view& glyph) noexcept;
+    const wchar_t* _graphemeNext(const wchar_t* it, const wchar_t* end, size_t& width) noexcept;
     uint8_t _checkFallbackViaCache(char32_t codepoint, const std::wstring_view& glyph) noexcept;
 
     std::unordered_map<char32_t, uint8_t> _fallbackCache;
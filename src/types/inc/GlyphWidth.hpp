@@ -17,5 +17,8 @@ Abstract:
 
 bool IsGlyphFullWidth(const std::wstring_view& glyph) noexcept;
 bool IsGlyphFullWidth(const wchar_t wch) noexcept;
+size_t GraphemeClusterNext(const std::wstring_view& text, size_t offset, size_t& width) noexcept;
+size_t GraphemeClusterPrev(const std::wstring_view& text, size_t offset) noexcept;
+size_t FitGlyphsIntoColumns(const std::wstring_view& text, size_t columnLimit, size_t& columns) noexcept;
 void SetGlyphWidthFallback(std::function<bool(const std::wstring_view&)> pfnFallback) noexcept;
 void NotifyGlyphWidthFontChanged() noexcept;
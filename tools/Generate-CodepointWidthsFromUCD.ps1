@@ -21,7 +21,11 @@
 # extremely rare occasion that we should need to regenerate our table.
 #
 # Invoke this script from the root of this repository as:
-#   .\tools\Generate-CodepointWidthsFromUCD.ps1 -Path .\path\to\ucd.nounihan.flat.xml -OverridePath .\src\types\unicode_width_overrides.xml -Pack
+#   .\tools\Generate-CodepointWidthsFromUCD.ps1 -Path .\path\to\ucd.nounihan.flat.xml -OverridePath .\src\types\unicode_width_overrides.xml -Pack -TwoStage
+#
+# With -TwoStage it emits the two-stage table of widths and grapheme cluster break
+# properties used by CodepointWidthDetector, instead of the list of ranges. The ranges
+# are easier to review, so it helps to generate both when updating to a new version of Unicode.
 #
 # [1]: https://www.unicode.org/Public/UCD/latest/ucdxml/
 # [2]: https://www.unicode.org/reports/tr42/
@@ -43,7 +47,8 @@ Param(
     [string]$OverridePath = "overrides.xml",
 
     [switch]$Pack, # Pack tightly based on width
-    [switch]$NoOverrides # Do not include overrides
+    [switch]$NoOverrides, # Do not include overrides
+    [switch]$TwoStage # Emit a two-stage lookup table instead of ranges
 )
 
 Enum CodepointWidth {
@@ -255,14 +260,65 @@ ForEach($_ in $ranges) {
     $c += $_.End - $_.Start + 1
 }
 
+Function Out-ByteArray($name, $values) {
+"    static constexpr std::array<uint8_t, {0}> {1}{{" -f $values.Count, $name
+    For($i = 0; $i -lt $values.Count; $i += 32) {
+        $line = $values[$i..([Math]::Min($i + 32, $values.Count) - 1)] | ForEach-Object { "0x{0:x2}," -f $_ }
+"        {0}" -f ($line -join " ")
+    }
+"    };"
+}
+
 # Emit Code
-"    // Generated by {0} -Pack:{1} -Full:{2} -NoOverrides:{3}" -f $MyInvocation.MyCommand.Name, $Pack, $Full, $NoOverrides
+"    // Generated by {0} -Pack:{1} -Full:{2} -NoOverrides:{3} -TwoStage:{4}" -f $MyInvocation.MyCommand.Name, $Pack, $Full, $NoOverrides, $TwoStage
 "    // on {0} from {1}." -f (Get-Date -AsUTC -Format "u"), $InputObject.ucd.description
 "    // {0} (0x{0:X}) codepoints covered." -f $c
 If (-not $NoOverrides) {
 "    // {0} (0x{0:X}) codepoints overridden." -f $overrideCount
 "    // Override path: {0}" -f $OverridePath
 }
+
+If ($TwoStage) {
+    # The C++ GraphemeClass enum: The Grapheme_Cluster_Break property, with Extended_Pictographic folded into it.
+    $graphemeClasses = @{ XX = 0; CR = 1; LF = 2; CN = 3; EX = 4; ZWJ = 5; RI = 6; PP = 7; SM = 8; L = 9; V = 10; T = 11; LV = 12; LVT = 13 }
+    $extendedPictographic = 14
+
+    # 1 byte per codepoint: The grapheme class in the upper 6 bits and the numeric value
+    # of the C++ CodepointWidth enum in the lower 2 bits: 0 = ambiguous, 1 = narrow, 2 = wide.
+    $properties = [byte[]]::new(0x110000)
+    [Array]::Fill($properties, [byte]1)
+    ForEach($v in $UCDRepertoire) {
+        $s, $e = Get-UCDEntryRange $v
+        $class = $v.ExtPict -eq "Y" ? $extendedPictographic : $graphemeClasses[$v.GCB]
+        [Array]::Fill($properties, [byte](($class -shl 2) -bor 1), $s, $e - $s + 1)
+    }
+    ForEach($_ in $ranges) {
+        $width = $_.Width -eq [CodepointWidth]::Ambiguous ? 0 : 2
+        For($i = $_.Start; $i -le $_.End; $i++) {
+            $properties[$i] = ($properties[$i] -band 0xfc) -bor $width
+        }
+    }
+
+    # Stage 1 maps each block of 256 codepoints to a deduplicated block in stage 2.
+    $blocks = @{}
+    $stage1 = [System.Collections.Generic.List[int]]::new()
+    $stage2 = [System.Collections.Generic.List[int]]::new()
+    For($block = 0; $block -lt 0x1100; $block++) {
+        $bytes = [byte[]]::new(256)
+        [Array]::Copy($properties, $block * 256, $bytes, 0, 256)
+        $key = [Convert]::ToHexString($bytes)
+        If (-not $blocks.ContainsKey($key)) {
+            $blocks[$key] = $blocks.Count
+            $stage2.AddRange([int[]]$bytes)
+        }
+        $stage1.Add($blocks[$key])
+    }
+
+    Out-ByteArray "s_stage1" $stage1
+    Out-ByteArray "s_stage2" $stage2
+    Return
+}
+
 "    static constexpr std::array<UnicodeRange, {0}> s_wideAndAmbiguousTable{{" -f $ranges.Count
 ForEach($_ in $ranges) {
     $isAmbiguous = $_.Width -eq [CodepointWidth]::Ambiguous